@@ -0,0 +1,535 @@
+#include "Aggregation.h"
+#include "Diagnostics.h"
+#include "ThreadPool.h"
+#include "Hashing.h"
+#include "Memory.h"
+#include "Instrumentation.h"
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace {
+    template<typename T>
+    void putKey(std::string &key, T value) {
+        key.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    T takeKey(const char *&cursor) {
+        T value;
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+
+    // Sumy liczb całkowitych liczone modulo 2^64 (bez niezdefiniowanego przepełnienia)
+    int64_t wrappingAdd(int64_t left, int64_t right) {
+        return static_cast<int64_t>(static_cast<uint64_t>(left) + static_cast<uint64_t>(right));
+    }
+
+    template<typename T>
+    void accumulateValue(AggregateState &state, AggregateFunction function, T value) {
+        T &current = [&state]() -> T & {
+            if constexpr (std::is_same_v<T, int64_t>) {
+                return state.intValue;
+            } else {
+                return state.floatValue;
+            }
+        }();
+        switch (function) {
+            case AggregateFunction::COUNT:
+                break;
+            case AggregateFunction::SUM:
+            case AggregateFunction::AVG:
+                if constexpr (std::is_same_v<T, int64_t>) {
+                    current = wrappingAdd(current, value);
+                } else {
+                    current += value;
+                }
+                break;
+            case AggregateFunction::MIN:
+                if (state.count == 0 || value < current) {
+                    current = value;
+                }
+                break;
+            case AggregateFunction::MAX:
+                if (state.count == 0 || value > current) {
+                    current = value;
+                }
+                break;
+        }
+        ++state.count;
+    }
+
+    // Pełne słowo bitmapy (64 wiersze bez NULL-i, wszystkie wybrane): pętle bez rozgałęzień
+    template<typename T>
+    void accumulateDense(AggregateState &state, AggregateFunction function, const T *values) {
+        if (function == AggregateFunction::COUNT) {
+            state.count += 64;
+            return;
+        }
+        if (function == AggregateFunction::SUM || function == AggregateFunction::AVG) {
+            T sum = 0;
+            for (int i = 0; i < 64; ++i) {
+                if constexpr (std::is_same_v<T, int64_t>) {
+                    sum = wrappingAdd(sum, values[i]);
+                } else {
+                    sum += values[i];
+                }
+            }
+            accumulateValue(state, function, sum);
+            state.count += 63;
+            return;
+        }
+        T best = values[0];
+        for (int i = 1; i < 64; ++i) {
+            best = function == AggregateFunction::MIN ? std::min(best, values[i]) : std::max(best, values[i]);
+        }
+        accumulateValue(state, function, best);
+        state.count += 63;
+    }
+
+    // MIN/MAX napisów: w stanie numer wiersza, porównanie napisów jak w ORDER BY
+    bool stringBefore(const ColumnData &column, size_t row, size_t best, AggregateFunction function) {
+        int order = column.getString(row).compare(column.getString(best));
+        return function == AggregateFunction::MIN ? order < 0 : order > 0;
+    }
+
+    void accumulateString(AggregateState &state, AggregateFunction function, const ColumnData &column, size_t row) {
+        if (function != AggregateFunction::COUNT
+            && (state.count == 0 || stringBefore(column, row, static_cast<size_t>(state.intValue), function))) {
+            state.intValue = static_cast<int64_t>(row);
+        }
+        ++state.count;
+    }
+
+    // column - kolumna wejściowa agregatu (potrzebna tylko dla napisów)
+    void combineState(AggregateState &target, const AggregateState &source, AggregateFunction function,
+                      const ColumnData *column) {
+        if (source.count == 0) {
+            return;
+        }
+        DataType type = column != nullptr ? column->getType() : DataType::INT;
+        bool useSource = target.count == 0;
+        switch (function) {
+            case AggregateFunction::COUNT:
+                break;
+            case AggregateFunction::SUM:
+            case AggregateFunction::AVG:
+                target.intValue = wrappingAdd(target.intValue, source.intValue);
+                target.floatValue += source.floatValue;
+                break;
+            case AggregateFunction::MIN:
+            case AggregateFunction::MAX:
+                if (useSource) {
+                    break;
+                }
+                if (type == DataType::STRING) {
+                    useSource = stringBefore(*column, static_cast<size_t>(source.intValue),
+                                             static_cast<size_t>(target.intValue), function);
+                } else if (function == AggregateFunction::MIN) {
+                    useSource = type == DataType::INT ? source.intValue < target.intValue
+                                                      : source.floatValue < target.floatValue;
+                } else {
+                    useSource = type == DataType::INT ? source.intValue > target.intValue
+                                                      : source.floatValue > target.floatValue;
+                }
+                break;
+        }
+        if (useSource && (function == AggregateFunction::MIN || function == AggregateFunction::MAX)) {
+            target.intValue = source.intValue;
+            target.floatValue = source.floatValue;
+        }
+        target.count += source.count;
+    }
+
+    DataType resultType(AggregateFunction function, DataType columnType) {
+        switch (function) {
+            case AggregateFunction::COUNT:
+                return DataType::INT;
+            case AggregateFunction::AVG:
+                return DataType::FLOAT;
+            default:
+                return columnType;
+        }
+    }
+
+    void appendResult(ColumnData &column, const AggregateState &state, AggregateFunction function,
+                      const ColumnData *input) {
+        DataType type = input != nullptr ? input->getType() : DataType::INT;
+        if (function == AggregateFunction::COUNT) {
+            column.appendInt(state.count);
+        } else if (state.count == 0) {
+            column.appendNull();
+        } else if (type == DataType::STRING) {
+            column.appendString(input->getString(static_cast<size_t>(state.intValue)));
+        } else if (function == AggregateFunction::AVG) {
+            double sum = type == DataType::INT ? static_cast<double>(state.intValue) : state.floatValue;
+            column.appendFloat(sum / static_cast<double>(state.count));
+        } else if (type == DataType::INT) {
+            column.appendInt(state.intValue);
+        } else {
+            column.appendFloat(state.floatValue);
+        }
+    }
+}
+
+GroupHashTable::GroupHashTable(size_t statesPerGroup) : width(statesPerGroup), slots(1024, {0, EMPTY_SLOT}) {
+    keyOffsets.push_back(0);
+}
+
+uint32_t GroupHashTable::findOrInsert(std::string_view key, uint64_t hash) {
+    uint32_t tag = static_cast<uint32_t>(hash >> 32);
+    size_t mask = slots.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        Slot &candidate = slots[slot];
+        if (candidate.group == EMPTY_SLOT) {
+            uint32_t group = static_cast<uint32_t>(hashes.size());
+            candidate = {tag, group};
+            hashes.push_back(hash);
+            keyBytes.insert(keyBytes.end(), key.begin(), key.end());
+            keyOffsets.push_back(keyBytes.size());
+            stateData.resize(stateData.size() + width);
+            if (hashes.size() * 10 > slots.size() * 7) {
+                grow();
+            }
+            return group;
+        }
+        if (candidate.tag == tag && this->key(candidate.group) == key) {
+            return candidate.group;
+        }
+    }
+}
+
+void GroupHashTable::grow() {
+    std::vector<Slot> larger(slots.size() * 2, {0, EMPTY_SLOT});
+    size_t mask = larger.size() - 1;
+    for (uint32_t group = 0; group < hashes.size(); ++group) {
+        size_t slot = hashes[group] & mask;
+        while (larger[slot].group != EMPTY_SLOT) {
+            slot = (slot + 1) & mask;
+        }
+        larger[slot] = {static_cast<uint32_t>(hashes[group] >> 32), group};
+    }
+    slots = std::move(larger);
+}
+
+bool HashAggregator::parseAggregate(const std::string &item, AggregateFunction &function, std::string &column) {
+    size_t open = item.find('(');
+    if (open == std::string::npos || item.back() != ')') {
+        return false;
+    }
+    std::string name = item.substr(0, open);
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::toupper(c); });
+    static const std::pair<const char *, AggregateFunction> functions[] = {
+            {"COUNT", AggregateFunction::COUNT}, {"SUM", AggregateFunction::SUM}, {"MIN", AggregateFunction::MIN},
+            {"MAX", AggregateFunction::MAX}, {"AVG", AggregateFunction::AVG}};
+    for (const auto &candidate : functions) {
+        if (name == candidate.first) {
+            function = candidate.second;
+            column = item.substr(open + 1, item.size() - open - 2);
+            return !column.empty();
+        }
+    }
+    return false;
+}
+
+bool HashAggregator::prepare(const Table &source, const std::vector<int> &groups,
+                             const std::vector<AggregateSpec> &aggregates) {
+    for (const auto &spec : aggregates) {
+        if (spec.columnIndex < 0 && spec.function != AggregateFunction::COUNT) {
+            errorStream() << "Aggregate " << spec.name << " needs a column." << std::endl;
+            return false;
+        }
+        if (spec.columnIndex >= 0 && (spec.function == AggregateFunction::SUM || spec.function == AggregateFunction::AVG)
+            && source.data[spec.columnIndex].getType() == DataType::STRING) {
+            errorStream() << "Aggregate " << spec.name << " needs a numeric column." << std::endl;
+            return false;
+        }
+    }
+    table = &source;
+    groupColumns = groups;
+    specs = aggregates;
+    unsigned lanes = ThreadPool::shared().concurrency();
+    if (groupColumns.empty()) {
+        ungroupedPartials.assign(lanes, std::vector<AggregateState>(specs.size()));
+    } else {
+        partials.resize(lanes);
+    }
+    return true;
+}
+
+GroupHashTable &HashAggregator::partial(unsigned lane) {
+    if (!partials[lane]) {
+        partials[lane] = std::make_unique<GroupHashTable>(specs.size());
+    }
+    return *partials[lane];
+}
+
+void HashAggregator::encodeKey(size_t row, std::string &key) const {
+    // Na kolumnę: bajt NULL, potem wartość (INT/FLOAT 8 bajtów, STRING długość + znaki)
+    key.clear();
+    for (int columnIndex : groupColumns) {
+        const ColumnData &column = table->data[columnIndex];
+        bool null = column.isNull(row);
+        key += static_cast<char>(null);
+        if (null) {
+            continue;
+        }
+        switch (column.getType()) {
+            case DataType::INT:
+                putKey(key, column.getInt(row));
+                break;
+            case DataType::FLOAT: {
+                double value = column.getFloat(row);
+                if (value == 0.0) {
+                    value = 0.0; // -0.0 i 0.0 to ta sama grupa
+                } else if (std::isnan(value)) {
+                    value = std::numeric_limits<double>::quiet_NaN();
+                }
+                putKey(key, value);
+                break;
+            }
+            case DataType::STRING: {
+                std::string_view value = column.getString(row);
+                putKey(key, static_cast<uint32_t>(value.size()));
+                key.append(value);
+                break;
+            }
+        }
+    }
+}
+
+void HashAggregator::accumulateRow(AggregateState *states, size_t row) const {
+    for (size_t i = 0; i < specs.size(); ++i) {
+        const AggregateSpec &spec = specs[i];
+        if (spec.columnIndex < 0) {
+            ++states[i].count;
+            continue;
+        }
+        const ColumnData &column = table->data[spec.columnIndex];
+        if (column.isNull(row)) {
+            continue;
+        }
+        switch (column.getType()) {
+            case DataType::INT:
+                accumulateValue(states[i], spec.function, column.getInt(row));
+                break;
+            case DataType::FLOAT:
+                accumulateValue(states[i], spec.function, column.getFloat(row));
+                break;
+            case DataType::STRING:
+                accumulateString(states[i], spec.function, column, row);
+                break;
+        }
+    }
+}
+
+void HashAggregator::accumulateWords(AggregateState *states, size_t firstRow, size_t count,
+                                     const uint64_t *selection) const {
+    size_t words = (count + 63) / 64;
+    for (size_t i = 0; i < specs.size(); ++i) {
+        const AggregateSpec &spec = specs[i];
+        const ColumnData *column = spec.columnIndex >= 0 ? &table->data[spec.columnIndex] : nullptr;
+        for (size_t word = 0; word < words; ++word) {
+            uint64_t valid = ~uint64_t(0);
+            if (selection != nullptr) {
+                valid = selection[word];
+            } else if (word + 1 == words && (count & 63)) {
+                valid = (uint64_t(1) << (count & 63)) - 1;
+            }
+            if (column != nullptr) {
+                valid &= ~column->nullData()[firstRow / 64 + word];
+            }
+            if (column == nullptr || spec.function == AggregateFunction::COUNT) {
+                states[i].count += std::popcount(valid);
+                continue;
+            }
+            size_t base = firstRow + word * 64;
+            if (column->getType() == DataType::STRING) {
+                for (; valid; valid &= valid - 1) {
+                    accumulateString(states[i], spec.function, *column, base + static_cast<size_t>(std::countr_zero(valid)));
+                }
+                continue;
+            }
+            if (valid == ~uint64_t(0)) {
+                if (column->getType() == DataType::INT) {
+                    accumulateDense(states[i], spec.function, column->intData() + base);
+                } else {
+                    accumulateDense(states[i], spec.function, column->floatData() + base);
+                }
+                continue;
+            }
+            while (valid) {
+                size_t row = base + static_cast<size_t>(std::countr_zero(valid));
+                if (column->getType() == DataType::INT) {
+                    accumulateValue(states[i], spec.function, column->getInt(row));
+                } else {
+                    accumulateValue(states[i], spec.function, column->getFloat(row));
+                }
+                valid &= valid - 1;
+            }
+        }
+    }
+}
+
+void HashAggregator::consumeScan(const Predicate &predicate) {
+    std::atomic<size_t> skipped{0};
+    std::atomic<size_t> scanned{0};
+    // Strony przypinane dla kolumn warunku, grupowania i agregatów
+    std::vector<const ColumnData *> columns = predicate.columns();
+    auto addColumn = [&](int columnIndex) {
+        if (columnIndex < 0) {
+            return;
+        }
+        const ColumnData *column = &table->data[columnIndex];
+        if (std::find(columns.begin(), columns.end(), column) == columns.end()) {
+            columns.push_back(column);
+        }
+    };
+    for (int columnIndex : groupColumns) {
+        addColumn(columnIndex);
+    }
+    for (const auto &spec : specs) {
+        addColumn(spec.columnIndex);
+    }
+    size_t readahead = ThreadPool::MORSEL_ROWS * ThreadPool::shared().concurrency();
+    ThreadPool::shared().forEachMorsel(table->rowCount, [&](size_t, size_t firstRow, size_t count, unsigned lane) {
+        if (!predicate.mayMatch(firstRow, count)) {
+            skipped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        scanned.fetch_add(count, std::memory_order_relaxed);
+        PageGuard pages;
+        pinScanMorsel(columns, firstRow, count, firstRow + readahead, pages);
+        Arena &arena = Arena::local();
+        Arena::Scope scope(arena);
+        size_t words = (count + 63) / 64;
+        uint64_t *bits = nullptr;
+        if (!predicate.empty() || table->deletedCount > 0) {
+            bits = arena.allocateArray<uint64_t>(words);
+            predicate.evaluate(firstRow, count, bits);
+            table->maskDeleted(firstRow, count, bits);
+        }
+        if (groupColumns.empty()) {
+            accumulateWords(ungroupedPartials[lane].data(), firstRow, count, bits);
+            return;
+        }
+        GroupHashTable &groups = partial(lane);
+        std::string key;
+        auto visit = [&](size_t row) {
+            encodeKey(row, key);
+            accumulateRow(groups.states(groups.findOrInsert(key, hashBytes(key))), row);
+        };
+        if (bits == nullptr) {
+            for (size_t row = firstRow; row < firstRow + count; ++row) {
+                visit(row);
+            }
+        } else {
+            forEachSelected(bits, words, [&](size_t offset) { visit(firstRow + offset); });
+        }
+    });
+    if (QueryProfile *profile = QueryProfile::active()) {
+        profile->blocksSkipped += skipped;
+        profile->rowsScanned += scanned;
+    }
+}
+
+void HashAggregator::consumeRows(const std::vector<uint32_t> &rows) {
+    ThreadPool::shared().forEachMorsel(rows.size(), [&](size_t, size_t first, size_t count, unsigned lane) {
+        std::string key;
+        for (size_t i = first; i < first + count; ++i) {
+            if (groupColumns.empty()) {
+                accumulateRow(ungroupedPartials[lane].data(), rows[i]);
+                continue;
+            }
+            GroupHashTable &groups = partial(lane);
+            encodeKey(rows[i], key);
+            accumulateRow(groups.states(groups.findOrInsert(key, hashBytes(key))), rows[i]);
+        }
+    });
+}
+
+std::vector<ColumnData> HashAggregator::finish() {
+    std::vector<ColumnData> columns;
+    for (int columnIndex : groupColumns) {
+        columns.emplace_back(table->data[columnIndex].getType());
+    }
+    std::vector<const ColumnData *> inputs;
+    for (const auto &spec : specs) {
+        inputs.push_back(spec.columnIndex >= 0 ? &table->data[spec.columnIndex] : nullptr);
+        columns.emplace_back(resultType(spec.function, inputs.back() != nullptr ? inputs.back()->getType()
+                                                                                 : DataType::INT));
+    }
+
+    // Bez grupowania: jeden wiersz, także dla pustego wejścia
+    if (groupColumns.empty()) {
+        std::vector<AggregateState> total(specs.size());
+        for (const auto &lanePartial : ungroupedPartials) {
+            for (size_t i = 0; i < specs.size(); ++i) {
+                combineState(total[i], lanePartial[i], specs[i].function, inputs[i]);
+            }
+        }
+        for (size_t i = 0; i < specs.size(); ++i) {
+            appendResult(columns[i], total[i], specs[i].function, inputs[i]);
+        }
+        return columns;
+    }
+
+    // Scalanie częściowych tablic równolegle: partycja p dostaje grupy o hash % partitions == p
+    ThreadPool &pool = ThreadPool::shared();
+    size_t partitions = pool.concurrency();
+    std::vector<std::unique_ptr<GroupHashTable>> merged(partitions);
+    pool.parallelFor(partitions, [&](size_t partition, unsigned) {
+        auto target = std::make_unique<GroupHashTable>(specs.size());
+        for (const auto &source : partials) {
+            if (!source) {
+                continue;
+            }
+            for (uint32_t group = 0; group < source->size(); ++group) {
+                uint64_t hash = source->hash(group);
+                if ((hash >> 7) % partitions != partition) {
+                    continue;
+                }
+                AggregateState *into = target->states(target->findOrInsert(source->key(group), hash));
+                const AggregateState *from = source->states(group);
+                for (size_t i = 0; i < specs.size(); ++i) {
+                    combineState(into[i], from[i], specs[i].function, inputs[i]);
+                }
+            }
+        }
+        merged[partition] = std::move(target);
+    });
+
+    for (const auto &partition : merged) {
+        for (uint32_t group = 0; group < partition->size(); ++group) {
+            const char *cursor = partition->key(group).data();
+            for (size_t g = 0; g < groupColumns.size(); ++g) {
+                if (takeKey<char>(cursor)) {
+                    columns[g].appendNull();
+                    continue;
+                }
+                switch (columns[g].getType()) {
+                    case DataType::INT:
+                        columns[g].appendInt(takeKey<int64_t>(cursor));
+                        break;
+                    case DataType::FLOAT:
+                        columns[g].appendFloat(takeKey<double>(cursor));
+                        break;
+                    case DataType::STRING: {
+                        auto length = takeKey<uint32_t>(cursor);
+                        columns[g].appendString(std::string_view(cursor, length));
+                        cursor += length;
+                        break;
+                    }
+                }
+            }
+            const AggregateState *states = partition->states(group);
+            for (size_t i = 0; i < specs.size(); ++i) {
+                appendResult(columns[groupColumns.size() + i], states[i], specs[i].function, inputs[i]);
+            }
+        }
+    }
+    return columns;
+}
@@ -0,0 +1,103 @@
+#ifndef DATABASE_AGGREGATION_H
+#define DATABASE_AGGREGATION_H
+
+#include "PreRequistion.h"
+#include "Database.h"
+#include "Predicate.h"
+#include "ResultSet.h"
+
+enum class AggregateFunction {
+    COUNT, SUM, MIN, MAX, AVG
+};
+
+// Agregat z listy SELECT, np. SUM(price); columnIndex = -1 dla COUNT(*)
+struct AggregateSpec {
+    AggregateFunction function = AggregateFunction::COUNT;
+    int columnIndex = -1;
+    std::string name;
+};
+
+// Stan jednego agregatu jednej grupy. count = liczba wartości nie-NULL (wierszy dla COUNT(*)),
+// suma/minimum/maksimum w polu odpowiadającym typowi kolumny; dla MIN/MAX napisów intValue to numer
+// wiersza z najlepszą dotąd wartością.
+struct AggregateState {
+    int64_t count = 0;
+    int64_t intValue = 0;
+    double floatValue = 0.0;
+};
+
+// Tablica haszująca grup z adresowaniem otwartym (sondowanie liniowe). Sloty mają 8 bajtów
+// (fragment hasza + numer grupy), więc sondowanie zwykle nie wychodzi poza jedną linię cache;
+// klucze grup (zakodowane wartości kolumn GROUP BY) i stany agregatów leżą w ciągłych tablicach.
+class GroupHashTable {
+public:
+    explicit GroupHashTable(size_t statesPerGroup);
+
+    // Numer grupy o danym kluczu; nowa grupa dostaje wyzerowane stany
+    uint32_t findOrInsert(std::string_view key, uint64_t hash);
+
+    size_t size() const { return hashes.size(); }
+
+    std::string_view key(uint32_t group) const {
+        return {keyBytes.data() + keyOffsets[group], keyOffsets[group + 1] - keyOffsets[group]};
+    }
+
+    uint64_t hash(uint32_t group) const { return hashes[group]; }
+
+    AggregateState *states(uint32_t group) { return stateData.data() + group * width; }
+
+private:
+    struct Slot {
+        uint32_t tag;   // górne 32 bity hasza
+        uint32_t group; // EMPTY_SLOT = wolny
+    };
+
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    void grow();
+
+    size_t width;
+    std::vector<Slot> slots;
+    std::vector<uint64_t> hashes;
+    std::vector<uint64_t> keyOffsets;
+    std::vector<char> keyBytes;
+    std::vector<AggregateState> stateData;
+};
+
+// Agregacja (z GROUP BY albo bez) nad wierszami spełniającymi predykat. Morsele przetwarzane
+// są na wspólnej puli, każdy wątek (lane) ma własne częściowe agregaty; na końcu częściowe
+// tablice scalane są równolegle, partycjami hasza.
+class HashAggregator {
+public:
+    // false (z komunikatem), gdy agregat nie pasuje do typu kolumny
+    bool prepare(const Table &table, const std::vector<int> &groupColumns, const std::vector<AggregateSpec> &specs);
+
+    // Rozpoznaje "FUNKCJA(kolumna)" albo "COUNT(*)" (column = "*")
+    static bool parseAggregate(const std::string &item, AggregateFunction &function, std::string &column);
+
+    // Skan morselami: bitmapa predykatu, a bez grupowania agregaty liczone słowami bitmapy wprost na tablicach kolumn
+    void consumeScan(const Predicate &predicate);
+
+    // Wiersze wybrane przez indeks
+    void consumeRows(const std::vector<uint32_t> &rows);
+
+    // Kolumny wyniku: najpierw kolumny grupujące, potem agregaty, w kolejności z prepare
+    std::vector<ColumnData> finish();
+
+private:
+    void encodeKey(size_t row, std::string &key) const;
+
+    void accumulateRow(AggregateState *states, size_t row) const;
+
+    void accumulateWords(AggregateState *states, size_t firstRow, size_t count, const uint64_t *selection) const;
+
+    GroupHashTable &partial(unsigned lane);
+
+    const Table *table = nullptr;
+    std::vector<int> groupColumns;
+    std::vector<AggregateSpec> specs;
+    std::vector<std::unique_ptr<GroupHashTable>> partials;     // z grupowaniem: jedna na lane
+    std::vector<std::vector<AggregateState>> ungroupedPartials; // bez grupowania: jeden zestaw stanów na lane
+};
+
+#endif //DATABASE_AGGREGATION_H
@@ -0,0 +1,202 @@
+#ifndef DATABASE_BPLUSTREE_H
+#define DATABASE_BPLUSTREE_H
+
+#include "PreRequistion.h"
+#include <memory>
+
+// B+-drzewo par (klucz, numer wiersza). Pary są unikalne, więc duplikaty kluczy
+// odróżnia numer wiersza. Usuwanie nie scala węzłów - puste liście zostają w łańcuchu
+// do najbliższej przebudowy (bulkLoad).
+template<typename Key>
+class BPlusTree {
+public:
+    using Entry = std::pair<Key, uint32_t>;
+
+    static constexpr size_t NODE_CAPACITY = 64;
+
+    BPlusTree() { clear(); }
+
+    void clear() {
+        root = std::make_unique<Node>();
+        root->leaf = true;
+        entryCount = 0;
+    }
+
+    size_t size() const { return entryCount; }
+
+    void insert(const Key &key, uint32_t row) {
+        Entry entry(key, row);
+        Entry separator;
+        std::unique_ptr<Node> sibling = insertInto(root.get(), entry, separator);
+        if (sibling) {
+            auto newRoot = std::make_unique<Node>();
+            newRoot->leaf = false;
+            newRoot->entries.push_back(separator);
+            newRoot->children.push_back(std::move(root));
+            newRoot->children.push_back(std::move(sibling));
+            root = std::move(newRoot);
+        }
+    }
+
+    bool erase(const Key &key, uint32_t row) {
+        Entry entry(key, row);
+        Node *node = findLeaf(entry);
+        auto it = std::lower_bound(node->entries.begin(), node->entries.end(), entry);
+        if (it == node->entries.end() || *it != entry) {
+            return false;
+        }
+        node->entries.erase(it);
+        --entryCount;
+        return true;
+    }
+
+    // Budowa z posortowanych, unikalnych par; liście wypełnione do końca
+    void bulkLoad(const std::vector<Entry> &sorted) {
+        clear();
+        if (sorted.empty()) {
+            return;
+        }
+        std::vector<std::unique_ptr<Node>> level;
+        Node *previous = nullptr;
+        for (size_t i = 0; i < sorted.size(); i += NODE_CAPACITY) {
+            auto leaf = std::make_unique<Node>();
+            leaf->leaf = true;
+            leaf->entries.assign(sorted.begin() + i, sorted.begin() + std::min(sorted.size(), i + NODE_CAPACITY));
+            if (previous) {
+                previous->next = leaf.get();
+            }
+            previous = leaf.get();
+            level.push_back(std::move(leaf));
+        }
+        while (level.size() > 1) {
+            std::vector<std::unique_ptr<Node>> parents;
+            for (size_t i = 0; i < level.size(); i += NODE_CAPACITY) {
+                auto parent = std::make_unique<Node>();
+                parent->leaf = false;
+                size_t end = std::min(level.size(), i + NODE_CAPACITY);
+                for (size_t child = i; child < end; ++child) {
+                    if (child != i) {
+                        parent->entries.push_back(firstEntry(level[child].get()));
+                    }
+                    parent->children.push_back(std::move(level[child]));
+                }
+                parents.push_back(std::move(parent));
+            }
+            level = std::move(parents);
+        }
+        root = std::move(level.front());
+        entryCount = sorted.size();
+    }
+
+    // Wywołuje f(key, row) dla par od pierwszej >= (from, fromRow), dopóki f zwraca true
+    template<typename F>
+    void scanFrom(const Key &from, uint32_t fromRow, F &&f) const {
+        Entry start(from, fromRow);
+        const Node *node = findLeaf(start);
+        size_t pos = std::lower_bound(node->entries.begin(), node->entries.end(), start) - node->entries.begin();
+        walk(node, pos, f);
+    }
+
+    // Wszystkie pary w kolejności rosnącej, dopóki f zwraca true
+    template<typename F>
+    void scanAll(F &&f) const {
+        const Node *node = root.get();
+        while (!node->leaf) {
+            node = node->children.front().get();
+        }
+        walk(node, 0, f);
+    }
+
+private:
+    struct Node {
+        bool leaf = true;
+        // Liść: pary; węzeł wewnętrzny: separatory (pierwsza para poddrzewa children[i + 1])
+        std::vector<Entry> entries;
+        std::vector<std::unique_ptr<Node>> children;
+        Node *next = nullptr;
+    };
+
+    template<typename F>
+    static void walk(const Node *node, size_t pos, F &f) {
+        while (node) {
+            for (; pos < node->entries.size(); ++pos) {
+                if (!f(node->entries[pos].first, node->entries[pos].second)) {
+                    return;
+                }
+            }
+            node = node->next;
+            pos = 0;
+        }
+    }
+
+    static Entry firstEntry(const Node *node) {
+        while (!node->leaf) {
+            node = node->children.front().get();
+        }
+        return node->entries.front();
+    }
+
+    static size_t childSlot(const Node *node, const Entry &entry) {
+        return std::upper_bound(node->entries.begin(), node->entries.end(), entry) - node->entries.begin();
+    }
+
+    Node *findLeaf(const Entry &entry) const {
+        Node *node = root.get();
+        while (!node->leaf) {
+            node = node->children[childSlot(node, entry)].get();
+        }
+        return node;
+    }
+
+    // Zwraca nowy prawy węzeł, jeśli node został podzielony
+    std::unique_ptr<Node> insertInto(Node *node, const Entry &entry, Entry &separator) {
+        if (node->leaf) {
+            auto it = std::lower_bound(node->entries.begin(), node->entries.end(), entry);
+            if (it != node->entries.end() && *it == entry) {
+                return nullptr;
+            }
+            node->entries.insert(it, entry);
+            ++entryCount;
+            if (node->entries.size() <= NODE_CAPACITY) {
+                return nullptr;
+            }
+            auto sibling = std::make_unique<Node>();
+            sibling->leaf = true;
+            size_t half = node->entries.size() / 2;
+            sibling->entries.assign(node->entries.begin() + half, node->entries.end());
+            node->entries.resize(half);
+            sibling->next = node->next;
+            node->next = sibling.get();
+            separator = sibling->entries.front();
+            return sibling;
+        }
+
+        size_t slot = childSlot(node, entry);
+        Entry childSeparator;
+        std::unique_ptr<Node> childSibling = insertInto(node->children[slot].get(), entry, childSeparator);
+        if (!childSibling) {
+            return nullptr;
+        }
+        node->entries.insert(node->entries.begin() + slot, childSeparator);
+        node->children.insert(node->children.begin() + slot + 1, std::move(childSibling));
+        if (node->children.size() <= NODE_CAPACITY) {
+            return nullptr;
+        }
+        auto sibling = std::make_unique<Node>();
+        sibling->leaf = false;
+        size_t half = node->children.size() / 2;
+        separator = node->entries[half - 1];
+        sibling->entries.assign(node->entries.begin() + half, node->entries.end());
+        for (size_t child = half; child < node->children.size(); ++child) {
+            sibling->children.push_back(std::move(node->children[child]));
+        }
+        node->entries.resize(half - 1);
+        node->children.resize(half);
+        return sibling;
+    }
+
+    std::unique_ptr<Node> root;
+    size_t entryCount = 0;
+};
+
+#endif //DATABASE_BPLUSTREE_H
@@ -0,0 +1,350 @@
+#include "Database.h"
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+// Benchmark silnika: mikrobenchmarki pojedynczych operacji Database oraz obciążenie mieszane
+// (odczyty zakresowe i zapisy z wielu wątków). Wynik na stdout jako JSON: przepustowość
+// i opóźnienia p50/p99/p999 w mikrosekundach.
+//
+// db_bench [--rows N] [--ops N] [--mixed-ops N] [--threads N] [--selectivity F] [--read-ratio F]
+//          [--types int,float,string] [--seed N] [--only micro|mixed]
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        size_t rows = 100000;        // wiersze tabeli obciążenia mieszanego i tabel mikrobenchmarków
+        size_t ops = 10000;          // operacje każdego mikrobenchmarku
+        size_t mixedOps = 100000;    // operacje obciążenia mieszanego (wszystkie wątki razem)
+        size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        double selectivity = 0.01;   // część wierszy zwracana przez odczyt
+        double readRatio = 0.9;
+        std::vector<DataType> types{DataType::INT, DataType::FLOAT, DataType::STRING};
+        uint64_t seed = 42;
+        bool micro = true;
+        bool mixed = true;
+    };
+
+    struct Measurement {
+        std::string name;
+        size_t threads = 1;
+        double seconds = 0;
+        std::vector<double> latencies; // us na operację
+    };
+
+    // Bufor odrzucający wyjście selectData
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+    };
+
+    bool parseOptions(int argc, char *argv[], Options &options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string flag = argv[i];
+            if (i + 1 == argc) {
+                std::cerr << "Missing value for " << flag << "." << std::endl;
+                return false;
+            }
+            std::string value = argv[++i];
+            try {
+                if (flag == "--rows") {
+                    options.rows = std::stoull(value);
+                } else if (flag == "--ops") {
+                    options.ops = std::stoull(value);
+                } else if (flag == "--mixed-ops") {
+                    options.mixedOps = std::stoull(value);
+                } else if (flag == "--threads") {
+                    options.threads = std::max<size_t>(1, std::stoull(value));
+                } else if (flag == "--selectivity") {
+                    options.selectivity = std::clamp(std::stod(value), 0.0, 1.0);
+                } else if (flag == "--read-ratio") {
+                    options.readRatio = std::clamp(std::stod(value), 0.0, 1.0);
+                } else if (flag == "--seed") {
+                    options.seed = std::stoull(value);
+                } else if (flag == "--only") {
+                    if (value != "micro" && value != "mixed") {
+                        std::cerr << "Expected micro or mixed after --only." << std::endl;
+                        return false;
+                    }
+                    options.micro = value == "micro";
+                    options.mixed = value == "mixed";
+                } else if (flag == "--types") {
+                    options.types.clear();
+                    std::stringstream list(value);
+                    std::string type;
+                    while (std::getline(list, type, ',')) {
+                        if (type == "int") {
+                            options.types.push_back(DataType::INT);
+                        } else if (type == "float") {
+                            options.types.push_back(DataType::FLOAT);
+                        } else if (type == "string") {
+                            options.types.push_back(DataType::STRING);
+                        } else {
+                            std::cerr << "Unknown column type " << type << "." << std::endl;
+                            return false;
+                        }
+                    }
+                } else {
+                    std::cerr << "Unknown option " << flag << "." << std::endl;
+                    return false;
+                }
+            } catch (const std::exception &) {
+                std::cerr << "Invalid value " << value << " for " << flag << "." << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const char *typeName(DataType type) {
+        switch (type) {
+            case DataType::INT:
+                return "INT";
+            case DataType::FLOAT:
+                return "FLOAT";
+            default:
+                return "STRING";
+        }
+    }
+
+    // Wartość kolumny c wiersza (tekst literału DBQL; napisy z małego zbioru, jak kody czy statusy)
+    std::string columnValue(DataType type, std::mt19937_64 &random) {
+        switch (type) {
+            case DataType::INT:
+                return std::to_string(random() % 1000);
+            case DataType::FLOAT:
+                return std::to_string(static_cast<double>(random() % 100000) / 100);
+            default:
+                return "s" + std::to_string(random() % 100);
+        }
+    }
+
+    // Tabela "name" z kolumną id (0..rows-1) i kolumnami c0, c1, ... typów z options
+    void createTable(Database &database, const std::string &name, const Options &options, std::mt19937_64 &random) {
+        database.createTable(name);
+        database.addNewColumn(name, "id", DataType::INT);
+        RowBatch batch;
+        batch.columnNames.push_back("id");
+        batch.columns.emplace_back(DataType::INT);
+        for (size_t c = 0; c < options.types.size(); ++c) {
+            database.addNewColumn(name, "c" + std::to_string(c), options.types[c]);
+            batch.columnNames.push_back("c" + std::to_string(c));
+            batch.columns.emplace_back(options.types[c]);
+        }
+        for (size_t row = 0; row < options.rows; ++row) {
+            batch.columns[0].appendInt(static_cast<int64_t>(row));
+            for (size_t c = 0; c < options.types.size(); ++c) {
+                batch.columns[c + 1].append(columnValue(options.types[c], random));
+            }
+        }
+        database.insertBatch(name, batch);
+    }
+
+    // Pomiar count wywołań operation(i) w jednym wątku
+    template<typename Operation>
+    Measurement measure(const std::string &name, size_t count, Operation operation) {
+        Measurement result;
+        result.name = name;
+        result.latencies.reserve(count);
+        auto start = Clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            auto begin = Clock::now();
+            operation(i);
+            result.latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+        }
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return result;
+    }
+
+    std::vector<Measurement> runMicro(const Options &options) {
+        std::vector<Measurement> results;
+        std::mt19937_64 random(options.seed);
+        Database database;
+        createTable(database, "bench", options, random);
+        size_t rows = std::max<size_t>(options.rows, 1);
+
+        results.push_back(measure("insertData", options.ops, [&](size_t i) {
+            std::map<std::string, std::string> row;
+            row["id"] = std::to_string(rows + i);
+            for (size_t c = 0; c < options.types.size(); ++c) {
+                row["c" + std::to_string(c)] = columnValue(options.types[c], random);
+            }
+            database.insertData("bench", row);
+        }));
+
+        // Warunki równościowe po id: skan całej tabeli (bez indeksu), jak w typowym użyciu selectData.
+        // Bez kolumn c* aktualizowane jest samo id (na tę samą wartość)
+        results.push_back(measure("updateData", options.ops, [&](size_t) {
+            std::string id = std::to_string(random() % rows);
+            std::map<std::string, std::string> update;
+            if (options.types.empty()) {
+                update["id"] = id;
+            } else {
+                update["c0"] = columnValue(options.types[0], random);
+            }
+            database.updateData("bench", update, "id", id);
+        }));
+
+        NullBuffer discard;
+        std::streambuf *console = std::cout.rdbuf(&discard);
+        results.push_back(measure("selectData", options.ops, [&](size_t) {
+            database.selectData("bench", {"*"}, "id == " + std::to_string(random() % rows));
+        }));
+        std::cout.rdbuf(console);
+
+        // "Najnowsze 100": top-N bez sortowania całej tabeli
+        results.push_back(measure("execute ORDER BY LIMIT", options.ops, [&](size_t) {
+            database.execute("SELECT id FROM bench ORDER BY id DESC LIMIT 100");
+        }));
+
+        results.push_back(measure("deleteData", options.ops, [&](size_t i) {
+            database.deleteData("bench", "id", std::to_string(i % rows));
+        }));
+
+        // Sprawdzanie typów: wartości poprawne i niepoprawne na przemian
+        std::vector<std::pair<Column, std::string>> values = {
+                {Column("i", DataType::INT, 0),    "123456"},
+                {Column("i", DataType::INT, 0),    "12a"},
+                {Column("f", DataType::FLOAT, 0),  "3.14159"},
+                {Column("f", DataType::FLOAT, 0),  "x1.0"},
+                {Column("s", DataType::STRING, 0), "text"},
+        };
+        size_t valid = 0;
+        results.push_back(measure("Column::isValidType", options.ops, [&](size_t i) {
+            const auto &[column, value] = values[i % values.size()];
+            valid += column.isValidType(value);
+        }));
+
+        std::vector<std::string> queries = {
+                "SELECT id, c0 FROM bench WHERE id >= 10 AND id < 20",
+                "INSERT INTO bench (id, c0) VALUES (1, 'abc'), (2, 'def')",
+                "UPDATE bench SET c0 = 5 WHERE id = 7",
+                "DELETE FROM bench WHERE id = 3",
+                "SELECT c0, COUNT(*) FROM bench JOIN other ON id = ref WHERE c0 > 1 GROUP BY c0 LIMIT 10",
+                "SELECT id, c0 FROM bench WHERE id > 5 ORDER BY c0 DESC, id LIMIT 100",
+        };
+        size_t parsed = 0;
+        results.push_back(measure("DBQLParser::parseStatement", options.ops, [&](size_t i) {
+            Statement statement;
+            parsed += DBQLParser::parseStatement(queries[i % queries.size()], statement);
+        }));
+        if (valid == 0 || parsed == 0) {
+            std::cerr << "Benchmark sanity check failed." << std::endl;
+        }
+        return results;
+    }
+
+    Measurement runMixed(const Options &options) {
+        Database database;
+        std::mt19937_64 random(options.seed);
+        createTable(database, "bench", options, random);
+        size_t rows = std::max<size_t>(options.rows, 1);
+        auto span = std::max<size_t>(1, static_cast<size_t>(options.selectivity * static_cast<double>(rows)));
+        std::string projection = options.types.empty() ? "id" : "id, c0";
+
+        std::vector<std::vector<double>> latencies(options.threads);
+        std::atomic<size_t> nextInsert{rows};
+        std::vector<std::thread> workers;
+        auto start = Clock::now();
+        for (size_t t = 0; t < options.threads; ++t) {
+            workers.emplace_back([&, t]() {
+                std::mt19937_64 local(options.seed + t + 1);
+                std::uniform_real_distribution<double> coin(0.0, 1.0);
+                size_t count = options.mixedOps / options.threads + (t < options.mixedOps % options.threads);
+                latencies[t].reserve(count);
+                for (size_t i = 0; i < count; ++i) {
+                    std::string query;
+                    if (coin(local) < options.readRatio) {
+                        size_t first = local() % rows;
+                        query = "SELECT " + projection + " FROM bench WHERE id >= " + std::to_string(first)
+                                + " AND id < " + std::to_string(first + span);
+                    } else if (local() % 2 == 0 || options.types.empty()) {
+                        query = "INSERT INTO bench (id) VALUES (" + std::to_string(nextInsert++) + ")";
+                    } else {
+                        std::string value = columnValue(options.types[0], local);
+                        if (options.types[0] == DataType::STRING) {
+                            value = "'" + value + "'";
+                        }
+                        query = "UPDATE bench SET c0 = " + value + " WHERE id = " + std::to_string(local() % rows);
+                    }
+                    auto begin = Clock::now();
+                    ResultSet result = database.execute(query);
+                    latencies[t].push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+                    if (!result.ok()) {
+                        std::cerr << result.error;
+                    }
+                }
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+
+        Measurement result;
+        result.name = "mixed";
+        result.threads = options.threads;
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        for (const auto &thread : latencies) {
+            result.latencies.insert(result.latencies.end(), thread.begin(), thread.end());
+        }
+        return result;
+    }
+
+    double percentile(const std::vector<double> &sorted, double fraction) {
+        if (sorted.empty()) {
+            return 0;
+        }
+        auto rank = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(rank, sorted.size() - 1)];
+    }
+
+    void printMeasurement(std::ostream &out, Measurement &measurement) {
+        std::sort(measurement.latencies.begin(), measurement.latencies.end());
+        size_t count = measurement.latencies.size();
+        out << "{\"name\": \"" << measurement.name << "\", \"threads\": " << measurement.threads
+            << ", \"ops\": " << count << ", \"seconds\": " << measurement.seconds
+            << ", \"ops_per_sec\": " << (measurement.seconds > 0 ? static_cast<double>(count) / measurement.seconds : 0)
+            << ", \"p50_us\": " << percentile(measurement.latencies, 0.5)
+            << ", \"p99_us\": " << percentile(measurement.latencies, 0.99)
+            << ", \"p999_us\": " << percentile(measurement.latencies, 0.999)
+            << ", \"max_us\": " << (count ? measurement.latencies.back() : 0) << "}";
+    }
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " [--rows N] [--ops N] [--mixed-ops N] [--threads N]"
+                  << " [--selectivity F] [--read-ratio F] [--types int,float,string] [--seed N]"
+                  << " [--only micro|mixed]" << std::endl;
+        return 1;
+    }
+
+    std::ostringstream out;
+    out << "{\n  \"config\": {\"rows\": " << options.rows << ", \"ops\": " << options.ops
+        << ", \"mixed_ops\": " << options.mixedOps << ", \"threads\": " << options.threads
+        << ", \"selectivity\": " << options.selectivity << ", \"read_ratio\": " << options.readRatio
+        << ", \"seed\": " << options.seed << ", \"types\": [";
+    for (size_t i = 0; i < options.types.size(); ++i) {
+        out << (i ? ", " : "") << "\"" << typeName(options.types[i]) << "\"";
+    }
+    out << "]}";
+    if (options.micro) {
+        out << ",\n  \"micro\": [";
+        std::vector<Measurement> results = runMicro(options);
+        for (size_t i = 0; i < results.size(); ++i) {
+            out << (i ? ",\n    " : "\n    ");
+            printMeasurement(out, results[i]);
+        }
+        out << "\n  ]";
+    }
+    if (options.mixed) {
+        out << ",\n  \"mixed\": ";
+        Measurement mixed = runMixed(options);
+        printMeasurement(out, mixed);
+    }
+    out << "\n}\n";
+    std::cout << out.str();
+    return 0;
+}
@@ -0,0 +1,495 @@
+#include "BlockCodec.h"
+#include "ThreadPool.h"
+#include <bit>
+
+namespace {
+    using BlockCodec::Codec;
+
+    struct StreamHeader {
+        uint64_t count;
+        uint32_t width;
+        uint32_t frameCount;
+    };
+
+    struct FrameHeader {
+        uint32_t codec;
+        uint32_t count;
+        uint64_t bytes; // dane ramki bez wyrównania
+    };
+
+    // Kodek LZ: sekwencje token (4 bity długości literałów, 4 bity długości dopasowania - 4),
+    // literały, 16-bitowe przesunięcie dopasowania; długości >= 15 przedłużane bajtami 255.
+    // Ostatnia sekwencja ma same literały.
+    constexpr size_t LZ_MIN_MATCH = 4;
+    constexpr size_t LZ_WINDOW = 65535;
+    constexpr uint32_t LZ_HASH_BITS = 14;
+
+    size_t padded(size_t bytes) {
+        return (bytes + 7) & ~size_t(7);
+    }
+
+    uint64_t loadValue(const void *values, size_t i, uint32_t width) {
+        uint64_t value = 0;
+        std::memcpy(&value, static_cast<const char *>(values) + i * width, width);
+        return value;
+    }
+
+    void storeValue(void *values, size_t i, uint64_t value, uint32_t width) {
+        std::memcpy(static_cast<char *>(values) + i * width, &value, width);
+    }
+
+    uint32_t bitWidth(uint64_t range) {
+        return static_cast<uint32_t>(std::bit_width(range));
+    }
+
+    size_t packedWords(size_t count, uint32_t bits) {
+        return (count * bits + 63) / 64;
+    }
+
+    void append(std::string &out, const void *data, size_t size) {
+        out.append(static_cast<const char *>(data), size);
+    }
+
+    // Wartości (bez znaku) zapisane na bits bitach, kolejno od najmłodszych bitów słowa
+    template<typename Value>
+    void packBits(std::string &out, size_t count, uint32_t bits, Value value) {
+        std::vector<uint64_t> words(packedWords(count, bits), 0);
+        for (size_t i = 0; i < count && bits > 0; ++i) {
+            size_t position = i * bits;
+            size_t word = position >> 6;
+            uint32_t shift = position & 63;
+            uint64_t v = value(i);
+            words[word] |= v << shift;
+            if (shift + bits > 64) {
+                words[word + 1] |= v >> (64 - shift);
+            }
+        }
+        append(out, words.data(), words.size() * sizeof(uint64_t));
+    }
+
+    uint64_t unpackBits(const char *words, size_t i, uint32_t bits) {
+        size_t position = i * bits;
+        size_t word = position >> 6;
+        uint32_t shift = position & 63;
+        uint64_t low;
+        std::memcpy(&low, words + word * 8, sizeof(low));
+        uint64_t v = low >> shift;
+        if (shift + bits > 64) {
+            uint64_t high;
+            std::memcpy(&high, words + (word + 1) * 8, sizeof(high));
+            v |= high << (64 - shift);
+        }
+        return bits == 64 ? v : v & ((uint64_t(1) << bits) - 1);
+    }
+
+    // Statystyki ramki potrzebne do wyboru kodeka
+    struct FrameStats {
+        size_t runs = 0;
+        uint64_t base = 0;      // minimum (INT: ze znakiem)
+        uint32_t forBits = 0;
+        int64_t minDelta = 0;
+        uint32_t deltaBits = 0;
+    };
+
+    FrameStats analyze(const void *values, size_t count, uint32_t width) {
+        FrameStats stats;
+        bool isSigned = width == 8;
+        uint64_t first = loadValue(values, 0, width);
+        uint64_t low = first;
+        uint64_t high = first;
+        int64_t maxDelta = 0;
+        stats.runs = 1;
+        stats.minDelta = count > 1 ? static_cast<int64_t>(loadValue(values, 1, width) - first) : 0;
+        maxDelta = stats.minDelta;
+        uint64_t previous = first;
+        for (size_t i = 1; i < count; ++i) {
+            uint64_t v = loadValue(values, i, width);
+            if (isSigned) {
+                low = static_cast<int64_t>(v) < static_cast<int64_t>(low) ? v : low;
+                high = static_cast<int64_t>(v) > static_cast<int64_t>(high) ? v : high;
+            } else {
+                low = std::min(low, v);
+                high = std::max(high, v);
+            }
+            auto delta = static_cast<int64_t>(v - previous);
+            stats.minDelta = std::min(stats.minDelta, delta);
+            maxDelta = std::max(maxDelta, delta);
+            stats.runs += v != previous;
+            previous = v;
+        }
+        stats.base = low;
+        stats.forBits = bitWidth(high - low);
+        stats.deltaBits = bitWidth(static_cast<uint64_t>(maxDelta) - static_cast<uint64_t>(stats.minDelta));
+        return stats;
+    }
+
+    void encodeValueFrame(std::string &out, const void *values, size_t count, uint32_t width) {
+        FrameStats stats = analyze(values, count, width);
+        size_t rawBytes = count * width;
+        size_t rleBytes = sizeof(uint64_t) + stats.runs * (sizeof(uint64_t) + sizeof(uint32_t));
+        size_t forBytes = 2 * sizeof(uint64_t) + packedWords(count, stats.forBits) * sizeof(uint64_t);
+        size_t deltaBytes = 3 * sizeof(uint64_t) + packedWords(count - 1, stats.deltaBits) * sizeof(uint64_t);
+
+        Codec codec = Codec::RAW;
+        size_t best = padded(rawBytes);
+        auto consider = [&](Codec candidate, size_t bytes) {
+            if (padded(bytes) < best) {
+                codec = candidate;
+                best = padded(bytes);
+            }
+        };
+        consider(Codec::RLE, rleBytes);
+        consider(Codec::FOR, forBytes);
+        consider(Codec::DELTA, deltaBytes);
+
+        size_t frameStart = out.size();
+        FrameHeader header{static_cast<uint32_t>(codec), static_cast<uint32_t>(count), 0};
+        append(out, &header, sizeof(header));
+        size_t dataStart = out.size();
+        switch (codec) {
+            case Codec::RAW:
+                append(out, values, rawBytes);
+                break;
+            case Codec::RLE: {
+                uint64_t runs = stats.runs;
+                append(out, &runs, sizeof(runs));
+                std::vector<uint64_t> runValues;
+                std::vector<uint32_t> runLengths;
+                runValues.reserve(runs);
+                runLengths.reserve(runs);
+                for (size_t i = 0; i < count; ++i) {
+                    uint64_t v = loadValue(values, i, width);
+                    if (i > 0 && v == runValues.back()) {
+                        ++runLengths.back();
+                    } else {
+                        runValues.push_back(v);
+                        runLengths.push_back(1);
+                    }
+                }
+                append(out, runValues.data(), runValues.size() * sizeof(uint64_t));
+                append(out, runLengths.data(), runLengths.size() * sizeof(uint32_t));
+                break;
+            }
+            case Codec::FOR: {
+                uint64_t bits = stats.forBits;
+                append(out, &stats.base, sizeof(stats.base));
+                append(out, &bits, sizeof(bits));
+                packBits(out, count, stats.forBits, [&](size_t i) {
+                    return loadValue(values, i, width) - stats.base;
+                });
+                break;
+            }
+            case Codec::DELTA: {
+                uint64_t first = loadValue(values, 0, width);
+                uint64_t bits = stats.deltaBits;
+                append(out, &first, sizeof(first));
+                append(out, &stats.minDelta, sizeof(stats.minDelta));
+                append(out, &bits, sizeof(bits));
+                packBits(out, count - 1, stats.deltaBits, [&](size_t i) {
+                    uint64_t delta = loadValue(values, i + 1, width) - loadValue(values, i, width);
+                    return delta - static_cast<uint64_t>(stats.minDelta);
+                });
+                break;
+            }
+            case Codec::LZ:
+                break;
+        }
+        uint64_t bytes = out.size() - dataStart;
+        std::memcpy(out.data() + frameStart + offsetof(FrameHeader, bytes), &bytes, sizeof(bytes));
+        out.resize(dataStart + padded(bytes), '\0');
+    }
+
+    void appendLength(std::string &out, size_t length) {
+        for (; length >= 255; length -= 255) {
+            out += static_cast<char>(255);
+        }
+        out += static_cast<char>(length);
+    }
+
+    void appendSequence(std::string &out, const char *literals, size_t literalCount, size_t offset, size_t matchLength) {
+        size_t matchCode = matchLength > 0 ? matchLength - LZ_MIN_MATCH : 0;
+        auto token = static_cast<uint8_t>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCode, 15));
+        out += static_cast<char>(token);
+        if (literalCount >= 15) {
+            appendLength(out, literalCount - 15);
+        }
+        out.append(literals, literalCount);
+        if (matchLength == 0) {
+            return;
+        }
+        out += static_cast<char>(offset & 0xFF);
+        out += static_cast<char>(offset >> 8);
+        if (matchCode >= 15) {
+            appendLength(out, matchCode - 15);
+        }
+    }
+
+    std::string lzCompress(const char *in, size_t size) {
+        std::string out;
+        out.reserve(size / 2 + 16);
+        std::vector<int32_t> table(size_t(1) << LZ_HASH_BITS, -1);
+        size_t anchor = 0;
+        size_t position = 0;
+        while (position + LZ_MIN_MATCH <= size) {
+            uint32_t sequence;
+            std::memcpy(&sequence, in + position, sizeof(sequence));
+            uint32_t hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+            int32_t candidate = table[hash];
+            table[hash] = static_cast<int32_t>(position);
+            if (candidate < 0 || position - candidate > LZ_WINDOW
+                || std::memcmp(in + candidate, in + position, LZ_MIN_MATCH) != 0) {
+                ++position;
+                continue;
+            }
+            size_t length = LZ_MIN_MATCH;
+            while (position + length < size && in[candidate + length] == in[position + length]) {
+                ++length;
+            }
+            appendSequence(out, in + anchor, position - anchor, position - candidate, length);
+            position += length;
+            anchor = position;
+        }
+        appendSequence(out, in + anchor, size - anchor, 0, 0);
+        return out;
+    }
+
+    bool readLength(const uint8_t *in, size_t size, size_t &position, size_t &length) {
+        uint8_t next;
+        do {
+            if (position >= size) {
+                return false;
+            }
+            next = in[position++];
+            length += next;
+        } while (next == 255);
+        return true;
+    }
+
+    bool lzDecompress(const char *data, size_t size, char *out, size_t outSize) {
+        auto in = reinterpret_cast<const uint8_t *>(data);
+        size_t inPosition = 0;
+        size_t outPosition = 0;
+        while (inPosition < size) {
+            uint8_t token = in[inPosition++];
+            size_t literals = token >> 4;
+            if (literals == 15 && !readLength(in, size, inPosition, literals)) {
+                return false;
+            }
+            if (literals > size - inPosition || literals > outSize - outPosition) {
+                return false;
+            }
+            std::memcpy(out + outPosition, in + inPosition, literals);
+            inPosition += literals;
+            outPosition += literals;
+            if (inPosition == size) {
+                break;
+            }
+            if (size - inPosition < 2) {
+                return false;
+            }
+            size_t offset = in[inPosition] | (size_t(in[inPosition + 1]) << 8);
+            inPosition += 2;
+            size_t length = token & 15;
+            if ((length == 15 && !readLength(in, size, inPosition, length)) || offset == 0 || offset > outPosition) {
+                return false;
+            }
+            length += LZ_MIN_MATCH;
+            if (length > outSize - outPosition) {
+                return false;
+            }
+            // Dopasowanie może zachodzić na kopiowany fragment (offset < length) - bajt po bajcie
+            const char *source = out + outPosition - offset;
+            if (offset >= length) {
+                std::memcpy(out + outPosition, source, length);
+            } else {
+                for (size_t i = 0; i < length; ++i) {
+                    out[outPosition + i] = source[i];
+                }
+            }
+            outPosition += length;
+        }
+        return outPosition == outSize;
+    }
+
+    void encodeByteFrame(std::string &out, const char *bytes, size_t count) {
+        std::string compressed = lzCompress(bytes, count);
+        bool useLz = padded(compressed.size()) < padded(count);
+        FrameHeader header{static_cast<uint32_t>(useLz ? Codec::LZ : Codec::RAW), static_cast<uint32_t>(count),
+                           useLz ? compressed.size() : count};
+        append(out, &header, sizeof(header));
+        if (useLz) {
+            out += compressed;
+        } else {
+            out.append(bytes, count);
+        }
+        out.resize(out.size() + padded(header.bytes) - header.bytes, '\0');
+    }
+
+    struct Frame {
+        Codec codec;
+        size_t count;
+        const char *data;
+        size_t bytes;
+        size_t first; // numer pierwszej wartości ramki
+    };
+
+    bool decodeFrame(const Frame &frame, void *out, uint32_t width) {
+        char *target = static_cast<char *>(out) + frame.first * width;
+        const char *data = frame.data;
+        switch (frame.codec) {
+            case Codec::RAW:
+                if (frame.bytes != frame.count * width) {
+                    return false;
+                }
+                std::memcpy(target, data, frame.bytes);
+                return true;
+            case Codec::RLE: {
+                uint64_t runs;
+                if (frame.bytes < sizeof(runs)) {
+                    return false;
+                }
+                std::memcpy(&runs, data, sizeof(runs));
+                if (runs > frame.count || frame.bytes != sizeof(runs) + runs * (sizeof(uint64_t) + sizeof(uint32_t))) {
+                    return false;
+                }
+                const char *runValues = data + sizeof(runs);
+                const char *runLengths = runValues + runs * sizeof(uint64_t);
+                size_t row = 0;
+                for (size_t run = 0; run < runs; ++run) {
+                    uint64_t value;
+                    uint32_t length;
+                    std::memcpy(&value, runValues + run * sizeof(value), sizeof(value));
+                    std::memcpy(&length, runLengths + run * sizeof(length), sizeof(length));
+                    if (length > frame.count - row) {
+                        return false;
+                    }
+                    for (size_t end = row + length; row < end; ++row) {
+                        storeValue(target, row, value, width);
+                    }
+                }
+                return row == frame.count;
+            }
+            case Codec::FOR: {
+                uint64_t header[2]; // base, bits
+                if (frame.bytes < sizeof(header)) {
+                    return false;
+                }
+                std::memcpy(header, data, sizeof(header));
+                if (header[1] > 64 || frame.bytes != sizeof(header) + packedWords(frame.count, header[1]) * 8) {
+                    return false;
+                }
+                const char *words = data + sizeof(header);
+                auto bits = static_cast<uint32_t>(header[1]);
+                for (size_t i = 0; i < frame.count; ++i) {
+                    uint64_t residual = bits > 0 ? unpackBits(words, i, bits) : 0;
+                    storeValue(target, i, header[0] + residual, width);
+                }
+                return true;
+            }
+            case Codec::DELTA: {
+                uint64_t header[3]; // pierwsza wartość, najmniejsza różnica, bits
+                if (frame.count == 0 || frame.bytes < sizeof(header)) {
+                    return false;
+                }
+                std::memcpy(header, data, sizeof(header));
+                if (header[2] > 64 || frame.bytes != sizeof(header) + packedWords(frame.count - 1, header[2]) * 8) {
+                    return false;
+                }
+                const char *words = data + sizeof(header);
+                auto bits = static_cast<uint32_t>(header[2]);
+                uint64_t value = header[0];
+                storeValue(target, 0, value, width);
+                for (size_t i = 1; i < frame.count; ++i) {
+                    value += header[1] + (bits > 0 ? unpackBits(words, i - 1, bits) : 0);
+                    storeValue(target, i, value, width);
+                }
+                return true;
+            }
+            case Codec::LZ:
+                return width == 1 && lzDecompress(data, frame.bytes, target, frame.count);
+        }
+        return false;
+    }
+}
+
+const char *BlockCodec::codecName(Codec codec) {
+    switch (codec) {
+        case Codec::RAW:
+            return "raw";
+        case Codec::RLE:
+            return "rle";
+        case Codec::FOR:
+            return "for";
+        case Codec::DELTA:
+            return "delta";
+        case Codec::LZ:
+            return "lz";
+    }
+    return "unknown";
+}
+
+std::string BlockCodec::encodeValues(const void *values, size_t count, uint32_t width) {
+    std::string out;
+    StreamHeader header{count, width, static_cast<uint32_t>((count + VALUE_FRAME - 1) / VALUE_FRAME)};
+    append(out, &header, sizeof(header));
+    for (size_t first = 0; first < count; first += VALUE_FRAME) {
+        encodeValueFrame(out, static_cast<const char *>(values) + first * width, std::min(VALUE_FRAME, count - first),
+                         width);
+    }
+    return out;
+}
+
+std::string BlockCodec::encodeBytes(const char *bytes, size_t count) {
+    std::string out;
+    StreamHeader header{count, 1, static_cast<uint32_t>((count + BYTE_FRAME - 1) / BYTE_FRAME)};
+    append(out, &header, sizeof(header));
+    for (size_t first = 0; first < count; first += BYTE_FRAME) {
+        encodeByteFrame(out, bytes + first, std::min(BYTE_FRAME, count - first));
+    }
+    return out;
+}
+
+bool BlockCodec::decode(const char *stream, size_t streamBytes, void *out, size_t count, uint32_t width) {
+    StreamHeader header;
+    if (streamBytes < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, stream, sizeof(header));
+    if (header.count != count || header.width != width
+        || header.frameCount > (streamBytes - sizeof(header)) / sizeof(FrameHeader)) {
+        return false;
+    }
+
+    // Najpierw położenie ramek (nagłówki czytane po kolei), potem dane ramek równolegle
+    std::vector<Frame> frames;
+    frames.reserve(header.frameCount);
+    size_t position = sizeof(header);
+    size_t first = 0;
+    for (uint32_t i = 0; i < header.frameCount; ++i) {
+        FrameHeader frameHeader;
+        if (streamBytes - position < sizeof(frameHeader)) {
+            return false;
+        }
+        std::memcpy(&frameHeader, stream + position, sizeof(frameHeader));
+        position += sizeof(frameHeader);
+        if (frameHeader.codec > static_cast<uint32_t>(Codec::LZ) || frameHeader.count > count - first
+            || frameHeader.bytes > streamBytes - position) {
+            return false;
+        }
+        frames.push_back({static_cast<Codec>(frameHeader.codec), frameHeader.count, stream + position,
+                          frameHeader.bytes, first});
+        position += std::min<size_t>(padded(frameHeader.bytes), streamBytes - position);
+        first += frameHeader.count;
+    }
+    if (first != count) {
+        return false;
+    }
+
+    std::atomic<bool> valid{true};
+    ThreadPool::shared().parallelFor(frames.size(), [&](size_t i, unsigned) {
+        if (valid && !decodeFrame(frames[i], out, width)) {
+            valid = false;
+        }
+    });
+    return valid;
+}
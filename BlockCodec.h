@@ -0,0 +1,36 @@
+#ifndef DATABASE_BLOCKCODEC_H
+#define DATABASE_BLOCKCODEC_H
+
+#include "PreRequistion.h"
+
+// Kodeki bloków kolumn w migawce. Tablica dzielona jest na ramki (VALUE_FRAME wartości albo
+// BYTE_FRAME bajtów), a kodek każdej ramki wybierany osobno - ten, który daje najmniej bajtów:
+//   RAW     - wartości bez zmian
+//   RLE     - pary (wartość, długość serii); stałe kolumny, bitmapy NULL-i
+//   FOR     - frame of reference: minimum ramki + różnice upakowane na tylu bitach, ile trzeba
+//   DELTA   - różnice kolejnych wartości, upakowane jak w FOR; rosnące klucze, offsety napisów
+//   LZ      - słownikowy kodek bajtów w stylu LZ4 (okno 64 KB); znaki napisów
+//
+// Strumień: StreamHeader, potem ramki (FrameHeader + dane, każda wyrównana do 8 bajtów).
+namespace BlockCodec {
+    enum class Codec : uint32_t {
+        RAW, RLE, FOR, DELTA, LZ
+    };
+
+    const char *codecName(Codec codec);
+
+    constexpr size_t VALUE_FRAME = 64 * 1024;
+    constexpr size_t BYTE_FRAME = 256 * 1024;
+
+    // count wartości szerokości width (1, 2, 4 albo 8 bajtów, little-endian, bez znaku -
+    // FLOAT zapisywany jako bity double). Różnice liczone modulo 2^64, więc każda wartość ma zapis.
+    std::string encodeValues(const void *values, size_t count, uint32_t width);
+
+    std::string encodeBytes(const char *bytes, size_t count);
+
+    // Rozkodowanie do out (count * width bajtów); false przy uszkodzonym strumieniu albo złej liczbie
+    // wartości. Ramki rozkodowywane są równolegle na wspólnej puli wątków.
+    bool decode(const char *stream, size_t streamBytes, void *out, size_t count, uint32_t width);
+}
+
+#endif //DATABASE_BLOCKCODEC_H
@@ -0,0 +1,204 @@
+#include "BufferPool.h"
+#include "ColumnStore.h"
+#include "MappedFile.h"
+
+PagedFile::PagedFile(std::shared_ptr<const MappedFile> mappedFile)
+        : mapped(std::move(mappedFile)),
+          pageCount((mapped->size() + BufferPool::PAGE_BYTES - 1) / BufferPool::PAGE_BYTES),
+          pages(new Page[pageCount]) {
+}
+
+PagedFile::~PagedFile() {
+    size_t bytes = 0;
+    for (size_t page = 0; page < pageCount; ++page) {
+        if (pages[page].resident.load(std::memory_order_relaxed)) {
+            bytes += pageBytes(page);
+        }
+    }
+    BufferPool::shared().forget(bytes);
+}
+
+bool PagedFile::pageRange(const void *data, size_t bytes, size_t &first, size_t &last) const {
+    auto address = static_cast<const char *>(data);
+    const char *base = mapped->data();
+    if (bytes == 0 || address < base || address >= base + mapped->size()) {
+        return false;
+    }
+    size_t offset = address - base;
+    first = offset / BufferPool::PAGE_BYTES;
+    last = std::min(pageCount, (offset + bytes - 1) / BufferPool::PAGE_BYTES + 1);
+    return true;
+}
+
+size_t PagedFile::pageBytes(size_t page) const {
+    return std::min(BufferPool::PAGE_BYTES, mapped->size() - page * BufferPool::PAGE_BYTES);
+}
+
+void PagedFile::pin(const void *data, size_t bytes, PageGuard &guard) const {
+    size_t first;
+    size_t last;
+    if (!pageRange(data, bytes, first, last)) {
+        return;
+    }
+    BufferPool &pool = BufferPool::shared();
+    size_t admitted = 0;
+    size_t present = 0;
+    for (size_t page = first; page < last; ++page) {
+        Page &entry = pages[page];
+        entry.pins.fetch_add(1, std::memory_order_acquire);
+        entry.referenced.store(true, std::memory_order_relaxed);
+        if (entry.resident.exchange(true, std::memory_order_relaxed)) {
+            ++present;
+        } else {
+            admitted += pageBytes(page);
+        }
+    }
+    guard.ranges.push_back({this, first, last});
+    pool.hits.fetch_add(present, std::memory_order_relaxed);
+    if (admitted > 0) {
+        pool.misses.fetch_add(last - first - present, std::memory_order_relaxed);
+        pool.admit(admitted);
+    }
+}
+
+void PagedFile::unpin(size_t first, size_t last) const {
+    for (size_t page = first; page < last; ++page) {
+        pages[page].pins.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void PagedFile::prefetch(const void *data, size_t bytes) const {
+    size_t first;
+    size_t last;
+    if (!pageRange(data, bytes, first, last)) {
+        return;
+    }
+    // Jedno wywołanie na ciągły fragment stron nieobecnych
+    size_t requested = 0;
+    for (size_t page = first; page < last;) {
+        if (pages[page].resident.load(std::memory_order_relaxed)) {
+            ++page;
+            continue;
+        }
+        size_t end = page;
+        while (end < last && !pages[end].resident.load(std::memory_order_relaxed)) {
+            ++end;
+        }
+        mapped->prefetch(page * BufferPool::PAGE_BYTES, (end - page) * BufferPool::PAGE_BYTES);
+        requested += end - page;
+        page = end;
+    }
+    if (requested > 0) {
+        BufferPool::shared().readaheads.fetch_add(requested, std::memory_order_relaxed);
+    }
+}
+
+PageGuard::~PageGuard() {
+    for (const Range &range : ranges) {
+        range.file->unpin(range.first, range.last);
+    }
+}
+
+BufferPool::BufferPool(size_t capacity) : capacityBytes(capacity) {
+}
+
+BufferPool &BufferPool::shared() {
+    // Celowo bez destruktora: strony zwalniają także pliki niszczone przy wyjściu z programu
+    static BufferPool *pool = new BufferPool([] {
+        const char *configured = std::getenv("DATABASE_BUFFER_POOL_MB");
+        int64_t megabytes = 0;
+        if (configured != nullptr && parseIntValue(configured, megabytes) && megabytes > 0) {
+            return static_cast<size_t>(megabytes) << 20;
+        }
+        return size_t(0);
+    }());
+    return *pool;
+}
+
+void BufferPool::setCapacity(size_t bytes) {
+    capacityBytes.store(bytes, std::memory_order_relaxed);
+    evict();
+}
+
+std::shared_ptr<PagedFile> BufferPool::registerFile(std::shared_ptr<const MappedFile> file) {
+    auto paged = std::make_shared<PagedFile>(std::move(file));
+    std::lock_guard lock(sweepMutex);
+    files.push_back(paged);
+    return paged;
+}
+
+BufferPoolStats BufferPool::stats() const {
+    BufferPoolStats result;
+    result.capacityBytes = capacity();
+    result.residentBytes = residentBytes.load(std::memory_order_relaxed);
+    result.hits = hits.load(std::memory_order_relaxed);
+    result.misses = misses.load(std::memory_order_relaxed);
+    result.evictions = evictions.load(std::memory_order_relaxed);
+    result.readaheads = readaheads.load(std::memory_order_relaxed);
+    return result;
+}
+
+void BufferPool::admit(size_t bytes) {
+    size_t resident = residentBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t limit = capacity();
+    if (limit != 0 && resident > limit) {
+        evict();
+    }
+}
+
+void BufferPool::forget(size_t bytes) {
+    residentBytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void BufferPool::evict() {
+    std::unique_lock lock(sweepMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+    auto overLimit = [this] {
+        size_t limit = capacity();
+        return limit != 0 && residentBytes.load(std::memory_order_relaxed) > limit;
+    };
+    if (!overLimit()) {
+        return;
+    }
+
+    // Pliki już zamknięte wypadają z listy; wskazówka przechodzi po stronach wszystkich plików,
+    // najwyżej dwa razy (pierwsze przejście może tylko zdejmować bity referenced)
+    std::vector<std::shared_ptr<PagedFile>> open;
+    open.reserve(files.size());
+    size_t totalPages = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (auto file = files[i].lock()) {
+            totalPages += file->pageCount;
+            open.push_back(std::move(file));
+        } else if (i < handFile) {
+            --handFile;
+        }
+    }
+    files.assign(open.begin(), open.end());
+    if (open.empty()) {
+        return;
+    }
+    handFile %= open.size();
+
+    for (size_t step = 0; step < 2 * (totalPages + open.size()) && overLimit(); ++step) {
+        PagedFile &file = *open[handFile];
+        if (handPage >= file.pageCount) {
+            handPage = 0;
+            handFile = (handFile + 1) % open.size();
+            continue;
+        }
+        size_t page = handPage++;
+        PagedFile::Page &entry = file.pages[page];
+        if (entry.pins.load(std::memory_order_acquire) != 0
+            || entry.referenced.exchange(false, std::memory_order_relaxed)
+            || !entry.resident.exchange(false, std::memory_order_relaxed)) {
+            continue;
+        }
+        // Strona przypięta w tej chwili przez inny wątek zostanie po prostu wczytana ponownie
+        file.mapped->release(page * PAGE_BYTES, file.pageBytes(page));
+        residentBytes.fetch_sub(file.pageBytes(page), std::memory_order_relaxed);
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,133 @@
+#ifndef DATABASE_BUFFERPOOL_H
+#define DATABASE_BUFFERPOOL_H
+
+#include "PreRequistion.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+class MappedFile;
+
+class PageGuard;
+
+// Zmapowany plik migawki podzielony na strony po BufferPool::PAGE_BYTES bajtów. Skany przypinają
+// strony czytanych wierszy (pin), pula zwalnia z pamięci strony nieprzypięte, gdy zajętość
+// przekroczy limit. Wskaźniki spoza mapowania (np. rozkodowane bloki) są pomijane.
+class PagedFile {
+public:
+    explicit PagedFile(std::shared_ptr<const MappedFile> mappedFile);
+
+    ~PagedFile();
+
+    PagedFile(const PagedFile &) = delete;
+
+    PagedFile &operator=(const PagedFile &) = delete;
+
+    const MappedFile &file() const { return *mapped; }
+
+    // Przypina strony obejmujące [data, data + bytes) do końca życia guard
+    void pin(const void *data, size_t bytes, PageGuard &guard) const;
+
+    // Zleca asynchroniczny odczyt stron nieobecnych w pamięci, bez przypinania
+    void prefetch(const void *data, size_t bytes) const;
+
+private:
+    friend class BufferPool;
+    friend class PageGuard;
+
+    struct Page {
+        std::atomic<uint32_t> pins{0};
+        std::atomic<bool> referenced{false}; // bit CLOCK: dostęp od ostatniego przejścia wskazówki
+        std::atomic<bool> resident{false};   // według puli - strona wczytana i niezwolniona
+    };
+
+    // Zakres stron [first, last) obejmujący bajty; false dla wskaźnika spoza mapowania
+    bool pageRange(const void *data, size_t bytes, size_t &first, size_t &last) const;
+
+    size_t pageBytes(size_t page) const;
+
+    void unpin(size_t first, size_t last) const;
+
+    std::shared_ptr<const MappedFile> mapped;
+    size_t pageCount;
+    std::unique_ptr<Page[]> pages;
+};
+
+// Strony przypięte przez skan (np. jeden morsel); zwalniane w destruktorze
+class PageGuard {
+public:
+    PageGuard() = default;
+
+    ~PageGuard();
+
+    PageGuard(const PageGuard &) = delete;
+
+    PageGuard &operator=(const PageGuard &) = delete;
+
+private:
+    friend class PagedFile;
+
+    struct Range {
+        const PagedFile *file;
+        size_t first;
+        size_t last;
+    };
+
+    std::vector<Range> ranges;
+};
+
+struct BufferPoolStats {
+    size_t capacityBytes = 0; // 0 - bez limitu
+    size_t residentBytes = 0;
+    uint64_t hits = 0;        // przypięcia stron już obecnych w pamięci
+    uint64_t misses = 0;      // przypięcia stron do wczytania
+    uint64_t evictions = 0;
+    uint64_t readaheads = 0;  // strony zlecone do odczytu z wyprzedzeniem
+};
+
+// Zarządca stron plików migawek wspólny dla procesu. Kolumny czytane są wprost z mapowania,
+// więc dostęp bez przypięcia jest zawsze poprawny - przypięcia chronią tylko strony trwającego
+// skanu przed zwolnieniem i mówią puli, które strony są gorące. Po przekroczeniu limitu zwalniane
+// są strony wybrane algorytmem CLOCK (druga szansa dla stron używanych od ostatniego przejścia).
+// Limit z DATABASE_BUFFER_POOL_MB albo setCapacity; bez limitu strony zarządzane są tylko przez system.
+class BufferPool {
+public:
+    static constexpr size_t PAGE_BYTES = 256 * 1024;
+
+    static BufferPool &shared();
+
+    void setCapacity(size_t bytes);
+
+    size_t capacity() const { return capacityBytes.load(std::memory_order_relaxed); }
+
+    std::shared_ptr<PagedFile> registerFile(std::shared_ptr<const MappedFile> file);
+
+    BufferPoolStats stats() const;
+
+private:
+    friend class PagedFile;
+
+    explicit BufferPool(size_t capacity);
+
+    // Strona przypięta pierwszy raz od wczytania albo zwolnienia
+    void admit(size_t bytes);
+
+    void forget(size_t bytes);
+
+    // Zwalnia strony, aż zajętość spadnie do limitu (albo wszystkie strony są przypięte)
+    void evict();
+
+    std::atomic<size_t> capacityBytes;
+    std::atomic<size_t> residentBytes{0};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+    std::atomic<uint64_t> readaheads{0};
+
+    std::mutex sweepMutex; // jedna wskazówka CLOCK; pozostałe wątki nie czekają na przejście
+    std::vector<std::weak_ptr<PagedFile>> files;
+    size_t handFile = 0;
+    size_t handPage = 0;
+};
+
+#endif //DATABASE_BUFFERPOOL_H
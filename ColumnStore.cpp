@@ -0,0 +1,1062 @@
+#include "ColumnStore.h"
+#include "Diagnostics.h"
+#include "Hashing.h"
+#include "MappedFile.h"
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <numeric>
+
+DataType getTypeFromString(const std::string &typeString) {
+    if (typeString == "INT") {
+        return DataType::INT;
+    }
+    if (typeString == "FLOAT") {
+        return DataType::FLOAT;
+    }
+    if (typeString != "STRING") {
+        errorStream() << "Unknown data type " << typeString << ", using STRING." << std::endl;
+    }
+    return DataType::STRING;
+}
+
+bool parseIntValue(std::string_view text, int64_t &value) {
+    if (!text.empty() && text.front() == '+') {
+        text.remove_prefix(1);
+    }
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+bool parseFloatValue(std::string_view text, double &value) {
+    if (!text.empty() && text.front() == '+') {
+        text.remove_prefix(1);
+    }
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+std::string getTypeName(DataType type) {
+    switch (type) {
+        case DataType::INT:
+            return "INT";
+        case DataType::FLOAT:
+            return "FLOAT";
+        case DataType::STRING:
+            return "STRING";
+    }
+    return "STRING";
+}
+
+ColumnData::ColumnData(DataType columnType) : type(columnType) {
+}
+
+void ColumnData::syncView() {
+    view.ints = ints.data();
+    view.floats = floats.data();
+    view.stringOffsets = stringOffsets.data();
+    view.stringLengths = stringLengths.data();
+    view.chars = chars.data();
+    view.charBytes = chars.size();
+    view.nulls = nullBitmap.data();
+    view.codes = codeWidth != 0 ? codes.data() : nullptr;
+    view.codeWidth = codeWidth;
+    view.dictionarySize = codeWidth != 0 ? stringOffsets.size() : 0;
+    view.sortedDictionary = sortedDictionary;
+    view.pages = nullptr;
+}
+
+void ColumnData::ensureOwned() {
+    if (backing) {
+        // Kopiowanie przy pierwszym zapisie do kolumny zmapowanej z pliku
+        *this = materialized(rows);
+    }
+}
+
+ColumnData ColumnData::materialized(size_t capacity) const {
+    ColumnData copy(type);
+    copy.rows = rows;
+    copy.codeWidth = view.codes ? view.codeWidth : 0;
+    copy.sortedDictionary = view.sortedDictionary;
+    capacity = std::max(capacity, rows);
+    size_t words = (rows + 63) >> 6;
+    copy.nullBitmap.reserve((capacity + 63) >> 6);
+    copy.nullBitmap.assign(view.nulls, view.nulls + words);
+    switch (type) {
+        case DataType::INT:
+            copy.ints.reserve(capacity);
+            copy.ints.assign(view.ints, view.ints + rows);
+            break;
+        case DataType::FLOAT:
+            copy.floats.reserve(capacity);
+            copy.floats.assign(view.floats, view.floats + rows);
+            break;
+        case DataType::STRING: {
+            size_t entries = view.codes ? view.dictionarySize : rows;
+            if (view.codes) {
+                copy.codes.reserve(capacity * view.codeWidth);
+                copy.codes.assign(view.codes, view.codes + rows * view.codeWidth);
+                copy.chars.assign(view.chars, view.chars + view.charBytes);
+            } else {
+                copy.stringOffsets.reserve(capacity);
+                copy.stringLengths.reserve(capacity);
+                copy.chars.reserve(rows != 0 ? view.charBytes / rows * capacity : 0);
+                copy.chars.assign(view.chars, view.chars + view.charBytes);
+            }
+            copy.stringOffsets.insert(copy.stringOffsets.end(), view.stringOffsets, view.stringOffsets + entries);
+            copy.stringLengths.insert(copy.stringLengths.end(), view.stringLengths, view.stringLengths + entries);
+            break;
+        }
+    }
+    copy.garbageBytes = garbageBytes;
+    copy.zones = zones;
+    copy.syncView();
+    return copy;
+}
+
+void ColumnData::attach(std::shared_ptr<const void> owner, size_t rowCount, const ColumnArrays &external,
+                        std::vector<ColumnZone> zoneMaps) {
+    ints.clear();
+    floats.clear();
+    stringOffsets.clear();
+    stringLengths.clear();
+    chars.clear();
+    nullBitmap.clear();
+    codes.clear();
+    dictionarySlots.clear();
+    codeWidth = external.codes ? external.codeWidth : 0;
+    sortedDictionary = external.sortedDictionary;
+    garbageBytes = 0;
+    rows = rowCount;
+    view = external;
+    backing = std::move(owner);
+    zones = std::move(zoneMaps);
+    if (zones.size() != (rows + ZONE_ROWS - 1) / ZONE_ROWS) {
+        rebuildZones();
+    }
+}
+
+namespace {
+    // Pamięć kolumny z attachRepeated
+    struct RepeatedValue {
+        explicit RepeatedValue(size_t bytes) : zeros(bytes) {}
+
+        ZeroRegion zeros;
+        std::vector<uint64_t> nulls;
+        uint64_t offset = 0;
+        uint32_t length = 0;
+        std::string chars;
+    };
+}
+
+bool ColumnData::attachRepeated(const std::string &value, bool null, size_t count) {
+    int64_t intValue = 0;
+    double floatValue = 0.0;
+    if (!null && ((type == DataType::INT && (!parseIntValue(value, intValue) || intValue != 0))
+                  || (type == DataType::FLOAT && (!parseFloatValue(value, floatValue) || floatValue != 0.0
+                                                  || std::signbit(floatValue))))) {
+        return false;
+    }
+    size_t words = (count + 63) >> 6;
+    auto repeated = std::make_shared<RepeatedValue>(
+            std::max(count * (type == DataType::STRING ? 1 : sizeof(int64_t)), words * sizeof(uint64_t)));
+    if (repeated->zeros.data() == nullptr) {
+        return false;
+    }
+    const char *zeros = repeated->zeros.data();
+    ColumnArrays external;
+    external.nulls = reinterpret_cast<const uint64_t *>(zeros);
+    if (null) {
+        repeated->nulls.assign(words, ~uint64_t(0));
+        external.nulls = repeated->nulls.data();
+    }
+    switch (type) {
+        case DataType::INT:
+            external.ints = reinterpret_cast<const int64_t *>(zeros);
+            break;
+        case DataType::FLOAT:
+            external.floats = reinterpret_cast<const double *>(zeros);
+            break;
+        case DataType::STRING:
+            // Wszystkie wiersze mają kod 0; NULL - kod pustego napisu
+            if (!null) {
+                repeated->chars = value;
+            }
+            repeated->length = static_cast<uint32_t>(repeated->chars.size());
+            external.codes = reinterpret_cast<const uint8_t *>(zeros);
+            external.codeWidth = 1;
+            external.dictionarySize = 1;
+            external.sortedDictionary = true;
+            external.stringOffsets = &repeated->offset;
+            external.stringLengths = &repeated->length;
+            external.chars = repeated->chars.data();
+            external.charBytes = repeated->chars.size();
+            break;
+    }
+
+    // Statystyki bloków od razu - bez czytania wierszy
+    std::vector<ColumnZone> zoneMaps((count + ZONE_ROWS - 1) / ZONE_ROWS);
+    for (size_t zone = 0; zone < zoneMaps.size(); ++zone) {
+        auto zoneRows = static_cast<uint32_t>(std::min(ZONE_ROWS, count - zone * ZONE_ROWS));
+        if (null) {
+            zoneMaps[zone].nullCount = zoneRows;
+        } else if (type == DataType::INT) {
+            zoneMaps[zone].minInt = zoneMaps[zone].maxInt = 0;
+        } else if (type == DataType::FLOAT) {
+            zoneMaps[zone].minFloat = zoneMaps[zone].maxFloat = 0.0;
+        }
+    }
+    attach(std::move(repeated), count, external, std::move(zoneMaps));
+    return true;
+}
+
+namespace {
+    // Fragmenty zmapowanych tablic z wierszami [first, last): f(wskaźnik, bajty).
+    // Znaki napisów bez słownika szacowane proporcjonalnie do numerów wierszy - odczyt offsetów
+    // wczytałby strony, zanim przypięcie albo odczyt z wyprzedzeniem cokolwiek da.
+    template<typename F>
+    void forEachRowBytes(const ColumnArrays &view, DataType type, size_t rows, size_t first, size_t last, F f) {
+        if (first >= last) {
+            return;
+        }
+        f(view.nulls + (first >> 6), (((last + 63) >> 6) - (first >> 6)) * sizeof(uint64_t));
+        switch (type) {
+            case DataType::INT:
+                f(view.ints + first, (last - first) * sizeof(int64_t));
+                break;
+            case DataType::FLOAT:
+                f(view.floats + first, (last - first) * sizeof(double));
+                break;
+            case DataType::STRING:
+                if (view.codes) {
+                    f(view.codes + first * view.codeWidth, (last - first) * view.codeWidth);
+                    f(view.stringOffsets, view.dictionarySize * sizeof(uint64_t));
+                    f(view.stringLengths, view.dictionarySize * sizeof(uint32_t));
+                    f(view.chars, view.charBytes);
+                } else {
+                    f(view.stringOffsets + first, (last - first) * sizeof(uint64_t));
+                    f(view.stringLengths + first, (last - first) * sizeof(uint32_t));
+                    size_t charsFirst = static_cast<size_t>(static_cast<double>(view.charBytes) * first / rows);
+                    size_t charsLast = static_cast<size_t>(static_cast<double>(view.charBytes) * last / rows);
+                    f(view.chars + charsFirst, charsLast - charsFirst + 1);
+                }
+                break;
+        }
+    }
+}
+
+void ColumnData::pinRows(size_t first, size_t last, PageGuard &guard) const {
+    if (view.pages == nullptr) {
+        return;
+    }
+    forEachRowBytes(view, type, rows, first, std::min(last, rows), [&](const void *data, size_t bytes) {
+        view.pages->pin(data, bytes, guard);
+    });
+}
+
+void ColumnData::prefetchRows(size_t first, size_t last) const {
+    if (view.pages == nullptr) {
+        return;
+    }
+    forEachRowBytes(view, type, rows, first, std::min(last, rows), [&](const void *data, size_t bytes) {
+        view.pages->prefetch(data, bytes);
+    });
+}
+
+void pinScanMorsel(const std::vector<const ColumnData *> &columns, size_t firstRow, size_t count, size_t aheadRow,
+                   PageGuard &guard) {
+    for (const ColumnData *column : columns) {
+        column->pinRows(firstRow, firstRow + count, guard);
+        column->prefetchRows(aheadRow, aheadRow + count);
+    }
+}
+
+void ColumnData::widenZone(size_t row) {
+    size_t zoneNumber = row / ZONE_ROWS;
+    if (zoneNumber >= zones.size()) {
+        zones.resize(zoneNumber + 1);
+    }
+    ColumnZone &zone = zones[zoneNumber];
+    if (isNull(row)) {
+        ++zone.nullCount;
+        return;
+    }
+    switch (type) {
+        case DataType::INT:
+            zone.minInt = std::min(zone.minInt, view.ints[row]);
+            zone.maxInt = std::max(zone.maxInt, view.ints[row]);
+            break;
+        case DataType::FLOAT:
+            if (std::isnan(view.floats[row])) {
+                ++zone.nanCount;
+                break;
+            }
+            zone.minFloat = std::min(zone.minFloat, view.floats[row]);
+            zone.maxFloat = std::max(zone.maxFloat, view.floats[row]);
+            break;
+        case DataType::STRING:
+            break;
+    }
+}
+
+void ColumnData::widenZonesRepeated(size_t first, size_t last) {
+    while (first < last) {
+        size_t end = std::min(last, (first / ZONE_ROWS + 1) * ZONE_ROWS);
+        widenZone(first);
+        ColumnZone &zone = zones[first / ZONE_ROWS];
+        auto others = static_cast<uint32_t>(end - first - 1);
+        if (isNull(first)) {
+            zone.nullCount += others;
+        } else if (type == DataType::FLOAT && std::isnan(view.floats[first])) {
+            zone.nanCount += others;
+        }
+        first = end;
+    }
+}
+
+void ColumnData::rebuildZones() {
+    zones.clear();
+    zones.reserve((rows + ZONE_ROWS - 1) / ZONE_ROWS);
+    for (size_t row = 0; row < rows; ++row) {
+        widenZone(row);
+    }
+}
+
+std::string ColumnData::getAsString(size_t row) const {
+    if (isNull(row)) {
+        return std::string();
+    }
+    switch (type) {
+        case DataType::INT:
+            return std::to_string(getInt(row));
+        case DataType::FLOAT: {
+            std::ostringstream oss;
+            oss << getFloat(row);
+            return oss.str();
+        }
+        case DataType::STRING:
+            return std::string(getString(row));
+    }
+    return std::string();
+}
+
+void ColumnData::growBitmap() {
+    if ((rows >> 6) >= nullBitmap.size()) {
+        nullBitmap.push_back(0);
+    }
+}
+
+void ColumnData::markNullRange(size_t first, size_t last, bool null) {
+    nullBitmap.resize((last + 63) >> 6, 0);
+    size_t row = first;
+    for (; row < last && (row & 63) != 0; ++row) {
+        markNull(row, null);
+    }
+    for (; row + 64 <= last; row += 64) {
+        nullBitmap[row >> 6] = null ? ~uint64_t(0) : 0;
+    }
+    for (; row < last; ++row) {
+        markNull(row, null);
+    }
+}
+
+void ColumnData::markNull(size_t row, bool null) {
+    uint64_t mask = uint64_t(1) << (row & 63);
+    if (null) {
+        nullBitmap[row >> 6] |= mask;
+    } else {
+        nullBitmap[row >> 6] &= ~mask;
+    }
+}
+
+void ColumnData::storeString(size_t row, std::string_view value) {
+    if (chars.size() + value.size() > chars.capacity() && garbageBytes > chars.size() / 2) {
+        compactChars();
+    }
+    stringOffsets[row] = chars.size();
+    stringLengths[row] = static_cast<uint32_t>(value.size());
+    chars.insert(chars.end(), value.begin(), value.end());
+}
+
+void ColumnData::pushString(std::string_view value) {
+    if (codeWidth != 0) {
+        uint32_t code = internString(value);
+        codes.resize(codes.size() + codeWidth);
+        storeCode(rows, code);
+        return;
+    }
+    stringOffsets.push_back(0);
+    stringLengths.push_back(0);
+    storeString(rows, value);
+}
+
+namespace {
+    const uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    uint32_t codeWidthFor(size_t entries) {
+        return entries <= (size_t(1) << 8) ? 1 : entries <= (size_t(1) << 16) ? 2 : 4;
+    }
+}
+
+uint32_t ColumnData::internString(std::string_view value) {
+    size_t entries = stringOffsets.size();
+    if (dictionarySlots.size() < entries * 2 + 2) {
+        rebuildDictionarySlots();
+    }
+    size_t mask = dictionarySlots.size() - 1;
+    size_t slot = hashBytes(value) & mask;
+    for (; dictionarySlots[slot] != EMPTY_SLOT; slot = (slot + 1) & mask) {
+        uint32_t code = dictionarySlots[slot];
+        if (std::string_view(chars.data() + stringOffsets[code], stringLengths[code]) == value) {
+            return code;
+        }
+    }
+
+    // Dopisanie większej wartości na koniec zachowuje posortowanie
+    if (entries > 0 && value < std::string_view(chars.data() + stringOffsets[entries - 1], stringLengths[entries - 1])) {
+        sortedDictionary = false;
+    }
+    auto code = static_cast<uint32_t>(entries);
+    dictionarySlots[slot] = code;
+    stringOffsets.push_back(chars.size());
+    stringLengths.push_back(static_cast<uint32_t>(value.size()));
+    chars.insert(chars.end(), value.begin(), value.end());
+    if (codeWidthFor(entries + 1) > codeWidth) {
+        widenCodes(codeWidthFor(entries + 1));
+    }
+    return code;
+}
+
+void ColumnData::rebuildDictionarySlots() {
+    size_t entries = stringOffsets.size();
+    dictionarySlots.assign(std::bit_ceil(std::max<size_t>(16, entries * 4)), EMPTY_SLOT);
+    size_t mask = dictionarySlots.size() - 1;
+    for (uint32_t code = 0; code < entries; ++code) {
+        size_t slot = hashBytes(std::string_view(chars.data() + stringOffsets[code], stringLengths[code])) & mask;
+        while (dictionarySlots[slot] != EMPTY_SLOT) {
+            slot = (slot + 1) & mask;
+        }
+        dictionarySlots[slot] = code;
+    }
+}
+
+void ColumnData::storeCode(size_t row, uint32_t code) {
+    uint8_t *target = codes.data() + row * codeWidth;
+    switch (codeWidth) {
+        case 1:
+            *target = static_cast<uint8_t>(code);
+            break;
+        case 2: {
+            auto narrow = static_cast<uint16_t>(code);
+            std::memcpy(target, &narrow, sizeof(narrow));
+            break;
+        }
+        default:
+            std::memcpy(target, &code, sizeof(code));
+            break;
+    }
+}
+
+void ColumnData::widenCodes(uint32_t width) {
+    PooledVector<uint8_t> narrow = std::move(codes);
+    uint32_t narrowWidth = codeWidth;
+    codes.assign(rows * width, 0);
+    codeWidth = width;
+    for (size_t row = 0; row < rows; ++row) {
+        uint32_t code = 0;
+        std::memcpy(&code, narrow.data() + row * narrowWidth, narrowWidth);
+        storeCode(row, code);
+    }
+}
+
+bool ColumnData::encodeDictionary() {
+    if (type != DataType::STRING) {
+        return false;
+    }
+    ensureOwned();
+
+    // Różne wartości (widoki na obecny bufor znaków) i numer wartości każdego wiersza
+    size_t limit = rows / DICTIONARY_MIN_REPEAT;
+    std::vector<std::string_view> distinct;
+    std::vector<uint32_t> valueOf(rows);
+    std::vector<uint32_t> slots(std::bit_ceil(std::max<size_t>(16, limit * 2 + 2)), EMPTY_SLOT);
+    size_t mask = slots.size() - 1;
+    for (size_t row = 0; row < rows; ++row) {
+        std::string_view value = getString(row);
+        size_t slot = hashBytes(value) & mask;
+        while (slots[slot] != EMPTY_SLOT && distinct[slots[slot]] != value) {
+            slot = (slot + 1) & mask;
+        }
+        if (slots[slot] == EMPTY_SLOT) {
+            if (distinct.size() >= std::max<size_t>(limit, 1)) {
+                return false;
+            }
+            slots[slot] = static_cast<uint32_t>(distinct.size());
+            distinct.push_back(value);
+        }
+        valueOf[row] = slots[slot];
+    }
+
+    // Słownik posortowany: kod = pozycja wartości w porządku rosnącym
+    std::vector<uint32_t> order(distinct.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&distinct](uint32_t a, uint32_t b) { return distinct[a] < distinct[b]; });
+    std::vector<uint32_t> codeOf(distinct.size());
+    PooledVector<uint64_t> entryOffsets(distinct.size());
+    PooledVector<uint32_t> entryLengths(distinct.size());
+    PooledVector<char> entryChars;
+    for (uint32_t code = 0; code < order.size(); ++code) {
+        std::string_view value = distinct[order[code]];
+        codeOf[order[code]] = code;
+        entryOffsets[code] = entryChars.size();
+        entryLengths[code] = static_cast<uint32_t>(value.size());
+        entryChars.insert(entryChars.end(), value.begin(), value.end());
+    }
+    codeWidth = codeWidthFor(distinct.size());
+    codes.assign(rows * codeWidth, 0);
+    for (size_t row = 0; row < rows; ++row) {
+        storeCode(row, codeOf[valueOf[row]]);
+    }
+
+    stringOffsets = std::move(entryOffsets);
+    stringLengths = std::move(entryLengths);
+    chars = std::move(entryChars);
+    garbageBytes = 0;
+    sortedDictionary = true;
+    dictionarySlots.clear();
+    syncView();
+    return true;
+}
+
+void ColumnData::decodeDictionary() {
+    if (!isDictionaryEncoded()) {
+        return;
+    }
+    ensureOwned();
+    PooledVector<uint64_t> rowOffsets(rows);
+    PooledVector<uint32_t> rowLengths(rows);
+    PooledVector<char> rowChars;
+    for (size_t row = 0; row < rows; ++row) {
+        std::string_view value = isNull(row) ? std::string_view() : getString(row);
+        rowOffsets[row] = rowChars.size();
+        rowLengths[row] = static_cast<uint32_t>(value.size());
+        rowChars.insert(rowChars.end(), value.begin(), value.end());
+    }
+    stringOffsets = std::move(rowOffsets);
+    stringLengths = std::move(rowLengths);
+    chars = std::move(rowChars);
+    codes.clear();
+    codes.shrink_to_fit();
+    codeWidth = 0;
+    sortedDictionary = false;
+    dictionarySlots.clear();
+    dictionarySlots.shrink_to_fit();
+    garbageBytes = 0;
+    syncView();
+}
+
+void ColumnData::optimizeEncoding() {
+    if (type != DataType::STRING || rows < DICTIONARY_MIN_ROWS) {
+        return;
+    }
+    if (!encodeDictionary()) {
+        decodeDictionary();
+    }
+}
+
+void ColumnData::append(const std::string &value) {
+    ensureOwned();
+    growBitmap();
+    switch (type) {
+        case DataType::INT: {
+            int64_t parsed = 0;
+            parseIntValue(value, parsed);
+            ints.push_back(parsed);
+            break;
+        }
+        case DataType::FLOAT: {
+            double parsed = 0.0;
+            parseFloatValue(value, parsed);
+            floats.push_back(parsed);
+            break;
+        }
+        case DataType::STRING:
+            pushString(value);
+            break;
+    }
+    markNull(rows, type != DataType::STRING && value.empty());
+    ++rows;
+    syncView();
+    widenZone(rows - 1);
+}
+
+void ColumnData::appendInt(int64_t value) {
+    ensureOwned();
+    growBitmap();
+    ints.push_back(value);
+    markNull(rows, false);
+    ++rows;
+    syncView();
+    widenZone(rows - 1);
+}
+
+void ColumnData::appendFloat(double value) {
+    ensureOwned();
+    growBitmap();
+    floats.push_back(value);
+    markNull(rows, false);
+    ++rows;
+    syncView();
+    widenZone(rows - 1);
+}
+
+void ColumnData::appendString(std::string_view value) {
+    ensureOwned();
+    growBitmap();
+    pushString(value);
+    markNull(rows, false);
+    ++rows;
+    syncView();
+    widenZone(rows - 1);
+}
+
+void ColumnData::appendNull() {
+    appendNulls(1);
+}
+
+void ColumnData::appendNulls(size_t count) {
+    ensureOwned();
+    size_t newRows = rows + count;
+    switch (type) {
+        case DataType::INT:
+            ints.resize(newRows, 0);
+            break;
+        case DataType::FLOAT:
+            floats.resize(newRows, 0.0);
+            break;
+        case DataType::STRING:
+            if (codeWidth != 0) {
+                uint32_t empty = internString(std::string_view());
+                codes.resize(newRows * codeWidth);
+                for (size_t row = rows; row < newRows; ++row) {
+                    storeCode(row, empty);
+                }
+            } else {
+                stringOffsets.resize(newRows, 0);
+                stringLengths.resize(newRows, 0);
+            }
+            break;
+    }
+    markNullRange(rows, newRows, true);
+    size_t firstRow = rows;
+    rows = newRows;
+    syncView();
+    widenZonesRepeated(firstRow, rows);
+}
+
+void ColumnData::appendRepeated(const std::string &value, size_t count) {
+    if (type != DataType::STRING && value.empty()) {
+        appendNulls(count);
+        return;
+    }
+    if (count == 0) {
+        return;
+    }
+    ensureOwned();
+    size_t newRows = rows + count;
+    switch (type) {
+        case DataType::INT: {
+            int64_t parsed = 0;
+            parseIntValue(value, parsed);
+            ints.resize(newRows, parsed);
+            break;
+        }
+        case DataType::FLOAT: {
+            double parsed = 0.0;
+            parseFloatValue(value, parsed);
+            floats.resize(newRows, parsed);
+            break;
+        }
+        case DataType::STRING: {
+            if (rows == 0 && codeWidth == 0 && count >= DICTIONARY_MIN_ROWS) {
+                codeWidth = 1;
+                sortedDictionary = true;
+            }
+            if (codeWidth != 0) {
+                uint32_t code = internString(value);
+                codes.resize(newRows * codeWidth);
+                for (size_t row = rows; row < newRows; ++row) {
+                    storeCode(row, code);
+                }
+                break;
+            }
+            // Każdy wiersz z własną kopią napisu - compactChars zakłada rozłączne fragmenty chars
+            stringOffsets.reserve(newRows);
+            stringLengths.reserve(newRows);
+            chars.reserve(chars.size() + count * value.size());
+            for (size_t row = rows; row < newRows; ++row) {
+                stringOffsets.push_back(chars.size());
+                stringLengths.push_back(static_cast<uint32_t>(value.size()));
+                chars.insert(chars.end(), value.begin(), value.end());
+            }
+            break;
+        }
+    }
+    markNullRange(rows, newRows, false);
+    size_t firstRow = rows;
+    rows = newRows;
+    syncView();
+    widenZonesRepeated(firstRow, rows);
+}
+
+bool ColumnData::appendParsed(std::string_view value) {
+    if (value.empty() && type != DataType::STRING) {
+        appendNull();
+        return true;
+    }
+    ensureOwned();
+    switch (type) {
+        case DataType::INT: {
+            int64_t parsed;
+            if (!parseIntValue(value, parsed)) {
+                return false;
+            }
+            ints.push_back(parsed);
+            break;
+        }
+        case DataType::FLOAT: {
+            double parsed;
+            if (!parseFloatValue(value, parsed)) {
+                return false;
+            }
+            floats.push_back(parsed);
+            break;
+        }
+        case DataType::STRING:
+            pushString(value);
+            break;
+    }
+    growBitmap();
+    markNull(rows, false);
+    ++rows;
+    syncView();
+    widenZone(rows - 1);
+    return true;
+}
+
+void ColumnData::appendColumn(const ColumnData &other) {
+    ensureOwned();
+    size_t count = other.size();
+    const ColumnArrays &source = other.arrays();
+    switch (type) {
+        case DataType::INT:
+            ints.insert(ints.end(), source.ints, source.ints + count);
+            break;
+        case DataType::FLOAT:
+            floats.insert(floats.end(), source.floats, source.floats + count);
+            break;
+        case DataType::STRING: {
+            if (codeWidth != 0 || other.isDictionaryEncoded()) {
+                // Słownik po którejkolwiek stronie: wartość po wartości (NULL to pusty napis);
+                // pushString dopisuje pod numerem rows, bitmapa NULL-i niżej liczona od początku wsadu
+                for (size_t row = 0; row < count; ++row, ++rows) {
+                    pushString(other.getString(row));
+                }
+                rows -= count;
+                break;
+            }
+            uint64_t base = chars.size();
+            chars.insert(chars.end(), source.chars, source.chars + source.charBytes);
+            for (size_t row = 0; row < count; ++row) {
+                stringOffsets.push_back(base + source.stringOffsets[row]);
+            }
+            stringLengths.insert(stringLengths.end(), source.stringLengths, source.stringLengths + count);
+            garbageBytes += source.charBytes;
+            for (size_t row = 0; row < count; ++row) {
+                garbageBytes -= source.stringLengths[row];
+            }
+            break;
+        }
+    }
+
+    // Bitmapa NULL-i: słowami, z przesunięciem, gdy rows nie jest wielokrotnością 64
+    size_t shift = rows & 63;
+    size_t newRows = rows + count;
+    nullBitmap.resize((newRows + 63) >> 6, 0);
+    for (size_t word = 0; word < (count + 63) >> 6; ++word) {
+        uint64_t bits = source.nulls[word];
+        if (((word + 1) << 6) > count) {
+            bits &= (uint64_t(1) << (count & 63)) - 1;
+        }
+        size_t target = (rows >> 6) + word;
+        nullBitmap[target] |= bits << shift;
+        if (shift != 0 && target + 1 < nullBitmap.size()) {
+            nullBitmap[target + 1] |= bits >> (64 - shift);
+        }
+    }
+    size_t firstRow = rows;
+    rows = newRows;
+    syncView();
+    for (size_t row = firstRow; row < rows; ++row) {
+        widenZone(row);
+    }
+}
+
+void ColumnData::appendRows(const ColumnData &other, const uint32_t *selection, size_t count) {
+    reserve(rows + count);
+    for (size_t i = 0; i < count; ++i) {
+        size_t row = selection[i];
+        bool null = other.isNull(row);
+        growBitmap();
+        switch (type) {
+            case DataType::INT:
+                ints.push_back(null ? 0 : other.getInt(row));
+                break;
+            case DataType::FLOAT:
+                floats.push_back(null ? 0.0 : other.getFloat(row));
+                break;
+            case DataType::STRING:
+                pushString(null ? std::string_view() : other.getString(row));
+                break;
+        }
+        markNull(rows, null);
+        ++rows;
+    }
+    syncView();
+    for (size_t row = rows - count; row < rows; ++row) {
+        widenZone(row);
+    }
+}
+
+namespace {
+    template<typename T>
+    void putValue(std::string &out, T value) {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void putArray(std::string &out, const void *data, size_t bytes) {
+        out.append(static_cast<const char *>(data), bytes);
+    }
+
+    bool getArray(const char *&cursor, const char *end, void *data, size_t bytes) {
+        if (static_cast<size_t>(end - cursor) < bytes) {
+            return false;
+        }
+        std::memcpy(data, cursor, bytes);
+        cursor += bytes;
+        return true;
+    }
+}
+
+void ColumnData::serialize(std::string &out) const {
+    putValue(out, static_cast<uint8_t>(type));
+    putValue(out, static_cast<uint64_t>(rows));
+    putArray(out, view.nulls, ((rows + 63) >> 6) * sizeof(uint64_t));
+    switch (type) {
+        case DataType::INT:
+            putArray(out, view.ints, rows * sizeof(int64_t));
+            break;
+        case DataType::FLOAT:
+            putArray(out, view.floats, rows * sizeof(double));
+            break;
+        case DataType::STRING:
+            if (view.codes) {
+                for (size_t row = 0; row < rows; ++row) {
+                    putValue(out, static_cast<uint32_t>(getString(row).size()));
+                }
+            } else {
+                putArray(out, view.stringLengths, rows * sizeof(uint32_t));
+            }
+            for (size_t row = 0; row < rows; ++row) {
+                out.append(getString(row));
+            }
+            break;
+    }
+}
+
+bool ColumnData::deserialize(const char *&cursor, const char *end) {
+    uint8_t storedType;
+    uint64_t storedRows;
+    if (!getArray(cursor, end, &storedType, sizeof(storedType)) || !getArray(cursor, end, &storedRows, sizeof(storedRows))
+        || storedType > static_cast<uint8_t>(DataType::STRING)) {
+        return false;
+    }
+    if (storedRows / 8 > static_cast<uint64_t>(end - cursor)) {
+        return false;
+    }
+    *this = ColumnData(static_cast<DataType>(storedType));
+    rows = storedRows;
+    nullBitmap.resize((rows + 63) >> 6);
+    bool ok = getArray(cursor, end, nullBitmap.data(), nullBitmap.size() * sizeof(uint64_t));
+    switch (type) {
+        case DataType::INT:
+            ints.resize(rows);
+            ok = ok && getArray(cursor, end, ints.data(), rows * sizeof(int64_t));
+            break;
+        case DataType::FLOAT:
+            floats.resize(rows);
+            ok = ok && getArray(cursor, end, floats.data(), rows * sizeof(double));
+            break;
+        case DataType::STRING: {
+            stringLengths.resize(rows);
+            stringOffsets.resize(rows);
+            ok = ok && getArray(cursor, end, stringLengths.data(), rows * sizeof(uint32_t));
+            uint64_t offset = 0;
+            for (size_t row = 0; ok && row < rows; ++row) {
+                stringOffsets[row] = offset;
+                offset += stringLengths[row];
+            }
+            chars.resize(offset);
+            ok = ok && getArray(cursor, end, chars.data(), offset);
+            break;
+        }
+    }
+    syncView();
+    if (ok) {
+        rebuildZones();
+    }
+    return ok;
+}
+
+void ColumnData::set(size_t row, const std::string &value) {
+    ensureOwned();
+    bool wasNull = isNull(row);
+    switch (type) {
+        case DataType::INT:
+            ints[row] = 0;
+            parseIntValue(value, ints[row]);
+            break;
+        case DataType::FLOAT:
+            floats[row] = 0.0;
+            parseFloatValue(value, floats[row]);
+            break;
+        case DataType::STRING:
+            if (codeWidth != 0) {
+                storeCode(row, internString(value));
+                break;
+            }
+            garbageBytes += stringLengths[row];
+            stringLengths[row] = 0;
+            storeString(row, value);
+            break;
+    }
+    markNull(row, type != DataType::STRING && value.empty());
+    syncView();
+    zones[row / ZONE_ROWS].nullCount -= wasNull;
+    widenZone(row);
+}
+
+void ColumnData::setNull(size_t row) {
+    ensureOwned();
+    bool wasNull = isNull(row);
+    if (codeWidth != 0) {
+        storeCode(row, internString(std::string_view()));
+    } else if (type == DataType::STRING) {
+        garbageBytes += stringLengths[row];
+        stringLengths[row] = 0;
+    }
+    markNull(row, true);
+    syncView();
+    zones[row / ZONE_ROWS].nullCount -= wasNull;
+    widenZone(row);
+}
+
+void ColumnData::compact(const std::vector<bool> &keep) {
+    ensureOwned();
+    size_t out = 0;
+    for (size_t row = 0; row < rows; ++row) {
+        if (!keep[row]) {
+            if (type == DataType::STRING && codeWidth == 0) {
+                garbageBytes += stringLengths[row];
+            }
+            continue;
+        }
+        if (out != row) {
+            switch (type) {
+                case DataType::INT:
+                    ints[out] = ints[row];
+                    break;
+                case DataType::FLOAT:
+                    floats[out] = floats[row];
+                    break;
+                case DataType::STRING:
+                    if (codeWidth != 0) {
+                        std::memcpy(codes.data() + out * codeWidth, codes.data() + row * codeWidth, codeWidth);
+                        break;
+                    }
+                    stringOffsets[out] = stringOffsets[row];
+                    stringLengths[out] = stringLengths[row];
+                    break;
+            }
+            markNull(out, isNull(row));
+        }
+        ++out;
+    }
+    rows = out;
+    ints.resize(type == DataType::INT ? rows : 0);
+    floats.resize(type == DataType::FLOAT ? rows : 0);
+    if (codeWidth != 0) {
+        codes.resize(rows * codeWidth);
+    } else {
+        stringOffsets.resize(type == DataType::STRING ? rows : 0);
+        stringLengths.resize(type == DataType::STRING ? rows : 0);
+    }
+    nullBitmap.resize((rows + 63) >> 6);
+    if (type == DataType::STRING && garbageBytes > chars.size() / 2) {
+        compactChars();
+    }
+    syncView();
+    rebuildZones();
+}
+
+void ColumnData::compactStrings() {
+    if (isDictionaryEncoded()) {
+        encodeDictionary();
+    } else if (type == DataType::STRING && garbageBytes > 0) {
+        ensureOwned();
+        compactChars();
+        syncView();
+    }
+}
+
+void ColumnData::compactChars() {
+    PooledVector<char> packed;
+    packed.reserve(chars.size() - garbageBytes);
+    for (size_t row = 0; row < rows; ++row) {
+        uint64_t offset = packed.size();
+        const char *begin = chars.data() + stringOffsets[row];
+        packed.insert(packed.end(), begin, begin + stringLengths[row]);
+        stringOffsets[row] = offset;
+    }
+    chars = std::move(packed);
+    garbageBytes = 0;
+}
+
+void ColumnData::reserve(size_t count) {
+    ensureOwned();
+    nullBitmap.reserve((count + 63) >> 6);
+    switch (type) {
+        case DataType::INT:
+            ints.reserve(count);
+            break;
+        case DataType::FLOAT:
+            floats.reserve(count);
+            break;
+        case DataType::STRING:
+            if (codeWidth != 0) {
+                codes.reserve(count * codeWidth);
+            } else {
+                stringOffsets.reserve(count);
+                stringLengths.reserve(count);
+            }
+            break;
+    }
+    syncView();
+}
+
+size_t ColumnData::memoryUsage() const {
+    return ints.capacity() * sizeof(int64_t) + floats.capacity() * sizeof(double)
+           + stringOffsets.capacity() * sizeof(uint64_t) + stringLengths.capacity() * sizeof(uint32_t)
+           + chars.capacity() + nullBitmap.capacity() * sizeof(uint64_t) + codes.capacity()
+           + dictionarySlots.capacity() * sizeof(uint32_t) + zones.capacity() * sizeof(ColumnZone);
+}
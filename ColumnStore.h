@@ -0,0 +1,286 @@
+#ifndef DATABASE_COLUMNSTORE_H
+#define DATABASE_COLUMNSTORE_H
+
+#include "PreRequistion.h"
+#include "BufferPool.h"
+#include "Memory.h"
+#include <limits>
+#include <memory>
+
+// Definicje typów danych
+enum class DataType {
+    INT, FLOAT, STRING
+};
+
+DataType getTypeFromString(const std::string &typeString);
+
+std::string getTypeName(DataType type);
+
+// Parsowanie liczb przez std::from_chars (dopuszczalny wiodący '+'), cały napis musi być liczbą
+bool parseIntValue(std::string_view text, int64_t &value);
+
+bool parseFloatValue(std::string_view text, double &value);
+
+// Wskaźniki na tablice kolumny - do własnych wektorów albo do zmapowanego pliku migawki
+struct ColumnArrays {
+    const int64_t *ints = nullptr;
+    const double *floats = nullptr;
+    const uint64_t *stringOffsets = nullptr;
+    const uint32_t *stringLengths = nullptr;
+    const char *chars = nullptr;
+    size_t charBytes = 0;
+    const uint64_t *nulls = nullptr;
+    // Kodowanie słownikowe STRING: codes[row] (codeWidth = 1, 2 albo 4 bajty) to numer wpisu słownika,
+    // a stringOffsets/stringLengths/chars opisują dictionarySize wpisów zamiast wierszy
+    const uint8_t *codes = nullptr;
+    uint32_t codeWidth = 0;
+    size_t dictionarySize = 0;
+    bool sortedDictionary = false; // wpisy rosnąco - porządek kodów = porządek napisów
+    const PagedFile *pages = nullptr; // strony pliku, do którego wskazują tablice zmapowane
+};
+
+// Statystyki bloku ZONE_ROWS wierszy (zone map): zakres wartości INT/FLOAT i liczba NULL-i.
+// Zakres po aktualizacjach może być szerszy od rzeczywistego (nadpisana wartość go nie zawęża),
+// nigdy węższy - wystarcza do pomijania bloków, które na pewno nie spełniają warunku.
+struct ColumnZone {
+    int64_t minInt = std::numeric_limits<int64_t>::max();
+    int64_t maxInt = std::numeric_limits<int64_t>::min();
+    double minFloat = std::numeric_limits<double>::infinity();
+    double maxFloat = -std::numeric_limits<double>::infinity();
+    uint32_t nullCount = 0;
+    uint32_t nanCount = 0; // FLOAT: wartości NaN, nieujęte w zakresie
+};
+
+// Kolumnowe przechowywanie wartości jednej kolumny tabeli.
+// INT i FLOAT trzymane są w ciągłych tablicach natywnych (int64/double) z bitmapą NULL-i,
+// STRING jako przesunięcia do jednego wspólnego bufora znaków albo - przy małej liczbie
+// różnych wartości - jako kody 8/16/32-bitowe do posortowanego słownika (optimizeEncoding).
+// Kolumna wczytana z migawki czyta tablice wprost z mapowania pliku i kopiuje je
+// do własnych wektorów dopiero przy pierwszej modyfikacji.
+class ColumnData {
+public:
+    explicit ColumnData(DataType columnType = DataType::STRING);
+
+    ColumnData(const ColumnData &) = delete;
+
+    ColumnData &operator=(const ColumnData &) = delete;
+
+    ColumnData(ColumnData &&) = default;
+
+    ColumnData &operator=(ColumnData &&) = default;
+
+    DataType getType() const { return type; }
+
+    size_t size() const { return rows; }
+
+    bool isNull(size_t row) const {
+        return (view.nulls[row >> 6] >> (row & 63)) & 1;
+    }
+
+    int64_t getInt(size_t row) const { return view.ints[row]; }
+
+    double getFloat(size_t row) const { return view.floats[row]; }
+
+    std::string_view getString(size_t row) const {
+        size_t entry = view.codes ? codeAt(row) : row;
+        return {view.chars + view.stringOffsets[entry], view.stringLengths[entry]};
+    }
+
+    bool isDictionaryEncoded() const { return view.codes != nullptr; }
+
+    // Kod wiersza kolumny kodowanej słownikiem (wiersze NULL mają kod pustego napisu)
+    uint32_t codeAt(size_t row) const {
+        switch (view.codeWidth) {
+            case 1:
+                return view.codes[row];
+            case 2: {
+                uint16_t code;
+                std::memcpy(&code, view.codes + row * 2, sizeof(code));
+                return code;
+            }
+            default: {
+                uint32_t code;
+                std::memcpy(&code, view.codes + row * 4, sizeof(code));
+                return code;
+            }
+        }
+    }
+
+    size_t dictionarySize() const { return view.dictionarySize; }
+
+    std::string_view dictionaryEntry(size_t code) const {
+        return {view.chars + view.stringOffsets[code], view.stringLengths[code]};
+    }
+
+    // Wartość w postaci tekstowej (NULL -> pusty napis)
+    std::string getAsString(size_t row) const;
+
+    const int64_t *intData() const { return view.ints; }
+
+    const double *floatData() const { return view.floats; }
+
+    const uint64_t *nullData() const { return view.nulls; }
+
+    const ColumnArrays &arrays() const { return view; }
+
+    bool isMapped() const { return backing != nullptr; }
+
+    // Właściciel zmapowanej pamięci (pusty dla kolumny we własnych tablicach) - pozwala sprawdzić,
+    // czy kolumna nie została w międzyczasie skopiowana albo podmieniona
+    const std::shared_ptr<const void> &mapping() const { return backing; }
+
+    // Kopia kolumny we własnych tablicach (to, co robi pierwszy zapis do kolumny zmapowanej) z miejscem
+    // na capacity wierszy. Tylko czyta, więc może działać pod blokadą współdzieloną obok zapytań
+    ColumnData materialized(size_t capacity) const;
+
+    // Przypina strony zmapowanych tablic z wierszami [first, last) (BufferPool); kolumna w pamięci - nic
+    void pinRows(size_t first, size_t last, PageGuard &guard) const;
+
+    // Asynchroniczny odczyt tych stron z wyprzedzeniem
+    void prefetchRows(size_t first, size_t last) const;
+
+    // Podpina tablice z zewnętrznej pamięci (np. mmap); backing utrzymuje ją przy życiu.
+    // Bez zapisanych statystyk bloków (zoneMaps o złej długości) są one liczone od nowa.
+    void attach(std::shared_ptr<const void> owner, size_t rowCount, const ColumnArrays &external,
+                std::vector<ColumnZone> zoneMaps = {});
+
+    // Zastępuje zawartość count wierszami NULL (null) albo wartości value bez wypełniania tablic: liczby
+    // i kody słownika (jeden wpis) czytane są z wyzerowanej pamięci (ZeroRegion), a kolumnę do własnych tablic
+    // kopiuje pierwszy zapis jak przy kolumnie z migawki (Database - wcześniej, przez materialized). Własna
+    // pamięć to tylko bitmapa NULL-i (bit na wiersz) przy null. false (bez zmian), gdy wartości nie da się
+    // zapisać zerami - INT/FLOAT != 0.
+    bool attachRepeated(const std::string &value, bool null, size_t count);
+
+    static constexpr size_t ZONE_ROWS = 64 * 1024;
+
+    // Statystyki bloku: zoneMaps()[row / ZONE_ROWS]
+    const std::vector<ColumnZone> &zoneMaps() const { return zones; }
+
+    // Usuwa z bufora znaków napisy nadpisane przez aktualizacje (ze słownika: wpisy bez wierszy)
+    void compactStrings();
+
+    // Kolumna STRING od DICTIONARY_MIN_ROWS wierszy: słownik, gdy wartość powtarza się średnio
+    // co najmniej DICTIONARY_MIN_REPEAT razy, w przeciwnym razie zwykłe napisy. Słownik jest przy tym
+    // budowany od nowa - posortowany i bez nieużywanych wpisów.
+    void optimizeEncoding();
+
+    // false (bez zmian), gdy różnych wartości jest za dużo na słownik
+    bool encodeDictionary();
+
+    void decodeDictionary();
+
+    static constexpr size_t DICTIONARY_MIN_ROWS = 4096;
+    static constexpr size_t DICTIONARY_MIN_REPEAT = 2;
+
+    // Wartość musi być wcześniej sprawdzona przez Column::isValidType.
+    // Pusty napis w kolumnie liczbowej oznacza NULL.
+    void append(const std::string &value);
+
+    // Dopisanie wartości natywnej; typ musi zgadzać się z typem kolumny
+    void appendInt(int64_t value);
+
+    void appendFloat(double value);
+
+    void appendString(std::string_view value);
+
+    void appendNull();
+
+    void appendNulls(size_t count);
+
+    // count razy ta sama wartość (jak append); bez pętli po wierszach tam, gdzie to możliwe.
+    // Pusta kolumna STRING od DICTIONARY_MIN_ROWS wierszy dostaje od razu słownik z jednym wpisem.
+    void appendRepeated(const std::string &value, size_t count);
+
+    // Parsuje i dopisuje wartość; false (bez zmian w kolumnie), gdy nie pasuje do typu
+    bool appendParsed(std::string_view value);
+
+    // Dopisuje wszystkie wiersze innej kolumny tego samego typu
+    void appendColumn(const ColumnData &other);
+
+    // Dopisuje wybrane wiersze innej kolumny tego samego typu (np. projekcja wyniku zapytania)
+    void appendRows(const ColumnData &other, const uint32_t *selection, size_t count);
+
+    // Binarny zapis wartości kolumny (np. do dziennika WAL) i odczyt; deserialize przesuwa cursor
+    void serialize(std::string &out) const;
+
+    bool deserialize(const char *&cursor, const char *end);
+
+    void set(size_t row, const std::string &value);
+
+    void setNull(size_t row);
+
+    // Usuwa wiersze, dla których keep[row] == false, zachowując kolejność pozostałych
+    void compact(const std::vector<bool> &keep);
+
+    void reserve(size_t count);
+
+    size_t memoryUsage() const;
+
+private:
+    void ensureOwned();
+
+    void syncView();
+
+    void markNull(size_t row, bool null);
+
+    void growBitmap();
+
+    // Bity NULL wierszy [first, last), całymi słowami bitmapy
+    void markNullRange(size_t first, size_t last, bool null);
+
+    void storeString(size_t row, std::string_view value);
+
+    void compactChars();
+
+    // Dopisanie napisu w bieżącym kodowaniu
+    void pushString(std::string_view value);
+
+    // Kod wartości w słowniku; nowa wartość trafia na koniec słownika (ew. z poszerzeniem kodów)
+    uint32_t internString(std::string_view value);
+
+    void storeCode(size_t row, uint32_t code);
+
+    void widenCodes(uint32_t width);
+
+    void rebuildDictionarySlots();
+
+    // Dolicza wiersz do statystyk jego bloku; czyta przez view, więc po syncView
+    void widenZone(size_t row);
+
+    void rebuildZones();
+
+    // Jak widenZone dla wierszy [first, last) o tej samej wartości - raz na blok
+    void widenZonesRepeated(size_t first, size_t last);
+
+    DataType type;
+    size_t rows = 0;
+
+    // Tablice z puli bloków (BlockPool), żeby kolumny wyników i tabel nie fragmentowały sterty
+    PooledVector<int64_t> ints;
+    PooledVector<double> floats;
+
+    PooledVector<uint64_t> stringOffsets;
+    PooledVector<uint32_t> stringLengths;
+    PooledVector<char> chars;
+    size_t garbageBytes = 0; // bajty w chars nadpisane przez aktualizacje
+
+    PooledVector<uint64_t> nullBitmap;
+
+    PooledVector<uint8_t> codes;             // codeWidth bajtów na wiersz; puste bez słownika
+    uint32_t codeWidth = 0;
+    bool sortedDictionary = false;
+    std::vector<uint32_t> dictionarySlots;  // napis -> kod (adresowanie otwarte), budowane przy pierwszym dopisaniu
+
+    std::vector<ColumnZone> zones;
+
+    ColumnArrays view;
+    std::shared_ptr<const void> backing;
+};
+
+// Morsel skanu po kolumnach zmapowanych z migawki: przypina wiersze [firstRow, firstRow + count)
+// i zleca odczyt z wyprzedzeniem tylu samych wierszy od aheadRow (morsela, po który sięgnie
+// następny wolny wątek puli)
+void pinScanMorsel(const std::vector<const ColumnData *> &columns, size_t firstRow, size_t count, size_t aheadRow,
+                   PageGuard &guard);
+
+#endif //DATABASE_COLUMNSTORE_H
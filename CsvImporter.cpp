@@ -0,0 +1,215 @@
+#include "CsvImporter.h"
+#include "Diagnostics.h"
+#include "ThreadPool.h"
+
+namespace {
+    // Wynik parsowania jednego fragmentu porcji
+    struct ParsedRange {
+        RowBatch batch;
+        size_t lines = 0;
+        size_t errorLine = 0; // numer wiersza w obrębie fragmentu, od 1
+        std::string error;
+    };
+
+    // Dzieli wiersz na pola; unquoted trzyma pola z podwojonymi cudzysłowami
+    bool splitFields(std::string_view line, char delimiter, std::vector<std::string_view> &fields,
+                     std::vector<std::string> &unquoted) {
+        fields.clear();
+        size_t scratch = 0;
+        size_t position = 0;
+        while (true) {
+            if (position < line.size() && line[position] == '"') {
+                size_t close = position + 1;
+                bool escaped = false;
+                while (true) {
+                    close = line.find('"', close);
+                    if (close == std::string_view::npos) {
+                        return false;
+                    }
+                    if (close + 1 < line.size() && line[close + 1] == '"') {
+                        escaped = true;
+                        close += 2;
+                        continue;
+                    }
+                    break;
+                }
+                std::string_view field = line.substr(position + 1, close - position - 1);
+                if (escaped) {
+                    if (scratch == unquoted.size()) {
+                        unquoted.emplace_back();
+                    }
+                    std::string &value = unquoted[scratch++];
+                    value.clear();
+                    for (size_t i = 0; i < field.size(); ++i) {
+                        value += field[i];
+                        if (field[i] == '"') {
+                            ++i;
+                        }
+                    }
+                    field = value;
+                }
+                fields.push_back(field);
+                position = close + 1;
+                if (position == line.size()) {
+                    return true;
+                }
+                if (line[position] != delimiter) {
+                    return false;
+                }
+                ++position;
+                continue;
+            }
+            size_t next = line.find(delimiter, position);
+            if (next == std::string_view::npos) {
+                fields.push_back(line.substr(position));
+                return true;
+            }
+            fields.push_back(line.substr(position, next - position));
+            position = next + 1;
+        }
+    }
+
+    void parseRange(std::string_view text, const std::vector<Column> &targets, char delimiter, ParsedRange &result) {
+        for (const Column &target : targets) {
+            result.batch.columnNames.push_back(target.name);
+            result.batch.columns.emplace_back(target.type);
+        }
+        std::vector<std::string_view> fields;
+        std::vector<std::string> unquoted;
+        size_t position = 0;
+        while (position < text.size()) {
+            size_t end = text.find('\n', position);
+            if (end == std::string_view::npos) {
+                end = text.size();
+            }
+            std::string_view line = text.substr(position, end - position);
+            position = end + 1;
+            ++result.lines;
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (line.empty()) {
+                continue;
+            }
+            if (!splitFields(line, delimiter, fields, unquoted) || fields.size() != targets.size()) {
+                result.errorLine = result.lines;
+                result.error = "Expected " + std::to_string(targets.size()) + " fields";
+                return;
+            }
+            for (size_t i = 0; i < fields.size(); ++i) {
+                if (!result.batch.columns[i].appendParsed(fields[i])) {
+                    result.errorLine = result.lines;
+                    result.error = "Invalid value " + std::string(fields[i]) + " for column " + targets[i].name;
+                    return;
+                }
+            }
+        }
+    }
+}
+
+size_t CsvImporter::importFile(Database &database, const std::string &tableName, const std::string &fileName,
+                               const CsvOptions &options) {
+    std::vector<Column> schema = database.getSchema(tableName);
+    if (schema.empty()) {
+        return 0;
+    }
+    std::ifstream inputFile(fileName, std::ios::binary);
+    if (!inputFile) {
+        errorStream() << "Failed to open file: " << fileName << std::endl;
+        return 0;
+    }
+
+    // Kolumny docelowe kolejnych pól
+    std::vector<Column> targets;
+    size_t lineNumber = 0;
+    if (options.hasHeader) {
+        std::string header;
+        std::getline(inputFile, header);
+        ++lineNumber;
+        if (!header.empty() && header.back() == '\r') {
+            header.pop_back();
+        }
+        std::vector<std::string_view> names;
+        std::vector<std::string> unquoted;
+        if (!splitFields(header, options.delimiter, names, unquoted)) {
+            errorStream() << "Malformed header in " << fileName << "." << std::endl;
+            return 0;
+        }
+        for (std::string_view name : names) {
+            auto colIt = std::find_if(schema.begin(), schema.end(), [name](const Column &col) { return col.name == name; });
+            if (colIt == schema.end()) {
+                errorStream() << "Column " << name << " does not exist in table " << tableName << "." << std::endl;
+                return 0;
+            }
+            targets.push_back(*colIt);
+        }
+    } else {
+        targets = schema;
+    }
+
+    ThreadPool &pool = ThreadPool::shared();
+    unsigned threads = options.threads != 0 ? options.threads : pool.concurrency();
+    std::vector<char> buffer;
+    std::string carry;
+    size_t inserted = 0;
+    while (true) {
+        // Porcja = niedokończony wiersz z poprzedniej porcji + nowe dane do ostatniego '\n'
+        buffer.assign(carry.begin(), carry.end());
+        size_t carried = buffer.size();
+        buffer.resize(carried + options.chunkBytes);
+        inputFile.read(buffer.data() + carried, static_cast<std::streamsize>(options.chunkBytes));
+        buffer.resize(carried + static_cast<size_t>(inputFile.gcount()));
+        bool lastChunk = !inputFile;
+        if (buffer.empty()) {
+            break;
+        }
+        std::string_view chunk(buffer.data(), buffer.size());
+        if (!lastChunk) {
+            size_t lastNewline = chunk.rfind('\n');
+            if (lastNewline == std::string_view::npos) {
+                carry.assign(chunk);
+                continue;
+            }
+            carry.assign(chunk.substr(lastNewline + 1));
+            chunk = chunk.substr(0, lastNewline + 1);
+        }
+
+        // Podział porcji na fragmenty kończące się na granicy wiersza
+        std::vector<std::string_view> ranges;
+        size_t start = 0;
+        for (unsigned part = 1; part <= threads && start < chunk.size(); ++part) {
+            size_t end = part == threads ? chunk.size() : chunk.size() * part / threads;
+            if (end < start) {
+                end = start;
+            }
+            if (end < chunk.size()) {
+                size_t newline = chunk.find('\n', end);
+                end = newline == std::string_view::npos ? chunk.size() : newline + 1;
+            }
+            ranges.push_back(chunk.substr(start, end - start));
+            start = end;
+        }
+
+        std::vector<ParsedRange> results(ranges.size());
+        pool.parallelFor(ranges.size(), [&](size_t i, unsigned) {
+            parseRange(ranges[i], targets, options.delimiter, results[i]);
+        });
+
+        for (auto &result : results) {
+            if (!result.error.empty()) {
+                errorStream() << result.error << " at line " << lineNumber + result.errorLine << " of " << fileName << "."
+                          << std::endl;
+                return inserted;
+            }
+            if (!database.insertBatch(tableName, result.batch)) {
+                return inserted;
+            }
+            inserted += result.batch.rowCount();
+            lineNumber += result.lines;
+        }
+        if (lastChunk) {
+            break;
+        }
+    }
+    return inserted;
+}
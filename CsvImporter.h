@@ -0,0 +1,26 @@
+#ifndef DATABASE_CSVIMPORTER_H
+#define DATABASE_CSVIMPORTER_H
+
+#include "PreRequistion.h"
+#include "Database.h"
+
+struct CsvOptions {
+    char delimiter = ',';          // '\t' dla TSV
+    bool hasHeader = true;         // pierwszy wiersz to nazwy kolumn; bez niego pola idą w kolejności Column::index
+    size_t chunkBytes = 16 << 20;  // rozmiar porcji czytanej z pliku
+    unsigned threads = 0;          // liczba fragmentów porcji parsowanych na wspólnej puli (0 = ThreadPool::concurrency)
+};
+
+// Strumieniowe ładowanie CSV/TSV: plik czytany dużymi porcjami, każda porcja dzielona na
+// granicach wierszy i parsowana równolegle do kolumnowych RowBatch, które trafiają do
+// Database::insertBatch w kolejności pliku. Pola w cudzysłowach ("" jako cudzysłów) są
+// obsługiwane, ale nie mogą zawierać znaku nowej linii.
+class CsvImporter {
+public:
+    // Zwraca liczbę wstawionych wierszy. Błąd w danych albo odrzucony wsad przerywa import;
+    // porcje wstawione wcześniej zostają w tabeli.
+    static size_t importFile(Database &database, const std::string &tableName, const std::string &fileName,
+                             const CsvOptions &options = CsvOptions());
+};
+
+#endif //DATABASE_CSVIMPORTER_H
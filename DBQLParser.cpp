@@ -1,90 +1,699 @@
 #include "DBQLParser.h"
+#include "Diagnostics.h"
+#include <cctype>
+#include <cstdio>
+
+namespace {
+    // Znaki kończące słowo i tworzące własne leksemy
+    const std::string_view SPECIAL_CHARACTERS = ",()*;?'\"=!<>";
+
+    bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+    }
+
+    // Liczba bez cudzysłowów: cyfra, opcjonalnie po znaku albo kropce
+    bool looksNumeric(std::string_view text) {
+        size_t position = 0;
+        while (position < text.size() && (text[position] == '-' || text[position] == '+' || text[position] == '.')) {
+            ++position;
+        }
+        return position < text.size() && std::isdigit(static_cast<unsigned char>(text[position]));
+    }
+
+    // Parser zejść rekurencyjnych nad leksemami DBQLLexer
+    class StatementParser {
+    public:
+        StatementParser(std::string_view query, Statement &statement) : lexer(query), statement(statement) {}
+
+        bool parse() {
+            Token token = lexer.next();
+            if (token.is("EXPLAIN")) {
+                statement.explain = skipKeyword("ANALYZE") ? ExplainMode::ANALYZE : ExplainMode::PLAN;
+                token = lexer.next();
+                if (!token.is("SELECT")) {
+                    return fail(token, "SELECT");
+                }
+            }
+            if (token.is("SELECT")) {
+                return parseSelect();
+            }
+            if (token.is("INSERT")) {
+                return parseInsert();
+            }
+            if (token.is("UPDATE")) {
+                return parseUpdate();
+            }
+            if (token.is("DELETE")) {
+                return parseDelete();
+            }
+            if (token.is("CREATE")) {
+                return parseCreate();
+            }
+            if (token.is("DROP")) {
+                return parseDrop();
+            }
+            if (token.is("ALTER")) {
+                return parseAlter();
+            }
+            return fail(token, "SELECT, INSERT, UPDATE, DELETE, CREATE, DROP or ALTER");
+        }
+
+        // Sam warunek WHERE (Database::select przyjmuje go jako tekst)
+        bool parseConditionsOnly() {
+            if (lexer.peek().type == TokenType::END) {
+                return true;
+            }
+            return parseConditions() && finish();
+        }
+
+    private:
+        bool parseSelect() {
+            statement.type = StatementType::SELECT;
+            do {
+                Token token = lexer.next();
+                if (token.type == TokenType::STAR) {
+                    statement.columns.emplace_back("*");
+                    continue;
+                }
+                if (token.type != TokenType::WORD || token.is("FROM")) {
+                    return fail(token, "column name");
+                }
+                std::string item(token.text);
+                if (!aggregateArgument(item)) {
+                    return false;
+                }
+                statement.columns.push_back(std::move(item));
+            } while (skip(TokenType::COMMA));
+
+            if (!expectKeyword("FROM") || !name(statement.tableName, "table name")) {
+                return false;
+            }
+            if (skipKeyword("JOIN")) {
+                JoinClause &join = statement.join;
+                if (!name(join.tableName, "table name") || !expectKeyword("ON") || !name(join.leftColumn, "column name")
+                    || !expectEquals() || !name(join.rightColumn, "column name")) {
+                    return false;
+                }
+            }
+            if (skipKeyword("WHERE") && !parseConditions()) {
+                return false;
+            }
+            if (skipKeyword("GROUP")) {
+                if (!expectKeyword("BY")) {
+                    return false;
+                }
+                do {
+                    if (!name(statement.groupBy.emplace_back(), "column name")) {
+                        return false;
+                    }
+                } while (skip(TokenType::COMMA));
+            }
+            if (skipKeyword("ORDER")) {
+                if (!expectKeyword("BY")) {
+                    return false;
+                }
+                do {
+                    OrderKey &key = statement.orderBy.emplace_back();
+                    if (!name(key.column, "column name") || !aggregateArgument(key.column)) {
+                        return false;
+                    }
+                    key.descending = skipKeyword("DESC");
+                    if (!key.descending) {
+                        skipKeyword("ASC");
+                    }
+                } while (skip(TokenType::COMMA));
+            }
+            if (skipKeyword("LIMIT")) {
+                if (!parseValue(statement.limit, ParameterSlot::Kind::LIMIT, 0)) {
+                    return false;
+                }
+                if (skipKeyword("OFFSET") && !parseValue(statement.offset, ParameterSlot::Kind::OFFSET, 0)) {
+                    return false;
+                }
+            }
+            return finish();
+        }
+
+        bool parseInsert() {
+            statement.type = StatementType::INSERT;
+            if (!expectKeyword("INTO") || !name(statement.tableName, "table name")) {
+                return false;
+            }
+            if (skip(TokenType::LEFT_PAREN)) {
+                do {
+                    if (!name(statement.columns.emplace_back(), "column name")) {
+                        return false;
+                    }
+                } while (skip(TokenType::COMMA));
+                if (!expect(TokenType::RIGHT_PAREN, ")")) {
+                    return false;
+                }
+            }
+            if (!expectKeyword("VALUES")) {
+                return false;
+            }
+            do {
+                if (!expect(TokenType::LEFT_PAREN, "(")) {
+                    return false;
+                }
+                size_t count = 0;
+                do {
+                    statement.values.emplace_back();
+                    if (!parseValue(statement.values.back(), ParameterSlot::Kind::VALUE, statement.values.size() - 1)) {
+                        return false;
+                    }
+                    ++count;
+                } while (skip(TokenType::COMMA));
+                if (!expect(TokenType::RIGHT_PAREN, ")")) {
+                    return false;
+                }
+                if (statement.rowWidth != 0 && count != statement.rowWidth) {
+                    errorStream() << "All VALUES rows must have the same number of values." << std::endl;
+                    return false;
+                }
+                statement.rowWidth = count;
+            } while (skip(TokenType::COMMA));
+            if (!statement.columns.empty() && statement.columns.size() != statement.rowWidth) {
+                errorStream() << "INSERT lists " << statement.columns.size() << " columns but "
+                              << statement.rowWidth << " values." << std::endl;
+                return false;
+            }
+            return finish();
+        }
+
+        bool parseUpdate() {
+            statement.type = StatementType::UPDATE;
+            if (!name(statement.tableName, "table name") || !expectKeyword("SET")) {
+                return false;
+            }
+            do {
+                if (!name(statement.columns.emplace_back(), "column name") || !expectEquals()) {
+                    return false;
+                }
+                statement.values.emplace_back();
+                if (!parseValue(statement.values.back(), ParameterSlot::Kind::VALUE, statement.values.size() - 1)) {
+                    return false;
+                }
+            } while (skip(TokenType::COMMA));
+            return parseKeyCondition() && finish();
+        }
+
+        bool parseDelete() {
+            statement.type = StatementType::DELETE;
+            return expectKeyword("FROM") && name(statement.tableName, "table name") && parseKeyCondition() && finish();
+        }
+
+        bool parseCreate() {
+            Token token = lexer.next();
+            if (token.is("TABLE")) {
+                statement.type = StatementType::CREATE_TABLE;
+                if (!name(statement.tableName, "table name")) {
+                    return false;
+                }
+                if (skip(TokenType::LEFT_PAREN)) {
+                    do {
+                        if (!name(statement.columns.emplace_back(), "column name")
+                            || !parseType(statement.columnTypes.emplace_back())) {
+                            return false;
+                        }
+                    } while (skip(TokenType::COMMA));
+                    if (!expect(TokenType::RIGHT_PAREN, ")")) {
+                        return false;
+                    }
+                }
+                return finish();
+            }
+            if (!token.is("INDEX")) {
+                return fail(token, "TABLE or INDEX");
+            }
+            statement.type = StatementType::CREATE_INDEX;
+            CreateIndexStatement &index = statement.index;
+            if (!name(index.indexName, "index name") || !expectKeyword("ON") || !name(index.tableName, "table name")
+                || !expect(TokenType::LEFT_PAREN, "(") || !name(index.columnName, "column name")
+                || !expect(TokenType::RIGHT_PAREN, ")")) {
+                return false;
+            }
+            if (skipKeyword("USING")) {
+                Token method = lexer.next();
+                if (method.is("HASH") || method.is("BTREE")) {
+                    index.method = method.is("HASH") ? "HASH" : "BTREE";
+                } else {
+                    errorStream() << "Unknown index method " << method.text << "." << std::endl;
+                    return false;
+                }
+            }
+            statement.tableName = index.tableName;
+            return finish();
+        }
+
+        bool parseDrop() {
+            Token token = lexer.next();
+            if (token.is("TABLE")) {
+                statement.type = StatementType::DROP_TABLE;
+                return name(statement.tableName, "table name") && finish();
+            }
+            if (!token.is("INDEX")) {
+                return fail(token, "TABLE or INDEX");
+            }
+            statement.type = StatementType::DROP_INDEX;
+            if (!name(statement.index.indexName, "index name") || !expectKeyword("ON")
+                || !name(statement.tableName, "table name")) {
+                return false;
+            }
+            statement.index.tableName = statement.tableName;
+            return finish();
+        }
+
+        bool parseAlter() {
+            if (!expectKeyword("TABLE") || !name(statement.tableName, "table name")) {
+                return false;
+            }
+            Token token = lexer.next();
+            if (token.is("ADD")) {
+                statement.type = StatementType::ADD_COLUMN;
+                skipKeyword("COLUMN");
+                if (!name(statement.columns.emplace_back(), "column name")
+                    || !parseType(statement.columnTypes.emplace_back())) {
+                    return false;
+                }
+                if (skipKeyword("DEFAULT")
+                    && !parseValue(statement.values.emplace_back(), ParameterSlot::Kind::VALUE, 0)) {
+                    return false;
+                }
+                return finish();
+            }
+            if (token.is("DROP")) {
+                statement.type = StatementType::DROP_COLUMN;
+                skipKeyword("COLUMN");
+                return name(statement.columns.emplace_back(), "column name") && finish();
+            }
+            return fail(token, "ADD or DROP");
+        }
+
+        // warunek [AND|OR warunek ...], warunek: kolumna operator wartość albo ( warunki )
+        bool parseConditions() {
+            std::string logicalOperator;
+            while (true) {
+                if (skip(TokenType::LEFT_PAREN)) {
+                    size_t first = statement.conditions.size();
+                    if (!parseConditions() || !expect(TokenType::RIGHT_PAREN, ")")) {
+                        return false;
+                    }
+                    statement.conditions[first].logicalOperator = logicalOperator;
+                    ++statement.conditions[first].openGroups;
+                    ++statement.conditions.back().closeGroups;
+                } else {
+                    Condition &condition = statement.conditions.emplace_back();
+                    condition.logicalOperator = logicalOperator;
+                    if (!name(condition.column, "column name or (")) {
+                        return false;
+                    }
+                    Token op = lexer.next();
+                    if (op.type != TokenType::OPERATOR) {
+                        return fail(op, "comparison operator");
+                    }
+                    condition.op.assign(op.text);
+                    if (!parseValue(condition.value, ParameterSlot::Kind::CONDITION, statement.conditions.size() - 1)) {
+                        return false;
+                    }
+                }
+                if (skipKeyword("AND")) {
+                    logicalOperator = "AND";
+                } else if (skipKeyword("OR")) {
+                    logicalOperator = "OR";
+                } else {
+                    return true;
+                }
+            }
+        }
+
+        // UPDATE i DELETE wybierają wiersze jednym warunkiem kolumna = wartość
+        bool parseKeyCondition() {
+            if (!expectKeyword("WHERE") || !parseConditions()) {
+                return false;
+            }
+            const std::string &op = statement.conditions.front().op;
+            if (statement.conditions.size() != 1 || (op != "=" && op != "==")) {
+                errorStream() << "UPDATE and DELETE support a single column = value condition." << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        bool parseValue(std::string &value, ParameterSlot::Kind kind, size_t index) {
+            Token token = lexer.next();
+            switch (token.type) {
+                case TokenType::WORD:
+                    // NULL w INSERT/UPDATE to pusta wartość; w warunku pozostaje literałem
+                    if (kind == ParameterSlot::Kind::VALUE && token.is("NULL")) {
+                        value.clear();
+                    } else {
+                        value.assign(token.text);
+                    }
+                    return true;
+                case TokenType::STRING:
+                    value = token.literal();
+                    return true;
+                case TokenType::PARAMETER:
+                    value.clear();
+                    statement.parameters.push_back({kind, index});
+                    return true;
+                default:
+                    return fail(token, "value");
+            }
+        }
+
+        bool parseType(DataType &type) {
+            Token token = lexer.next();
+            if (token.is("INT")) {
+                type = DataType::INT;
+            } else if (token.is("FLOAT")) {
+                type = DataType::FLOAT;
+            } else if (token.is("STRING")) {
+                type = DataType::STRING;
+            } else {
+                return fail(token, "INT, FLOAT or STRING");
+            }
+            return true;
+        }
+
+        // Agregat: FUNKCJA(kolumna) albo FUNKCJA(*), zapisany jednym napisem jak w Database::select;
+        // item - wczytana już nazwa; bez nawiasu po niej zostaje bez zmian (zwykła kolumna)
+        bool aggregateArgument(std::string &item) {
+            if (lexer.peek().type != TokenType::LEFT_PAREN) {
+                return true;
+            }
+            lexer.next();
+            Token argument = lexer.next();
+            if (argument.type != TokenType::WORD && argument.type != TokenType::STAR) {
+                return fail(argument, "aggregate argument");
+            }
+            item.append("(").append(argument.text).append(")");
+            return expect(TokenType::RIGHT_PAREN, ")");
+        }
+
+        bool name(std::string &target, const char *what) {
+            Token token = lexer.next();
+            if (token.type != TokenType::WORD) {
+                return fail(token, what);
+            }
+            target.assign(token.text);
+            return true;
+        }
+
+        bool expect(TokenType type, const char *what) {
+            Token token = lexer.next();
+            return token.type == type || fail(token, what);
+        }
+
+        bool expectKeyword(const char *keyword) {
+            Token token = lexer.next();
+            return token.is(keyword) || fail(token, keyword);
+        }
+
+        bool expectEquals() {
+            Token token = lexer.next();
+            return (token.type == TokenType::OPERATOR && (token.text == "=" || token.text == "==")) || fail(token, "=");
+        }
+
+        bool skip(TokenType type) {
+            if (lexer.peek().type != type) {
+                return false;
+            }
+            lexer.next();
+            return true;
+        }
+
+        bool skipKeyword(const char *keyword) {
+            if (!lexer.peek().is(keyword)) {
+                return false;
+            }
+            lexer.next();
+            return true;
+        }
+
+        bool finish() {
+            skip(TokenType::SEMICOLON);
+            return expect(TokenType::END, "end of query");
+        }
+
+        bool fail(const Token &found, const char *expected) {
+            if (found.type == TokenType::INVALID) {
+                errorStream() << "Unterminated string or unexpected character at " << found.text << "." << std::endl;
+            } else if (found.type == TokenType::END) {
+                errorStream() << "Expected " << expected << " but the query ended." << std::endl;
+            } else {
+                errorStream() << "Expected " << expected << " but found '" << found.text << "'." << std::endl;
+            }
+            return false;
+        }
+
+        DBQLLexer lexer;
+        Statement &statement;
+    };
+}
+
+bool Token::is(std::string_view keyword) const {
+    if (type != TokenType::WORD || text.size() != keyword.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (std::toupper(static_cast<unsigned char>(text[i])) != keyword[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string Token::literal() const {
+    std::string value;
+    value.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        value += text[i];
+        if (type == TokenType::STRING && text[i] == quote) {
+            ++i;
+        }
+    }
+    return value;
+}
+
+Token DBQLLexer::next() {
+    if (hasLookahead) {
+        hasLookahead = false;
+        return lookahead;
+    }
+    return scan();
+}
+
+const Token &DBQLLexer::peek() {
+    if (!hasLookahead) {
+        lookahead = scan();
+        hasLookahead = true;
+    }
+    return lookahead;
+}
+
+Token DBQLLexer::scan() {
+    while (position < text.size() && isSpace(text[position])) {
+        ++position;
+    }
+    if (position == text.size()) {
+        return {TokenType::END, text.substr(position)};
+    }
+
+    size_t start = position;
+    auto single = [&](TokenType type) {
+        ++position;
+        return Token{type, text.substr(start, 1)};
+    };
+    auto op = [&](size_t length) {
+        position += length;
+        return Token{TokenType::OPERATOR, text.substr(start, length)};
+    };
+    char next = position + 1 < text.size() ? text[position + 1] : '\0';
+    switch (text[position]) {
+        case ',':
+            return single(TokenType::COMMA);
+        case '(':
+            return single(TokenType::LEFT_PAREN);
+        case ')':
+            return single(TokenType::RIGHT_PAREN);
+        case '*':
+            return single(TokenType::STAR);
+        case ';':
+            return single(TokenType::SEMICOLON);
+        case '?':
+            return single(TokenType::PARAMETER);
+        case '=':
+            return op(next == '=' ? 2 : 1);
+        case '!':
+            if (next != '=') {
+                return single(TokenType::INVALID);
+            }
+            return op(2);
+        case '<':
+            return op(next == '=' || next == '>' ? 2 : 1);
+        case '>':
+            return op(next == '=' ? 2 : 1);
+        case '\'':
+        case '"': {
+            // Podwojony cudzysłów nie zamyka literału
+            char quote = text[position];
+            size_t close = text.find(quote, position + 1);
+            while (close != std::string_view::npos && close + 1 < text.size() && text[close + 1] == quote) {
+                close = text.find(quote, close + 2);
+            }
+            if (close == std::string_view::npos) {
+                position = text.size();
+                return {TokenType::INVALID, text.substr(start)};
+            }
+            position = close + 1;
+            return {TokenType::STRING, text.substr(start + 1, close - start - 1), quote};
+        }
+        default:
+            while (position < text.size() && !isSpace(text[position])
+                   && SPECIAL_CHARACTERS.find(text[position]) == std::string_view::npos) {
+                ++position;
+            }
+            return {TokenType::WORD, text.substr(start, position - start)};
+    }
+}
 
 std::string DBQLParser::getTableName() const {
-    return std::string();
+    return statement.tableName;
 }
 
 std::vector<std::string> DBQLParser::getColumns() const {
-    return std::vector<std::string>();
+    return statement.columns;
 }
 
 std::string DBQLParser::getCondition() const {
-    return std::string();
+    // Warunek w postaci przyjmowanej przez parseConditions
+    std::string condition;
+    for (const auto &cond : statement.conditions) {
+        if (!condition.empty()) {
+            condition += " " + (cond.logicalOperator.empty() ? std::string("AND") : cond.logicalOperator) + " ";
+        }
+        condition.append(cond.openGroups, '(');
+        char quote = cond.value.find('\'') == std::string::npos ? '\'' : '"';
+        condition += cond.column + " " + cond.op + " " + quote;
+        for (char c : cond.value) {
+            condition.append(c == quote ? 2 : 1, c);
+        }
+        condition += quote;
+        condition.append(cond.closeGroups, ')');
+    }
+    return condition;
+}
+
+std::vector<std::string> DBQLParser::getGroupBy() const {
+    return statement.groupBy;
+}
+
+JoinClause DBQLParser::getJoin() const {
+    return statement.join;
+}
+
+bool DBQLParser::parseStatement(std::string_view query, Statement &statement) {
+    statement = Statement();
+    return StatementParser(query, statement).parse();
 }
 
 void DBQLParser::parse(const std::string &query) {
-    std::istringstream iss(query);
-    std::string token;
-    bool isSelecting = false, isFrom = false, isWhere = false;
-    Condition currentCondition;
-    bool expectLogicalOperator = false;
-
-    while (iss >> token) {
-        if (token == "SELECT") {
-            isSelecting = true;
-            isFrom = isWhere = false;
-        } else if (token == "FROM") {
-            isFrom = true;
-            isSelecting = isWhere = false;
-        } else if (token == "WHERE") {
-            isWhere = true;
-            isSelecting = isFrom = false;
-            currentCondition = Condition();
-        } else if (token == "AND" || token == "OR") {
-            if (expectLogicalOperator) {
-                currentCondition.logicalOperator = token;
-            } else {
-                std::cerr << "Unexpected logical operator " << token << "." << std::endl;
-                return;
-            }
+    valid = parseStatement(query, statement);
+}
+
+bool DBQLParser::normalize(std::string_view query, std::string &key, std::vector<std::string_view> &literals) {
+    key.clear();
+    literals.clear();
+    DBQLLexer lexer(query);
+    for (Token token = lexer.next(); token.type != TokenType::END; token = lexer.next()) {
+        if (token.type == TokenType::PARAMETER || token.type == TokenType::INVALID || token.escaped()) {
+            return false;
+        }
+        if (!key.empty()) {
+            key += ' ';
+        }
+        if (token.type == TokenType::STRING || (token.type == TokenType::WORD && looksNumeric(token.text))) {
+            key += '?';
+            literals.push_back(token.text);
         } else {
-            if (isSelecting) {
-                if (token.back() == ',') {
-                    token.pop_back(); // Usuwamy przecinek
-                }
-                columns.push_back(token);
-            } else if (isFrom) {
-                tableName = token;
-            } else if (isWhere) {
-                if (currentCondition.column.empty()) {
-                    currentCondition.column = token;
-                } else if (currentCondition.op.empty()) {
-                    currentCondition.op = token;
-                } else {
-                    currentCondition.value = token;
-                    conditions.push_back(currentCondition);
-                    currentCondition = Condition();
-                    expectLogicalOperator = true;
-                }
-            }
+            key.append(token.text);
         }
     }
+    return true;
 }
+
 void DBQLParser::parseConditions(const std::string& condition, std::vector<Condition>& conditions) {
-    std::istringstream iss(condition);
-    std::string token;
-    Condition currentCondition;
+    Statement statement;
+    StatementParser(condition, statement).parseConditionsOnly();
+    conditions = std::move(statement.conditions);
+}
 
-    while (iss >> token) {
-        if (token == "AND" || token == "OR") {
-            if (!currentCondition.column.empty()) {
-                conditions.push_back(currentCondition);
-                currentCondition = Condition();
-            }
-            currentCondition.logicalOperator = token;
-        } else {
-            if (currentCondition.column.empty()) {
-                currentCondition.column = token;
-            } else if (currentCondition.op.empty()) {
-                currentCondition.op = token;
-            } else {
-                currentCondition.value = token;
-                conditions.push_back(currentCondition);
-                currentCondition = Condition();
-            }
-        }
+bool DBQLParser::parseCreateIndex(const std::string& query, CreateIndexStatement& statement) {
+    Statement parsed;
+    if (!parseStatement(query, parsed)) {
+        return false;
+    }
+    if (parsed.type != StatementType::CREATE_INDEX) {
+        errorStream() << "Expected CREATE INDEX <name> ON <table> (<column>) [USING HASH|BTREE]." << std::endl;
+        return false;
+    }
+    statement = parsed.index;
+    return true;
+}
+
+std::string &Statement::parameterValue(const ParameterSlot &slot) {
+    switch (slot.kind) {
+        case ParameterSlot::Kind::CONDITION:
+            return conditions[slot.index].value;
+        case ParameterSlot::Kind::LIMIT:
+            return limit;
+        case ParameterSlot::Kind::OFFSET:
+            return offset;
+        default:
+            return values[slot.index];
+    }
+}
+
+bool Statement::paged() const {
+    return !limit.empty() || !offset.empty()
+           || std::any_of(parameters.begin(), parameters.end(), [](const ParameterSlot &slot) {
+               return slot.kind == ParameterSlot::Kind::LIMIT || slot.kind == ParameterSlot::Kind::OFFSET;
+           });
+}
+
+PreparedStatement::PreparedStatement(const std::string &query) : text(query) {
+    ErrorCapture capture;
+    if (!DBQLParser::parseStatement(query, statement)) {
+        error = capture.str();
     }
-    if (!currentCondition.column.empty()) {
-        conditions.push_back(currentCondition);
+    bound.assign(statement.parameters.size(), false);
+}
+
+bool PreparedStatement::bind(size_t index, const std::string &value) {
+    if (index >= statement.parameters.size()) {
+        return false;
     }
-}
\ No newline at end of file
+    statement.parameterValue(statement.parameters[index]) = value;
+    bound[index] = true;
+    return true;
+}
+
+bool PreparedStatement::bindInt(size_t index, int64_t value) {
+    return bind(index, std::to_string(value));
+}
+
+bool PreparedStatement::bindFloat(size_t index, double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.17g", value);
+    return bind(index, text);
+}
+
+bool PreparedStatement::bindNull(size_t index) {
+    return bind(index, std::string());
+}
+
+size_t PreparedStatement::firstUnbound() const {
+    return std::find(bound.begin(), bound.end(), false) - bound.begin();
+}
@@ -1,11 +1,15 @@
 #ifndef DATABASE_DBQLPARSER_H
 #define DATABASE_DBQLPARSER_H
 #include "PreRequistion.h"
+#include "ColumnStore.h"
 struct Condition {
     std::string column;
     std::string op;
     std::string value;
     std::basic_string<char> logicalOperator;
+    // Nawiasy: grupy otwierane tuż przed warunkiem (po logicalOperator) i zamykane tuż po nim
+    size_t openGroups = 0;
+    size_t closeGroups = 0;
 };
 
 struct Query {
@@ -15,6 +19,123 @@ struct Query {
     std::vector<std::string> logicalOperators; // AND, OR
 };
 
+// FROM tabela JOIN joinTable ON leftColumn = rightColumn (nazwy kolumn mogą mieć prefiks "tabela.")
+struct JoinClause {
+    std::string tableName;
+    std::string leftColumn;
+    std::string rightColumn;
+};
+
+// ORDER BY kolumna [ASC|DESC]; kolumna albo agregat w postaci jak na liście SELECT, np. COUNT(*)
+struct OrderKey {
+    std::string column;
+    bool descending = false;
+};
+
+// CREATE INDEX nazwa ON tabela (kolumna) [USING HASH|BTREE]
+struct CreateIndexStatement {
+    std::string indexName;
+    std::string tableName;
+    std::string columnName;
+    std::string method = "BTREE";
+};
+
+enum class TokenType {
+    WORD,        // nazwa, słowo kluczowe albo literał bez cudzysłowów (np. a.x, 12, -3.5)
+    STRING,      // literał w cudzysłowach; text bez cudzysłowów, cudzysłów wewnątrz podwojony ('it''s')
+    OPERATOR,    // = == != <> < <= > >=
+    COMMA, LEFT_PAREN, RIGHT_PAREN, STAR, SEMICOLON,
+    PARAMETER,   // ?
+    END,
+    INVALID      // niezamknięty cudzysłów albo nieznany znak
+};
+
+// Leksem: widok na fragment tekstu zapytania, bez kopiowania
+struct Token {
+    TokenType type = TokenType::END;
+    std::string_view text;
+    char quote = '\0'; // STRING: znak cudzysłowu literału
+
+    // Słowo kluczowe, bez względu na wielkość liter
+    bool is(std::string_view keyword) const;
+
+    // STRING z podwojonym cudzysłowem w środku - wartość różni się od text
+    bool escaped() const { return type == TokenType::STRING && text.find(quote) != std::string_view::npos; }
+
+    // Wartość literału: text z podwojonymi cudzysłowami zamienionymi na pojedyncze
+    std::string literal() const;
+};
+
+// Lekser DBQL nad std::string_view; nie alokuje pamięci dla leksemów
+class DBQLLexer {
+public:
+    explicit DBQLLexer(std::string_view text) : text(text) {}
+
+    Token next();
+
+    const Token &peek();
+
+private:
+    Token scan();
+
+    std::string_view text;
+    size_t position = 0;
+    Token lookahead;
+    bool hasLookahead = false;
+};
+
+// EXPLAIN pokazuje plan bez wykonania, EXPLAIN ANALYZE wykonuje zapytanie i dokłada wiersze i czasy kroków
+enum class ExplainMode {
+    NONE, PLAN, ANALYZE
+};
+
+enum class StatementType {
+    SELECT, INSERT, UPDATE, DELETE, CREATE_TABLE, DROP_TABLE, CREATE_INDEX, DROP_INDEX, ADD_COLUMN, DROP_COLUMN
+};
+
+// Miejsce parametru "?": wartość warunku (conditions[index].value), wartość INSERT/UPDATE (values[index])
+// albo LIMIT/OFFSET zapytania SELECT
+struct ParameterSlot {
+    enum class Kind {
+        CONDITION, VALUE, LIMIT, OFFSET
+    } kind;
+    size_t index;
+};
+
+// Drzewo sparsowanego zapytania:
+//   [EXPLAIN [ANALYZE]] SELECT kolumny FROM t [JOIN u ON t.x = u.y] [WHERE warunki] [GROUP BY kolumny] [ORDER BY klucze]
+//                     [LIMIT n [OFFSET m]]
+//   INSERT INTO t [(kolumny)] VALUES (wartości)[, (wartości)...]
+//   UPDATE t SET kolumna = wartość[, ...] WHERE kolumna = wartość
+//   DELETE FROM t WHERE kolumna = wartość
+//   CREATE TABLE t [(kolumna TYP, ...)] / DROP TABLE t
+//   CREATE INDEX i ON t (kolumna) [USING HASH|BTREE] / DROP INDEX i ON t
+//   ALTER TABLE t ADD [COLUMN] kolumna TYP [DEFAULT wartość] / ALTER TABLE t DROP [COLUMN] kolumna
+struct Statement {
+    StatementType type = StatementType::SELECT;
+    ExplainMode explain = ExplainMode::NONE;
+    std::string tableName;
+    std::vector<std::string> columns;      // SELECT: lista wyników; INSERT/UPDATE: kolumny wartości; CREATE/ALTER: nowe kolumny
+    std::vector<std::string> values;       // INSERT: wiersz po wierszu, po rowWidth wartości; UPDATE: wartość dla columns[i];
+                                           // ALTER TABLE ADD: wartość domyślna (brak = NULL)
+    size_t rowWidth = 0;
+    std::vector<DataType> columnTypes;     // CREATE TABLE, ALTER TABLE ADD
+    std::vector<Condition> conditions;
+    std::vector<std::string> groupBy;
+    std::vector<OrderKey> orderBy;
+    JoinClause join;                       // pusta nazwa tabeli = bez JOIN
+    CreateIndexStatement index;            // CREATE INDEX, DROP INDEX
+    std::string limit;                     // SELECT: LIMIT i OFFSET jako tekst liczby (puste = brak)
+    std::string offset;
+    std::vector<ParameterSlot> parameters; // kolejne "?" w tekście zapytania
+
+    // Pole wypełniane przez parametr
+    std::string &parameterValue(const ParameterSlot &slot);
+
+    // SELECT z LIMIT albo OFFSET (wartością albo parametrem)
+    bool paged() const;
+};
+
 class DBQLParser {
 public:
     DBQLParser(const std::string &query) {
@@ -28,18 +149,70 @@ public:
 
     std::string getCondition() const;
 
+    std::vector<std::string> getGroupBy() const;
+
+    // Pusta nazwa tabeli, gdy zapytanie nie ma JOIN
+    JoinClause getJoin() const;
+
+    const Statement &getStatement() const { return statement; }
+
+    bool isValid() const { return valid; }
+
+    // Parsowanie dowolnego zapytania do drzewa; false (z komunikatem) przy błędzie składni
+    static bool parseStatement(std::string_view query, Statement &statement);
+
+    // Postać znormalizowana do klucza PlanCache: literały liczbowe i napisowe zastąpione "?",
+    // leksemy rozdzielone pojedynczą spacją; literals = wycięte literały (widoki na query).
+    // false, gdy zapytanie ma już własne parametry "?", niepoprawny leksem albo literał z podwojonym
+    // cudzysłowem (jego wartość nie jest widokiem na query).
+    static bool normalize(std::string_view query, std::string &key, std::vector<std::string_view> &literals);
+
     static void parseConditions(const std::string& condition, std::vector<Condition>& conditions);
+    static bool parseCreateIndex(const std::string& query, CreateIndexStatement& statement);
     void parse(const std::string &query);
 
 private:
-    std::string tableName;
-    std::vector<std::string> columns;
-    std::vector<Condition> conditions;
+    Statement statement;
+    bool valid = false;
+};
+
+// Zapytanie sparsowane raz i wykonywane wielokrotnie (Database::execute) z nowymi wartościami
+// parametrów "?". Parametry numerowane od 0 w kolejności wystąpienia; wartości nie są ponownie
+// parsowane jako DBQL, więc napis z parametru nie może zmienić struktury zapytania.
+class PreparedStatement {
+public:
+    PreparedStatement() = default;
+
+    explicit PreparedStatement(const std::string &query);
 
+    bool ok() const { return error.empty(); }
 
+    // Komunikat błędu składni (pusty, gdy zapytanie jest poprawne)
+    const std::string &getError() const { return error; }
 
+    size_t parameterCount() const { return statement.parameters.size(); }
 
+    // false, gdy index jest poza zakresem
+    bool bind(size_t index, const std::string &value);
 
+    bool bindInt(size_t index, int64_t value);
+
+    bool bindFloat(size_t index, double value);
+
+    bool bindNull(size_t index);
+
+    // Pierwszy parametr bez wartości albo parameterCount(), gdy wszystkie są ustawione
+    size_t firstUnbound() const;
+
+    const Statement &getStatement() const { return statement; }
+
+    const std::string &getText() const { return text; }
+
+private:
+    std::string text;
+    Statement statement;
+    std::string error;
+    std::vector<bool> bound;
 };
 
 
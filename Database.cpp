@@ -1,280 +1,1450 @@
 #include "Database.h"
-#include "WindowManager.h"
+#include "Diagnostics.h"
 #include "DBQLParser.h"
+#include "Predicate.h"
+#include "QueryPlanner.h"
+#include "Snapshot.h"
+#include "Aggregation.h"
+#include "ThreadPool.h"
+#include "PlanCache.h"
+#include "ResultCursor.h"
+#include "Memory.h"
+#include "BufferPool.h"
+#include <bit>
+#include <cmath>
+#include <numeric>
+#include <optional>
 
+namespace {
+    // Wartość domyślna kolumny dla count nowych wierszy (bez wartości domyślnej NULL)
+    void appendDefault(ColumnData &data, const Column &column, size_t count) {
+        if (column.defaultValue.empty()) {
+            data.appendNulls(count);
+        } else {
+            data.appendRepeated(column.defaultValue, count);
+        }
+    }
+
+    // Wartość LIMIT/OFFSET; pusty tekst - count bez zmian
+    bool parseRowCount(const std::string &text, const char *clause, size_t &count) {
+        if (text.empty()) {
+            return true;
+        }
+        int64_t value;
+        if (!parseIntValue(text, value) || value < 0) {
+            errorStream() << "Invalid " << clause << " value " << text << "." << std::endl;
+            return false;
+        }
+        count = static_cast<size_t>(value);
+        return true;
+    }
 
+    // Ścieżka dostępu do tabeli w krokach EXPLAIN
+    std::string describeAccess(const Table &table, const ScanPlan &scan) {
+        if (!scan.usesIndex()) {
+            return table.name;
+        }
+        std::string detail = table.name + " using " + scan.index->getName()
+                             + (scan.index->getType() == IndexType::HASH ? " (HASH)" : " (BTREE)");
+        for (const auto &[name, column] : table.columns) {
+            if (column.index == scan.index->getColumnIndex()) {
+                detail += " on " + name;
+            }
+        }
+        return detail;
+    }
 
-Database::Database() {
+    std::string joinNames(const std::vector<std::string> &names) {
+        std::string joined;
+        for (const auto &name : names) {
+            joined += (joined.empty() ? "" : ", ") + name;
+        }
+        return joined;
+    }
 
+    // Wiersze potrzebne przed LIMIT: LIMIT + OFFSET (bez LIMIT - wszystkie)
+    size_t rowsToKeep(size_t limit, size_t offset) {
+        return limit > RowSorter::ALL_ROWS - offset ? RowSorter::ALL_ROWS : limit + offset;
+    }
+
+    // Klucze ORDER BY w krokach EXPLAIN, np. "ts DESC, name"
+    std::string describeOrder(const std::vector<OrderKey> &orderBy) {
+        std::string described;
+        for (const auto &key : orderBy) {
+            described += (described.empty() ? "" : ", ") + key.column + (key.descending ? " DESC" : "");
+        }
+        return described;
+    }
+
+    std::string describeSort(const std::vector<OrderKey> &orderBy, size_t keep, const RowSorter &sorter) {
+        std::string detail = describeOrder(orderBy);
+        if (sorter.usedTopN()) {
+            detail += ", top " + std::to_string(keep);
+        }
+        if (sorter.skippedBlocks() > 0) {
+            detail += ", blocks skipped " + std::to_string(sorter.skippedBlocks());
+        }
+        if (sorter.spilledRuns() > 0) {
+            detail += ", runs on disk " + std::to_string(sorter.spilledRuns());
+        }
+        return detail;
+    }
+
+    // Krok nad wszystkimi dotąd zapisanymi (np. sortowanie gotowego wyniku) - te schodzą poziom niżej
+    void nestOperators() {
+        if (QueryProfile *profile = QueryProfile::active(); profile != nullptr && profile->collectsOperators()) {
+            for (auto &step : profile->operators) {
+                ++step.depth;
+            }
+        }
+    }
+
+    std::string formatMillis(uint64_t nanos) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.3f ms", static_cast<double>(nanos) / 1e6);
+        return text;
+    }
+}
+
+
+
+Database::Database() : planCache(std::make_unique<PlanCache>()), monitor(std::make_unique<QueryMonitor>()) {
+
+}
+
+Database::~Database() = default;
+
+void Database::setPlanCacheCapacity(size_t capacity) {
+    planCache->setCapacity(capacity);
 }
 
 void Database::createTable(const std::string &tableName) {
+    std::lock_guard changeLock(catalogChangeMutex);
+    std::unique_lock catalogLock(catalogMutex);
     if (tables.find(tableName) != tables.end()) {
-        std::cerr << "Table " << tableName << " already exists." << std::endl;
+        errorStream() << "Table " << tableName << " already exists." << std::endl;
         return;
     }
-    tables[tableName] = Table{tableName};
+    uint64_t lsn = logMutation({WalOp::CREATE_TABLE, tableName, {}, {}, {}});
+    auto table = std::make_shared<Table>();
+    table->name = tableName;
+    tables[tableName] = std::move(table);
+    catalogLock.unlock();
+    awaitDurable(lsn);
 }
 
 
 void Database::dropTable(const std::string &tableName) {
-    if (tables.find(tableName) == tables.end()) {
-        std::cerr << "Table " << tableName << " does not exist." << std::endl;
+    std::unique_lock changeLock(catalogChangeMutex);
+    std::shared_ptr<Table> table = findTable(tableName);
+    if (!table) {
+        errorStream() << "Table " << tableName << " does not exist." << std::endl;
         return;
     }
-    tables.erase(tableName);
 
+    // Czekamy na trwające operacje na tabeli bez blokady katalogu; uchwyty pobrane wcześniej zobaczą flagę
+    // dropped. Tabela znika z katalogu dopiero po zwolnieniu jej blokady - nikt nie czeka na katalog pod
+    // blokadą tabeli, a catalogChangeMutex nie wpuści pomiędzy CREATE TABLE o tej samej nazwie
+    std::unique_lock tableLock(table->mutex);
+    uint64_t lsn = logMutation({WalOp::DROP_TABLE, tableName, {}, {}, {}});
+    table->dropped = true;
+    tableLock.unlock();
+    {
+        std::unique_lock catalogLock(catalogMutex);
+        tables.erase(tableName);
+    }
+    planCache->invalidate(tableName);
+    changeLock.unlock();
+    awaitDurable(lsn);
 }
 
 void Database::addColumn(const std::string &tableName, const Column &column) {
-    auto table = tables.find(tableName);
-    if (table == tables.end()) {
-        std::cerr << "Table " << tableName << " does not exist." << std::endl;
+    addNewColumn(tableName, column.name, column.type, column.defaultValue);
+}
+
+void Database::removeColumn(const std::string &tableName, const std::string &columnName) {
+    auto handle = writeTable(tableName);
+    if (!handle.table) {
         return;
     }
-    if (table->second.columns.find(column.name) != table->second.columns.end()) {
-        std::cerr << "Column " << column.name << " already exists in table " << tableName << "." << std::endl;
+    Table& table = *handle.table;
+    auto columnIt = table.columns.find(columnName);
+    if (columnIt == table.columns.end()) {
+        errorStream() << "Column " << columnName << " does not exist in table " << tableName << "." << std::endl;
         return;
     }
+    uint64_t lsn = logMutation({WalOp::REMOVE_COLUMN, tableName, {columnName}, {}, {}});
+    int columnIndex = columnIt->second.index;
+    table.columns.erase(columnIt);
+    ColumnData removed = table.removeColumnData(columnIndex);
+    ++table.schemaVersion;
+    planCache->invalidate(tableName);
+    handle.lock.unlock();
+    removed = ColumnData(); // pamięć kolumny zwalniana już bez blokady tabeli
+    awaitDurable(lsn);
+}
 
-    if (!table->second.isValidColumnType(column)) {
-        std::cerr << "Invalid type for column " << column.name << " in table " << tableName << "." << std::endl;
+void Database::createIndex(const std::string &tableName, const std::string &indexName, const std::string &columnName,
+                           IndexType indexType) {
+    auto handle = writeTable(tableName);
+    if (!handle.table) {
         return;
     }
+    Table& table = *handle.table;
+    auto columnIt = table.columns.find(columnName);
+    if (columnIt == table.columns.end()) {
+        errorStream() << "Column " << columnName << " does not exist in table " << tableName << "." << std::endl;
+        return;
+    }
+    for (const auto& index : table.indexes) {
+        if (index->getName() == indexName) {
+            errorStream() << "Index " << indexName << " already exists in table " << tableName << "." << std::endl;
+            return;
+        }
+    }
 
-    // Utwórz nowy obiekt Column używając konstruktora
-    Column newColumn(column.name, column.type, static_cast<int>(table->second.columns.size()));
-    table->second.columns.emplace(newColumn.name, newColumn);
+    uint64_t lsn = logMutation({WalOp::CREATE_INDEX, tableName,
+                                {indexName, columnName, indexType == IndexType::HASH ? "HASH" : "BTREE"}, {}, {}});
+    auto index = createTableIndex(indexName, indexType, columnIt->second.index, columnIt->second.type);
+    index->build(table.data[columnIt->second.index], table.rowCount);
+    table.eraseDeleted(*index);
+    table.indexes.push_back(std::move(index));
+    ++table.schemaVersion;
+    planCache->invalidate(tableName);
+    handle.lock.unlock();
+    awaitDurable(lsn);
 }
 
-
-
-
-void Database::removeColumn(const std::string &tableName, const std::string &columnName) {
-    auto table = tables.find(tableName);
-    if (table == tables.end()) {
-        std::cerr << "Table " << tableName << " does not exist." << std::endl;
+void Database::dropIndex(const std::string &tableName, const std::string &indexName) {
+    auto handle = writeTable(tableName);
+    if (!handle.table) {
         return;
     }
-    if (table->second.columns.find(columnName) == table->second.columns.end()) {
-        std::cerr << "Column " << columnName << " does not exist in table " << tableName << "." << std::endl;
+    Table& table = *handle.table;
+    auto& indexes = table.indexes;
+    auto indexIt = std::find_if(indexes.begin(), indexes.end(), [&indexName](const auto& index) {
+        return index->getName() == indexName;
+    });
+    if (indexIt == indexes.end()) {
+        errorStream() << "Index " << indexName << " does not exist in table " << tableName << "." << std::endl;
         return;
     }
-    table->second.columns.erase(columnName);
-
+    uint64_t lsn = logMutation({WalOp::DROP_INDEX, tableName, {indexName}, {}, {}});
+    indexes.erase(indexIt);
+    ++table.schemaVersion;
+    planCache->invalidate(tableName);
+    handle.lock.unlock();
+    awaitDurable(lsn);
 }
 
 void Database::insertData(const std::string &tableName, const std::map<std::string, std::string> &rowData) {
-    auto tableIt = tables.find(tableName);
-    if (tableIt == tables.end()) {
-        std::cerr << "Table " << tableName << " does not exist." << std::endl;
+    auto handle = writeTableOwned(tableName, {}, true);
+    if (!handle.table) {
         return;
     }
+    Table& table = *handle.table;
 
     // Sprawdzanie, czy typy danych są zgodne
     for (const auto& col : rowData) {
-        auto collIt = tableIt->second.columns.find(col.first);
-        if (collIt == tableIt->second.columns.end()) {
-            std::cerr << "Column " << col.first << " does not exist in table " << tableName << "." << std::endl;
+        auto collIt = table.columns.find(col.first);
+        if (collIt == table.columns.end()) {
+            errorStream() << "Column " << col.first << " does not exist in table " << tableName << "." << std::endl;
             return;
         }
         if (!collIt->second.isValidType(col.second)) {
-            std::cerr << "Invalid type for column " << col.first << "." << std::endl;
+            errorStream() << "Invalid type for column " << col.first << "." << std::endl;
             return;
         }
     }
 
-    // Dodawanie danych
-    for (const auto& col : rowData) {
-        tableIt->second.data[col.first].push_back(col.second);
+    uint64_t lsn = logMutation({WalOp::INSERT, tableName, {}, rowData, {}});
+
+    // Dodawanie danych, brakujące kolumny dostają wartość domyślną (bez niej NULL)
+    for (const auto& col : table.columns) {
+        auto valueIt = rowData.find(col.first);
+        if (valueIt != rowData.end()) {
+            table.data[col.second.index].append(valueIt->second);
+        } else {
+            appendDefault(table.data[col.second.index], col.second, 1);
+        }
+    }
+    for (auto& index : table.indexes) {
+        index->insertRow(table.data[index->getColumnIndex()], table.rowCount);
+    }
+    ++table.rowCount;
+    ++table.dataVersion;
+    table.optimizeEncoding(table.rowCount - 1);
+    handle.lock.unlock();
+    awaitDurable(lsn);
+}
+
+std::vector<QueryStats> Database::recentQueries(size_t maxCount) const {
+    return monitor->recent(maxCount);
+}
+
+MetricsSnapshot Database::metrics() const {
+    MetricsSnapshot snapshot;
+    snapshot.queries = monitor->counters();
+    PlanCache::Stats cache = planCache->stats();
+    snapshot.planCacheHits = cache.hits;
+    snapshot.planCacheMisses = cache.misses;
+    snapshot.planCacheEntries = cache.entries;
+    {
+        std::shared_lock catalogLock(catalogMutex);
+        snapshot.tables = tables.size();
+    }
+    MemoryStats memory = memoryStats();
+    snapshot.poolUsedBytes = memory.pool.usedBytes;
+    snapshot.poolCachedBytes = memory.pool.cachedBytes;
+    snapshot.arenaBytes = memory.arenaBytes;
+    snapshot.bufferPool = BufferPool::shared().stats();
+    return snapshot;
+}
+
+std::vector<Column> Database::getSchema(const std::string &tableName) const {
+    std::vector<Column> schema;
+    auto handle = readTable(tableName);
+    if (!handle.table) {
+        return schema;
     }
+    Table& table = *handle.table;
+    schema.resize(table.columns.size());
+    for (const auto& col : table.columns) {
+        schema[col.second.index] = col.second;
+    }
+    return schema;
+}
+
+bool Database::insertBatch(const std::string &tableName, const RowBatch &batch) {
+    auto handle = writeTableOwned(tableName, {}, true);
+    if (!handle.table) {
+        return false;
+    }
+    Table& table = *handle.table;
+    if (batch.columnNames.size() != batch.columns.size()) {
+        errorStream() << "Batch has " << batch.columnNames.size() << " names for " << batch.columns.size() << " columns." << std::endl;
+        return false;
+    }
+
+    // Sprawdzanie kolumn, typów i długości wsadu
+    size_t count = batch.rowCount();
+    std::vector<const ColumnData*> sources(table.data.size(), nullptr);
+    for (size_t i = 0; i < batch.columns.size(); ++i) {
+        auto colIt = table.columns.find(batch.columnNames[i]);
+        if (colIt == table.columns.end()) {
+            errorStream() << "Column " << batch.columnNames[i] << " does not exist in table " << tableName << "." << std::endl;
+            return false;
+        }
+        if (batch.columns[i].getType() != colIt->second.type) {
+            errorStream() << "Invalid type for column " << batch.columnNames[i] << "." << std::endl;
+            return false;
+        }
+        if (batch.columns[i].size() != count) {
+            errorStream() << "Column " << batch.columnNames[i] << " has " << batch.columns[i].size()
+                      << " rows, expected " << count << "." << std::endl;
+            return false;
+        }
+        sources[colIt->second.index] = &batch.columns[i];
+    }
+    if (count == 0) {
+        return true;
+    }
+
+    uint64_t lsn = 0;
+    if (wal && !replaying) {
+        WalRecord record{WalOp::INSERT_BATCH, tableName, batch.columnNames, {}, {}};
+        for (const auto& column : batch.columns) {
+            column.serialize(record.payload);
+        }
+        lsn = logMutation(record);
+    }
+
+    // Dopisywanie całych kolumn naraz, brakujące kolumny dostają wartość domyślną
+    for (const auto& col : table.columns) {
+        int columnIndex = col.second.index;
+        if (sources[columnIndex] != nullptr) {
+            table.data[columnIndex].appendColumn(*sources[columnIndex]);
+        } else {
+            appendDefault(table.data[columnIndex], col.second, count);
+        }
+    }
+    for (auto& index : table.indexes) {
+        const ColumnData& column = table.data[index->getColumnIndex()];
+        for (size_t row = table.rowCount; row < table.rowCount + count; ++row) {
+            index->insertRow(column, row);
+        }
+    }
+    table.rowCount += count;
+    ++table.dataVersion;
+    table.optimizeEncoding(table.rowCount - count);
+    handle.lock.unlock();
+    awaitDurable(lsn);
+    return true;
 }
 
 void Database::updateData(const std::string& tableName, const std::map<std::string, std::string>& updateValues, const std::string& conditionColumn, const std::string& conditionValue) {
-    auto tableIt = tables.find(tableName);
-    if (tableIt == tables.end()) {
-        std::cerr << "Table " << tableName << " does not exist." << std::endl;
+    std::vector<std::string> updatedColumns;
+    for (const auto& colVal : updateValues) {
+        updatedColumns.push_back(colVal.first);
+    }
+    auto handle = writeTableOwned(tableName, updatedColumns, false);
+    if (!handle.table) {
         return;
     }
+    Table& table = *handle.table;
 
-    // Sprawdzanie, czy kolumna warunku istnieje i uzyskanie jej indeksu
-    auto updatecolIt = tableIt->second.columns.find(conditionColumn);
-    int conditionColumnIndex = updatecolIt->second.index;
+    // Kompilacja warunku (kolumna i typ literału sprawdzane raz)
+    auto predicate = Predicate::compile(table, {Condition{conditionColumn, "==", conditionValue, ""}});
+    if (!predicate) {
+        return;
+    }
 
-    // Przechodzenie przez wszystkie wiersze i aktualizacja danych
-    for (auto& row : tableIt->second.data) {
-        if (row.second.size() > conditionColumnIndex && row.second[conditionColumnIndex] == conditionValue) {
-            for (const auto& colVal : updateValues) {
-                auto updateColIt = tableIt->second.columns.find(colVal.first); // Fix: Rename conflicting variable 'colIt' to 'updateColIt'
-                if (updateColIt != tableIt->second.columns.end()) {
-                    int updateColumnIndex = updateColIt->second.index; // Fix: Access the index member of the Column object
-                    if (row.second.size() > updateColumnIndex) {
-                        row.second[updateColumnIndex] = colVal.second;
-                    }
+    // Sprawdzanie kolumn i typów aktualizowanych wartości
+    std::vector<std::pair<int, const std::string*>> targets;
+    for (const auto& colVal : updateValues) {
+        auto updateColIt = table.columns.find(colVal.first);
+        if (updateColIt == table.columns.end()) {
+            errorStream() << "Column " << colVal.first << " does not exist in table " << tableName << "." << std::endl;
+            return;
+        }
+        if (!updateColIt->second.isValidType(colVal.second)) {
+            errorStream() << "Invalid type for column " << colVal.first << "." << std::endl;
+            return;
+        }
+        targets.emplace_back(updateColIt->second.index, &colVal.second);
+    }
+
+    // Aktualizacja pasujących wierszy bezpośrednio w kolumnach, razem z indeksami
+    std::vector<uint32_t> rows = QueryPlanner::matchingRows(table, *predicate, QueryPlanner::plan(table, *predicate));
+    if (rows.empty()) {
+        return;
+    }
+    uint64_t lsn = logMutation({WalOp::UPDATE, tableName, {conditionColumn, conditionValue}, updateValues, {}});
+    for (const auto& target : targets) {
+        ColumnData& column = table.data[target.first];
+        for (uint32_t row : rows) {
+            for (auto& index : table.indexes) {
+                if (index->getColumnIndex() == target.first) {
+                    index->eraseRow(column, row);
+                }
+            }
+            column.set(row, *target.second);
+            for (auto& index : table.indexes) {
+                if (index->getColumnIndex() == target.first) {
+                    index->insertRow(column, row);
                 }
             }
         }
     }
+    ++table.dataVersion;
+    handle.lock.unlock();
+    awaitDurable(lsn);
 }
 
 
 void Database::deleteData(const std::string& tableName, const std::string& conditionColumn, const std::string& conditionValue) {
-    auto tableIt = tables.find(tableName);
-    if (tableIt == tables.end()) {
-        std::cerr << "Table " << tableName << " does not exist." << std::endl;
+    auto handle = writeTable(tableName);
+    if (!handle.table) {
+        return;
+    }
+    Table& table = *handle.table;
+
+    auto predicate = Predicate::compile(table, {Condition{conditionColumn, "==", conditionValue, ""}});
+    if (!predicate) {
         return;
     }
 
-    auto conditionColumnIt = tableIt->second.columns.find(conditionColumn);
-    if (conditionColumnIt == tableIt->second.columns.end()) {
-        std::cerr << "Column " << conditionColumn << " does not exist in table " << tableName << "." << std::endl;
+    std::vector<uint32_t> matches = QueryPlanner::matchingRows(table, *predicate, QueryPlanner::plan(table, *predicate));
+    if (matches.empty()) {
         return;
     }
+    uint64_t lsn = logMutation({WalOp::DELETE, tableName, {conditionColumn, conditionValue}, {}, {}});
+
+    // Tylko oznaczenie wierszy - koszt zależy od liczby usuniętych, nie od rozmiaru tabeli
+    table.markDeleted(matches);
+    ++table.dataVersion;
+    double threshold = compactionThreshold;
+    bool compact = threshold < 1.0 && table.deletedCount >= COMPACTION_MIN_ROWS
+                   && static_cast<double>(table.deletedCount) > threshold * static_cast<double>(table.rowCount);
+    handle.lock.unlock();
+    if (compact) {
+        // Po zwolnieniu blokady - pula bez wątków roboczych wykonuje zadanie od razu
+        scheduleCompaction(handle.table);
+    }
+    awaitDurable(lsn);
+}
 
-    int conditionColumnIndex = conditionColumnIt->second.index;
+void Database::setCompactionThreshold(double fraction) {
+    compactionThreshold = fraction;
+}
 
-    auto& data = tableIt->second.data;
-    std::map<std::string, std::vector<std::string>> newData;
-    for (const auto& row : data) {
-        if (row.second[conditionColumnIndex] != conditionValue) {
-            newData.insert(row);
+void Database::compactTable(const std::string &tableName) {
+    std::shared_ptr<Table> table;
+    {
+        std::shared_lock catalogLock(catalogMutex);
+        auto tableIt = tables.find(tableName);
+        if (tableIt == tables.end()) {
+            errorStream() << "Table " << tableName << " does not exist." << std::endl;
+            return;
         }
+        table = tableIt->second;
     }
-    data = std::move(newData);
+    std::chrono::milliseconds idleTimeout = cursorIdleTimeout;
+    for (int attempt = 0; attempt < COMPACTION_MAX_RETRIES; ++attempt) {
+        if (rewriteTable(table, idleTimeout)) {
+            return;
+        }
+        // Tabela zmieniła się w trakcie budowy nowych kolumn - ponowienie z nowym stanem
+        std::this_thread::yield();
+    }
+    // Ciągłe zapisy nie dają dokończyć kopii pod blokadą współdzieloną - kopia bez wpuszczania zapisów
+    rewriteTable(table, idleTimeout, true);
 }
 
+void Database::setCursorIdleTimeout(std::chrono::milliseconds timeout) {
+    cursorIdleTimeout = timeout;
+}
 
-void Database::selectData(const std::string& tableName, const std::vector<std::string>& columns,
-                          const std::string& condition) {
-    auto tableIt = tables.find(tableName);
-    if (tableIt == tables.end()) {
-        std::cerr << "Table " << tableName << " does not exist." << std::endl;
+void Database::scheduleCompaction(const std::shared_ptr<Table> &table) {
+    if (table->compactionScheduled.exchange(true)) {
         return;
     }
+    ThreadPool::shared().submit([table, idleTimeout = cursorIdleTimeout.load()] {
+        // Bez ponowień - gdy tabela zmieniła się w trakcie, kolejny DELETE ponad progiem zaplanuje kompakcję znowu
+        rewriteTable(table, idleTimeout);
+        table->compactionScheduled = false;
+    });
+}
+
+bool Database::cursorsActive(const Table &table, std::chrono::milliseconds idleTimeout) {
+    if (table.openCursors == 0) {
+        return false;
+    }
+    auto lastUse = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(table.lastCursorUse));
+    return std::chrono::steady_clock::now() - lastUse < idleTimeout;
+}
+
+bool Database::rewriteTable(const std::shared_ptr<Table> &table, std::chrono::milliseconds cursorIdleTimeout,
+                            bool exclusive) {
+    std::shared_lock readLock(table->mutex, std::defer_lock);
+    std::unique_lock writeLock(table->mutex, std::defer_lock);
+    if (exclusive) {
+        writeLock.lock();
+    } else {
+        readLock.lock();
+    }
+    if (table->dropped || table->deletedCount == 0 || cursorsActive(*table, cursorIdleTimeout)) {
+        // Używane kursory trzymają numery wierszy - kompakcja przy następnym DELETE
+        return true;
+    }
+    uint64_t dataVersion = table->dataVersion;
+    uint64_t schemaVersion = table->schemaVersion;
 
-    // Parsowanie warunku (na razie bardzo proste)
+    // Żywe wiersze przepisane do nowych kolumn, równolegle po kolumnach
+    std::vector<uint32_t> live;
+    live.reserve(table->rowCount - table->deletedCount);
+    std::vector<bool> keep(table->rowCount);
+    for (size_t row = 0; row < table->rowCount; ++row) {
+        keep[row] = !table->isDeleted(row);
+        if (keep[row]) {
+            live.push_back(static_cast<uint32_t>(row));
+        }
+    }
+    std::vector<ColumnData> columns(table->data.size());
+    ThreadPool::shared().parallelFor(columns.size(), [&](size_t i, unsigned) {
+        const ColumnData &source = table->data[i];
+        columns[i] = ColumnData(source.getType());
+        columns[i].appendRows(source, live.data(), live.size());
+        columns[i].optimizeEncoding();
+    });
+    if (!exclusive) {
+        readLock.unlock();
+        writeLock.lock();
+        if (table->dropped || cursorsActive(*table, cursorIdleTimeout)) {
+            return true;
+        }
+        if (table->dataVersion != dataVersion || table->schemaVersion != schemaVersion) {
+            return false;
+        }
+    }
+    // Podmiana zawartości, nie wektora - plany z PlanCache trzymają wskaźniki do ColumnData
+    for (size_t i = 0; i < columns.size(); ++i) {
+        table->data[i] = std::move(columns[i]);
+    }
+    for (auto& index : table->indexes) {
+        index->remapRows(keep);
+    }
+    table->rowCount = live.size();
+    table->deleted.clear();
+    table->deletedCount = 0;
+    ++table->dataVersion;
+    // Bezczynne kursory trzymały stare numery wierszy
+    ++table->compactions;
+    return true;
+}
+
+
+void Database::selectData(const std::string& tableName, const std::vector<std::string>& columns,
+                          const std::string& condition) {
+    Statement statement;
+    statement.tableName = tableName;
+    statement.columns = columns;
+    DBQLParser::parseConditions(condition, statement.conditions);
+    auto cursor = openStatementCursor(statement);
+    printCursor(*cursor);
+}
+
+ResultSet Database::select(const std::string &tableName, const std::vector<std::string> &columns,
+                           const std::string &condition, const std::vector<std::string> &groupBy) const {
+    ErrorCapture capture;
     std::vector<Condition> conditions;
     DBQLParser::parseConditions(condition, conditions);
+    ResultSet result = capture.str().empty() ? runSelect(tableName, columns, conditions, groupBy) : ResultSet();
+    result.error = capture.str();
+    return result;
+}
 
-    // Wyświetlanie danych
-    for (const auto& row : tableIt->second.data) {
-        bool meetConditions = true;
+ResultSet Database::runSelect(const std::string &tableName, const std::vector<std::string> &columns,
+                              const std::vector<Condition> &conditions, const std::vector<std::string> &groupBy,
+                              const std::vector<OrderKey> &orderBy) const {
+    auto handle = readTable(tableName);
+    if (!handle.table) {
+        return {};
+    }
+    const Table& table = *handle.table;
+    std::optional<StageTimer> planning(std::in_place, QueryStage::PLAN);
+    SelectPlan plan;
+    if (!resolveProjection(table, columns, plan)) {
+        return {};
+    }
 
-        // Sprawdzanie, czy wiersz spełnia warunki
-        for (const auto& cond : conditions) {
-            size_t columnIndex = std::find(columns.begin(), columns.end(), cond.column) - columns.begin();
+    // Kompilacja warunku raz na zapytanie
+    auto predicate = Predicate::compile(table, conditions);
+    if (!predicate) {
+        return {};
+    }
+    ScanPlan scan = QueryPlanner::plan(table, *predicate);
+    planning.reset();
+    return runScan(table, plan, *predicate, scan, groupBy, orderBy);
+}
 
-            if (columnIndex < columns.size()) {
-                if (cond.op == "==" && row.second.at(columnIndex) != cond.value) { // Fix: Access the element using the at() function
-                    meetConditions = false;
-                    break;
+ResultSet Database::runCachedSelect(CachedQuery &query, const std::vector<std::string_view> &values) const {
+    const Statement& statement = query.statement;
+    auto handle = readTable(statement.tableName);
+    if (!handle.table) {
+        return {};
+    }
+    const Table& table = *handle.table;
+    std::optional<StageTimer> planning(std::in_place, QueryStage::PLAN);
+
+    // Plan jest ważny tylko dla tego samego obiektu tabeli w tej samej wersji schematu
+    std::shared_ptr<const SelectPlan> plan = query.selectPlan();
+    if (!plan || plan->table.lock() != handle.table || plan->schemaVersion != table.schemaVersion) {
+        auto fresh = std::make_shared<SelectPlan>();
+        fresh->table = handle.table;
+        fresh->schemaVersion = table.schemaVersion;
+        if (!resolveProjection(table, statement.columns, *fresh)) {
+            return {};
+        }
+        std::vector<Condition> conditions = statement.conditions;
+        for (size_t i = 0; i < conditions.size(); ++i) {
+            conditions[i].value.assign(values[i]);
+        }
+        fresh->predicate = Predicate::compile(table, conditions);
+        if (!fresh->predicate) {
+            return {};
+        }
+        ScanPlan scan = QueryPlanner::plan(table, *fresh->predicate);
+        fresh->index = scan.index;
+        fresh->indexComparison = scan.usesIndex() ? fresh->predicate->positionOf(scan.indexComparison) : 0;
+        query.setSelectPlan(fresh);
+        plan = std::move(fresh);
+    }
+
+    // Nowe literały w kopii predykatu-szablonu; kolumny, operatory i indeks z planu
+    auto predicate = plan->predicate->bind(table, values);
+    if (!predicate) {
+        return {};
+    }
+    ScanPlan scan;
+    if (plan->index != nullptr) {
+        scan.index = plan->index;
+        scan.indexComparison = predicate->comparisonAt(plan->indexComparison);
+        if (scan.indexComparison->column->getType() == DataType::FLOAT && std::isnan(scan.indexComparison->floatValue)) {
+            scan = QueryPlanner::plan(table, *predicate);
+        }
+    }
+    planning.reset();
+    return runScan(table, *plan, *predicate, scan, statement.groupBy, statement.orderBy);
+}
+
+bool Database::resolveProjection(const Table &table, const std::vector<std::string> &columns,
+                                 SelectPlan &plan) const {
+    // Kolumny projekcji ("*" oznacza wszystkie kolumny) i agregaty (aggregateOf[i] >= 0)
+    std::vector<const Column*>& projection = plan.projection;
+    std::vector<int>& aggregateOf = plan.aggregateOf;
+    std::vector<AggregateSpec>& aggregates = plan.aggregates;
+    for (const auto& columnName : columns) {
+        if (columnName == "*") {
+            std::vector<const Column*> all;
+            for (const auto& col : table.columns) {
+                all.push_back(&col.second);
+            }
+            std::sort(all.begin(), all.end(), [](const Column* a, const Column* b) { return a->index < b->index; });
+            projection.insert(projection.end(), all.begin(), all.end());
+            aggregateOf.resize(projection.size(), -1);
+            continue;
+        }
+        AggregateSpec spec;
+        std::string argument;
+        if (HashAggregator::parseAggregate(columnName, spec.function, argument)) {
+            spec.name = columnName;
+            if (argument != "*") {
+                const Column* column = table.findColumn(argument);
+                if (column == nullptr) {
+                    errorStream() << "Column " << argument << " does not exist in table " << table.name << "." << std::endl;
+                    return false;
                 }
-                // Dodaj obsługę innych operatorów porównania, np. "<", ">", itp., jeśli jest to wymagane
-            } else {
-                std::cerr << "Column " << cond.column << " not found in specified columns." << std::endl;
-                meetConditions = false;
-                break;
+                spec.columnIndex = column->index;
             }
+            projection.push_back(nullptr);
+            aggregateOf.push_back(static_cast<int>(aggregates.size()));
+            aggregates.push_back(spec);
+            continue;
+        }
+        const Column* column = table.findColumn(columnName);
+        if (column == nullptr) {
+            errorStream() << "Column " << columnName << " does not exist in table " << table.name << "." << std::endl;
+            return false;
         }
+        projection.push_back(column);
+        aggregateOf.push_back(-1);
+    }
+    return true;
+}
+
+ResultSet Database::runScan(const Table &table, const SelectPlan &plan, const Predicate &predicate,
+                            const ScanPlan &scan, const std::vector<std::string> &groupBy,
+                            const std::vector<OrderKey> &orderBy, size_t keep) const {
+    const std::vector<const Column*>& projection = plan.projection;
+    if (!plan.aggregates.empty() || !groupBy.empty()) {
+        ResultSet result = runAggregate(table, predicate, scan, projection, plan.aggregateOf, plan.aggregates, groupBy);
+        if (!orderBy.empty() && !result.columnNames.empty() && !sortResult(result, orderBy, keep)) {
+            return {};
+        }
+        return result;
+    }
 
-        if (meetConditions) {
-            for (size_t columnIndex = 0; columnIndex < columns.size(); ++columnIndex) {
-                std::cout << row.second.at(columnIndex) << " "; // Fix: Access the element using the at() function
+    // ORDER BY bez agregatów sortuje numery wierszy przed projekcją, więc klucz nie musi być na liście SELECT,
+    // a z LIMIT projekcja dotyczy tylko keep wierszy
+    std::vector<SortKey> sortKeys;
+    for (const auto& key : orderBy) {
+        const Column* column = table.findColumn(key.column);
+        if (column == nullptr) {
+            errorStream() << "Column " << key.column << " does not exist in table " << table.name << "." << std::endl;
+            return {};
+        }
+        sortKeys.push_back({&table.data[column->index], key.descending});
+    }
+
+    ResultSet result;
+    std::vector<uint32_t> rows;
+    if (!sortKeys.empty() && !scan.usesIndex() && RowSorter::prefersTopN(keep, table.rowCount)) {
+        // Top-N połączony ze skanem: filtrowane są tylko bloki, które mogą trafić do wyniku
+        StageTimer sorting(QueryStage::SORT);
+        OperatorTimer sortStep;
+        std::vector<const ColumnData *> columns = predicate.columns();
+        std::atomic<size_t> skipped{0};
+        std::atomic<size_t> scanned{0};
+        RowSorter sorter(std::move(sortKeys), sortOptions);
+        auto selectRows = [&](size_t firstRow, size_t count, std::vector<uint32_t> &selected) {
+            if (!predicate.mayMatch(firstRow, count)) {
+                skipped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            scanned.fetch_add(count, std::memory_order_relaxed);
+            QueryPlanner::selectMorsel(table, predicate, columns, firstRow, count, firstRow, selected);
+        };
+        rows = sorter.topScan(table.rowCount, keep, selectRows);
+        if (QueryProfile *profile = QueryProfile::active(); profile != nullptr) {
+            profile->blocksSkipped += skipped + sorter.skippedBlocks();
+            profile->rowsScanned += scanned;
+        }
+        sortStep.finish("Top-N sort", [&] {
+            return describeSort(orderBy, keep, sorter) + ", fused scan of " + table.name;
+        }, 1, rows.size());
+    } else {
+        // Indeks albo równoległy filtr wektorowy
+        OperatorTimer scanStep;
+        rows = QueryPlanner::matchingRows(table, predicate, scan);
+        scanStep.finish(scan.usesIndex() ? "Index scan" : "Scan", [&] { return describeAccess(table, scan); },
+                        sortKeys.empty() ? 1 : 2, rows.size());
+        if (!sortKeys.empty()) {
+            StageTimer sorting(QueryStage::SORT);
+            OperatorTimer sortStep;
+            RowSorter sorter(std::move(sortKeys), sortOptions);
+            if (!sorter.sort(rows, keep)) {
+                return {};
             }
-            std::cout << std::endl;
+            sortStep.finish(sorter.usedTopN() ? "Top-N sort" : "Sort",
+                            [&] { return describeSort(orderBy, keep, sorter); }, 1, rows.size());
+        }
+    }
+
+    // Projekcja równolegle, fragmentami, sklejana w kolejności wierszy
+    StageTimer projecting(QueryStage::PROJECT);
+    OperatorTimer projectStep;
+    std::vector<std::vector<ColumnData>> parts(ThreadPool::morselCount(rows.size()));
+    ThreadPool::shared().forEachMorsel(rows.size(), [&](size_t morsel, size_t first, size_t count, unsigned) {
+        for (const Column* col : projection) {
+            parts[morsel].emplace_back(col->type);
+            parts[morsel].back().appendRows(table.data[col->index], rows.data() + first, count);
+        }
+    });
+    for (size_t i = 0; i < projection.size(); ++i) {
+        result.columnNames.push_back(projection[i]->name);
+        if (parts.size() == 1) {
+            result.columns.push_back(std::move(parts.front()[i]));
+            continue;
+        }
+        result.columns.emplace_back(projection[i]->type);
+        result.columns.back().reserve(rows.size());
+        for (auto& part : parts) {
+            result.columns.back().appendColumn(part[i]);
         }
     }
+    projectStep.finish("Project", [&] { return joinNames(result.columnNames); }, 0, rows.size());
+    return result;
 }
 
+bool Database::sortResult(ResultSet &result, const std::vector<OrderKey> &orderBy, size_t keep) const {
+    StageTimer sorting(QueryStage::SORT);
+    OperatorTimer sortStep;
+    std::vector<SortKey> sortKeys;
+    for (const auto& key : orderBy) {
+        auto name = std::find(result.columnNames.begin(), result.columnNames.end(), key.column);
+        if (name == result.columnNames.end()) {
+            errorStream() << "ORDER BY column " << key.column << " is not in the query result." << std::endl;
+            return false;
+        }
+        sortKeys.push_back({&result.columns[name - result.columnNames.begin()], key.descending});
+    }
+    std::vector<uint32_t> rows(result.rowCount());
+    std::iota(rows.begin(), rows.end(), 0u);
+    RowSorter sorter(std::move(sortKeys), sortOptions);
+    if (!sorter.sort(rows, keep)) {
+        return false;
+    }
+    for (auto& column : result.columns) {
+        ColumnData sorted(column.getType());
+        sorted.appendRows(column, rows.data(), rows.size());
+        column = std::move(sorted);
+    }
+    nestOperators();
+    sortStep.finish(sorter.usedTopN() ? "Top-N sort" : "Sort", [&] { return describeSort(orderBy, keep, sorter); },
+                    0, rows.size());
+    return true;
+}
 
-/*void Database::saveToFile(const std::string &fileName) {
-    std::ofstream outputFile(fileName);
-    if (!outputFile) {
-        std::cerr << "Failed to open file: " << fileName << std::endl;
-        return;
+ResultSet Database::runAggregate(const Table &table, const Predicate &predicate, const ScanPlan &plan,
+                                 const std::vector<const Column*> &projection, const std::vector<int> &aggregateOf,
+                                 const std::vector<AggregateSpec> &aggregates,
+                                 const std::vector<std::string> &groupBy) const {
+    ResultSet result;
+    std::vector<int> groupColumns;
+    for (const auto& columnName : groupBy) {
+        const Column* column = table.findColumn(columnName);
+        if (column == nullptr) {
+            errorStream() << "Column " << columnName << " does not exist in table " << table.name << "." << std::endl;
+            return result;
+        }
+        groupColumns.push_back(column->index);
     }
 
-    for (const auto& table : tables) {
-        outputFile << "Table: " << table.first << std::endl;
+    // Kolumna wyniku dla każdego elementu SELECT: kolumna grupująca albo agregat
+    std::vector<size_t> source;
+    for (size_t i = 0; i < projection.size(); ++i) {
+        if (aggregateOf[i] >= 0) {
+            source.push_back(groupColumns.size() + aggregateOf[i]);
+            continue;
+        }
+        auto groupIt = std::find(groupColumns.begin(), groupColumns.end(), projection[i]->index);
+        if (groupIt == groupColumns.end()) {
+            errorStream() << "Column " << projection[i]->name << " must appear in GROUP BY." << std::endl;
+            return result;
+        }
+        source.push_back(groupIt - groupColumns.begin());
+    }
 
-        // Write column names
-        for (const auto& column : table.second.columns) {
-            outputFile << column.first << ",";
+    StageTimer aggregating(QueryStage::AGGREGATE);
+    OperatorTimer aggregateStep;
+    HashAggregator aggregator;
+    if (!aggregator.prepare(table, groupColumns, aggregates)) {
+        return result;
+    }
+    if (plan.usesIndex()) {
+        OperatorTimer scanStep;
+        std::vector<uint32_t> rows = QueryPlanner::matchingRows(table, predicate, plan);
+        scanStep.finish("Index scan", [&] { return describeAccess(table, plan); }, 1, rows.size());
+        aggregator.consumeRows(rows);
+    } else {
+        // Filtr wykonywany w trakcie agregacji, bez osobnego kroku skanu
+        aggregator.consumeScan(predicate);
+    }
+    std::vector<ColumnData> columns = aggregator.finish();
+    aggregateStep.finish("Hash aggregate", [&] {
+        std::string detail = groupBy.empty() ? "all rows" : "by " + joinNames(groupBy);
+        return plan.usesIndex() ? detail : detail + ", fused scan of " + table.name;
+    }, 0, columns.empty() ? 0 : columns.front().size());
+    std::vector<bool> used(columns.size(), false);
+    for (size_t i = 0; i < projection.size(); ++i) {
+        result.columnNames.push_back(aggregateOf[i] >= 0 ? aggregates[aggregateOf[i]].name : projection[i]->name);
+        if (used[source[i]]) {
+            result.columns.emplace_back(columns[source[i]].getType());
+            result.columns.back().appendColumn(columns[source[i]]);
+            continue;
         }
-        outputFile << std::endl;
+        used[source[i]] = true;
+        result.columns.push_back(std::move(columns[source[i]]));
+    }
+    return result;
+}
+
+ResultSet Database::selectJoin(const std::string &leftTable, const std::string &rightTable,
+                               const std::string &leftColumn, const std::string &rightColumn,
+                               const std::vector<std::string> &columns, const std::string &condition) const {
+    ErrorCapture capture;
+    std::vector<Condition> conditions;
+    DBQLParser::parseConditions(condition, conditions);
+    ResultSet result = capture.str().empty()
+                       ? runJoin(leftTable, rightTable, leftColumn, rightColumn, columns, conditions) : ResultSet();
+    result.error = capture.str();
+    return result;
+}
+
+void Database::setJoinOptions(const JoinOptions &options) {
+    joinOptions = options;
+}
 
-        // Write data rows
-        for (const auto& row : table.second.data) {
-            for (const auto& value : row.second) {
-                outputFile << value << ",";
+void Database::setSortOptions(const SortOptions &options) {
+    sortOptions = options;
+}
+
+ResultSet Database::runJoin(const std::string &leftTable, const std::string &rightTable,
+                            const std::string &leftColumn, const std::string &rightColumn,
+                            const std::vector<std::string> &columns,
+                            const std::vector<Condition> &joinConditions) const {
+    ResultSet result;
+
+    // Obie tabele wyszukane pod jedną blokadą katalogu i zablokowane po jej zwolnieniu, zawsze w kolejności
+    // nazw - dwa złączenia nie czekają na siebie, a DROP TABLE i checkpoint (katalog, potem tabele) nie czekają
+    // na złączenie, które trzymając jedną tabelę czekałoby na katalog
+    std::shared_ptr<Table> leftFound, rightFound;
+    {
+        std::shared_lock catalogLock(catalogMutex);
+        auto leftIt = tables.find(leftTable);
+        auto rightIt = tables.find(rightTable);
+        leftFound = leftIt == tables.end() ? nullptr : leftIt->second;
+        rightFound = rightIt == tables.end() ? nullptr : rightIt->second;
+    }
+    LockedTable<std::shared_lock<TableMutex>> leftHandle, rightHandle;
+    if (leftTable <= rightTable) {
+        leftHandle = lockForRead(std::move(leftFound), leftTable);
+        if (!leftHandle.table) {
+            return result;
+        }
+    }
+    if (leftTable != rightTable) {
+        rightHandle = lockForRead(std::move(rightFound), rightTable);
+        if (!rightHandle.table) {
+            return result;
+        }
+    }
+    if (leftTable > rightTable) {
+        leftHandle = lockForRead(std::move(leftFound), leftTable);
+        if (!leftHandle.table) {
+            return result;
+        }
+    }
+    const Table* sides[2] = {leftHandle.table.get(), rightHandle.table ? rightHandle.table.get() : leftHandle.table.get()};
+
+    // Strona (0 = FROM, 1 = JOIN) i kolumna dla nazwy z opcjonalnym prefiksem tabeli;
+    // w złączeniu tabeli z samą sobą nazwa bez wskazania strony należy do preferred
+    auto resolve = [&](const std::string& name, int preferred, int& side, const Column*& column) {
+        size_t dot = name.find('.');
+        std::string columnName = dot == std::string::npos ? name : name.substr(dot + 1);
+        std::vector<int> candidates;
+        if (dot == std::string::npos) {
+            candidates = {0, 1};
+        } else if (name.compare(0, dot, leftTable) == 0 && name.compare(0, dot, rightTable) == 0) {
+            candidates = {preferred};
+        } else if (name.compare(0, dot, leftTable) == 0) {
+            candidates = {0};
+        } else if (name.compare(0, dot, rightTable) == 0) {
+            candidates = {1};
+        } else {
+            errorStream() << "Table " << name.substr(0, dot) << " is not part of the join." << std::endl;
+            return false;
+        }
+        if (leftTable == rightTable && candidates.size() == 2) {
+            candidates = {preferred};
+        }
+        side = -1;
+        for (int candidate : candidates) {
+            auto colIt = sides[candidate]->columns.find(columnName);
+            if (colIt == sides[candidate]->columns.end()) {
+                continue;
+            }
+            if (side >= 0) {
+                errorStream() << "Column " << name << " is ambiguous." << std::endl;
+                return false;
+            }
+            side = candidate;
+            column = &colIt->second;
+        }
+        if (side < 0) {
+            errorStream() << "Column " << name << " does not exist in the joined tables." << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    // Warunek ON może być zapisany w dowolnej kolejności stron
+    int firstSide, secondSide;
+    const Column* firstKey = nullptr;
+    const Column* secondKey = nullptr;
+    if (!resolve(leftColumn, 0, firstSide, firstKey) || !resolve(rightColumn, 1, secondSide, secondKey)) {
+        return result;
+    }
+    if (firstSide == secondSide) {
+        errorStream() << "Join condition must compare columns of both tables." << std::endl;
+        return result;
+    }
+    if (firstSide == 1) {
+        std::swap(firstKey, secondKey);
+    }
+
+    // Projekcja: (strona, kolumna); "*" to wszystkie kolumny obu tabel z prefiksem tabeli
+    std::vector<std::pair<int, const Column*>> projection;
+    for (const auto& columnName : columns) {
+        if (columnName == "*") {
+            for (int side = 0; side < 2; ++side) {
+                std::vector<const Column*> all;
+                for (const auto& col : sides[side]->columns) {
+                    all.push_back(&col.second);
+                }
+                std::sort(all.begin(), all.end(), [](const Column* a, const Column* b) { return a->index < b->index; });
+                for (const Column* col : all) {
+                    projection.emplace_back(side, col);
+                    result.columnNames.push_back(sides[side]->name + "." + col->name);
+                }
             }
-            outputFile << std::endl;
+            continue;
+        }
+        AggregateFunction function;
+        std::string argument;
+        if (HashAggregator::parseAggregate(columnName, function, argument)) {
+            errorStream() << "Aggregates over joins are not supported." << std::endl;
+            return result;
+        }
+        int side;
+        const Column* column = nullptr;
+        if (!resolve(columnName, 0, side, column)) {
+            return result;
+        }
+        projection.emplace_back(side, column);
+        result.columnNames.push_back(columnName);
+    }
+
+    // Warunki WHERE rozdzielane na tabele i stosowane przed złączeniem
+    std::vector<Condition> conditions = joinConditions;
+    std::vector<Condition> sideConditions[2];
+    bool hasOr = false;
+    for (auto& cond : conditions) {
+        int side;
+        const Column* column = nullptr;
+        if (!resolve(cond.column, 0, side, column)) {
+            return result;
+        }
+        hasOr = hasOr || cond.logicalOperator == "OR";
+        cond.column = column->name;
+        sideConditions[side].push_back(cond);
+    }
+    if (hasOr && !sideConditions[0].empty() && !sideConditions[1].empty()) {
+        errorStream() << "OR across joined tables is not supported." << std::endl;
+        return result;
+    }
+    if (!hasOr) {
+        // Sama koniunkcja - nawiasy bez znaczenia, a po rozdzieleniu na strony nie byłyby zrównoważone
+        for (auto &side : sideConditions) {
+            for (auto &cond : side) {
+                cond.openGroups = cond.closeGroups = 0;
+            }
+        }
+    }
+    JoinInput inputs[2];
+    for (int side = 0; side < 2; ++side) {
+        auto predicate = Predicate::compile(*sides[side], sideConditions[side]);
+        if (!predicate) {
+            return result;
         }
+        inputs[side].key = &sides[side]->data[(side == 0 ? firstKey : secondKey)->index];
+        ScanPlan scan = QueryPlanner::plan(*sides[side], *predicate);
+        OperatorTimer scanStep;
+        inputs[side].rows = QueryPlanner::matchingRows(*sides[side], *predicate, scan);
+        scanStep.finish(scan.usesIndex() ? "Index scan" : "Scan", [&] { return describeAccess(*sides[side], scan); },
+                        2, inputs[side].rows.size());
+    }
+
+    JoinResult pairs;
+    {
+        StageTimer joining(QueryStage::JOIN);
+        OperatorTimer joinStep;
+        HashJoin join(inputs[0], inputs[1], joinOptions);
+        if (!join.run(pairs)) {
+            result.columnNames.clear();
+            return result;
+        }
+        joinStep.finish("Hash join", [&] { return leftColumn + " = " + rightColumn; }, 1, pairs.left.size());
+    }
+    StageTimer projecting(QueryStage::PROJECT);
+    OperatorTimer projectStep;
+
+    // Materializacja par równolegle, fragmentami, jak w runSelect
+    const std::vector<uint32_t>* rows[2] = {&pairs.left, &pairs.right};
+    std::vector<std::vector<ColumnData>> parts(ThreadPool::morselCount(pairs.left.size()));
+    ThreadPool::shared().forEachMorsel(pairs.left.size(), [&](size_t morsel, size_t first, size_t count, unsigned) {
+        for (const auto& item : projection) {
+            parts[morsel].emplace_back(item.second->type);
+            parts[morsel].back().appendRows(sides[item.first]->data[item.second->index],
+                                            rows[item.first]->data() + first, count);
+        }
+    });
+    for (size_t i = 0; i < projection.size(); ++i) {
+        if (parts.size() == 1) {
+            result.columns.push_back(std::move(parts.front()[i]));
+            continue;
+        }
+        result.columns.emplace_back(projection[i].second->type);
+        result.columns.back().reserve(pairs.left.size());
+        for (auto& part : parts) {
+            result.columns.back().appendColumn(part[i]);
+        }
+    }
+    projectStep.finish("Project", [&] { return joinNames(result.columnNames); }, 0, pairs.left.size());
+    return result;
+}
 
-        outputFile << std::endl;
+void Database::printResult(const ResultSet &result) {
+    if (!result.ok()) {
+        errorStream() << result.error;
     }
+    std::cout << result.format();
+    std::cout.flush();
+}
+
 
-    outputFile.close();
+void Database::saveToFile(const std::string &fileName) {
+    std::lock_guard changeLock(catalogChangeMutex);
+    TableCatalog saved = catalogSnapshot();
+    std::vector<std::shared_lock<TableMutex>> tableLocks;
+    for (const auto& entry : saved) {
+        tableLocks.emplace_back(entry.second->mutex);
+    }
+    Snapshot::save(saved, fileName, wal ? wal->lastLsn() : 0);
 }
-*/
-/*void Database::loadDataFromFile(const std::string &fileName) {
-    std::ifstream inputFile(fileName);
-    if (!inputFile) {
-        std::cerr << "Failed to open file: " << fileName << std::endl;
+
+void Database::loadDataFromFile(const std::string &fileName) {
+    uint64_t walLsn;
+    TableCatalog loaded;
+    if (!Snapshot::load(fileName, loaded, walLsn)) {
         return;
     }
 
-    std::string line;
-    std::string tableName;
-    std::map<std::string, Column> columns;
-    std::vector<std::vector<std::string>> data;
+    // Stare tabele oznaczane jako usunięte - uchwyty trzymane przez inne wątki nie zapiszą już do nich;
+    // blokady tabel brane bez blokady katalogu, jak w dropTable
+    std::lock_guard changeLock(catalogChangeMutex);
+    for (auto& entry : catalogSnapshot()) {
+        std::unique_lock tableLock(entry.second->mutex);
+        entry.second->dropped = true;
+    }
+    {
+        std::unique_lock catalogLock(catalogMutex);
+        tables = std::move(loaded);
+    }
+    planCache->clear();
+}
 
-    while (std::getline(inputFile, line)) {
-        if (line.empty()) {
-            if (!tableName.empty()) {
-                tables.emplace(tableName, Table{tableName, columns, std::map<std::string, std::vector<std::string>>{data.begin(), data.end()}});
-                tableName.clear();
-                columns.clear();
-                data.clear();
-            }
-        } else if (line.substr(0, 6) == "Table:") {
-            tableName = line.substr(7);
-        } else if (tableName.empty()) {
-            std::istringstream iss(line);
-            std::string columnName;
-            while (std::getline(iss, columnName, ',')) {
-                columns[columnName] = {columnName};
+void Database::openStorage(const std::string &snapshotFileName, const std::string &walFileName,
+                           std::chrono::microseconds commitWindow) {
+    wal.reset();
+    uint64_t lastLsn = 0;
+    if (std::ifstream(snapshotFileName).good()) {
+        TableCatalog loaded;
+        if (!Snapshot::load(snapshotFileName, loaded, lastLsn)) {
+            return;
+        }
+        std::lock_guard changeLock(catalogChangeMutex);
+        std::unique_lock catalogLock(catalogMutex);
+        tables = std::move(loaded);
+        planCache->clear();
+    }
+
+    // Odtworzenie operacji wykonanych po ostatniej migawce (metody same biorą blokady)
+    replaying = true;
+    bool replayed = WriteAheadLog::replay(walFileName, lastLsn, [this](const WalRecord& record) {
+        applyLogRecord(record);
+    }, lastLsn);
+    replaying = false;
+    if (!replayed) {
+        return;
+    }
+
+    auto log = std::make_unique<WriteAheadLog>(commitWindow);
+    if (!log->open(walFileName, lastLsn)) {
+        return;
+    }
+    wal = std::move(log);
+    snapshotFile = snapshotFileName;
+}
+
+void Database::checkpoint() {
+    if (!wal) {
+        errorStream() << "Storage is not open." << std::endl;
+        return;
+    }
+
+    // catalogChangeMutex i blokady tabel do odczytu: żadna zmiana nie trafi do dziennika między zapisem
+    // migawki a jego wyczyszczeniem, odczyty biegną dalej. Tabele blokowane po zwolnieniu blokady katalogu,
+    // w kolejności nazw jak w złączeniach
+    std::lock_guard changeLock(catalogChangeMutex);
+    TableCatalog saved = catalogSnapshot();
+    std::vector<UpgradeLock> tableLocks;
+    tableLocks.reserve(saved.size());
+    for (const auto& entry : saved) {
+        tableLocks.emplace_back(entry.second->mutex);
+    }
+    if (!Snapshot::save(saved, snapshotFile, wal->lastLsn())) {
+        return;
+    }
+    wal->truncate();
+    if (BufferPool::shared().capacity() == 0) {
+        return;
+    }
+
+    // Z limitem pamięci wszystkie tabele czytane są dalej ze stron nowej migawki: kopie kolumn w pamięci
+    // (kolumny zapisywane od poprzedniego punktu kontrolnego) są zwalniane, a wracają do niej tylko
+    // strony, po które sięgną zapytania. Blokada współdzielona z zapisu migawki zamieniana jest na
+    // wyłączną bez zwalniania, więc żaden zapis nie trafi między migawkę a podmianę. Zamiana od ostatniej
+    // nazwy: złączenie trzyma tabelę i czeka tylko na dalsze w kolejności, a te są już zwolnione.
+    TableCatalog mapped;
+    uint64_t walLsn;
+    if (!Snapshot::load(snapshotFile, mapped, walLsn, false)) {
+        return;
+    }
+    size_t tableNumber = saved.size();
+    for (auto entryIt = saved.rbegin(); entryIt != saved.rend(); ++entryIt) {
+        auto& entry = *entryIt;
+        Table &table = *entry.second;
+        std::unique_lock tableLock = tableLocks[--tableNumber].upgrade();
+        auto mappedIt = mapped.find(entry.first);
+        if (mappedIt == mapped.end()) {
+            continue;
+        }
+        // Podmiana zawartości, nie wektora - plany z PlanCache trzymają wskaźniki do ColumnData
+        for (size_t i = 0; i < table.data.size(); ++i) {
+            std::swap(table.data[i], mappedIt->second->data[i]);
+        }
+    }
+}
+
+uint64_t Database::logMutation(const WalRecord &record) {
+    StageTimer logging(QueryStage::WAL);
+    if (!wal || replaying) {
+        return 0;
+    }
+    return wal->append(record);
+}
+
+void Database::awaitDurable(uint64_t lsn) {
+    StageTimer syncing(QueryStage::WAL);
+    if (lsn != 0 && !wal->waitDurable(lsn)) {
+        errorStream() << "Write-ahead log is not durable, last change may be lost." << std::endl;
+    }
+}
+
+void Database::applyLogRecord(const WalRecord &record) {
+    switch (record.op) {
+        case WalOp::CREATE_TABLE:
+            createTable(record.tableName);
+            break;
+        case WalOp::DROP_TABLE:
+            dropTable(record.tableName);
+            break;
+        case WalOp::ADD_COLUMN:
+            addNewColumn(record.tableName, record.args.at(0), getTypeFromString(record.args.at(1)),
+                         record.args.size() > 2 ? record.args[2] : std::string());
+            break;
+        case WalOp::REMOVE_COLUMN:
+            removeColumn(record.tableName, record.args.at(0));
+            break;
+        case WalOp::INSERT:
+            insertData(record.tableName, record.values);
+            break;
+        case WalOp::INSERT_BATCH: {
+            RowBatch batch;
+            batch.columnNames = record.args;
+            const char* cursor = record.payload.data();
+            const char* end = cursor + record.payload.size();
+            batch.columns.resize(batch.columnNames.size());
+            for (auto& column : batch.columns) {
+                if (!column.deserialize(cursor, end)) {
+                    errorStream() << "Corrupted batch record for table " << record.tableName << "." << std::endl;
+                    return;
+                }
             }
-        } else {
-            std::istringstream iss(line);
-            std::string value;
-            std::vector<std::string> rowData;
-            while (std::getline(iss, value, ',')) {
-                rowData.push_back(value);
+            insertBatch(record.tableName, batch);
+            break;
+        }
+        case WalOp::UPDATE:
+            updateData(record.tableName, record.values, record.args.at(0), record.args.at(1));
+            break;
+        case WalOp::DELETE:
+            deleteData(record.tableName, record.args.at(0), record.args.at(1));
+            break;
+        case WalOp::CREATE_INDEX:
+            createIndex(record.tableName, record.args.at(0), record.args.at(1),
+                        record.args.at(2) == "HASH" ? IndexType::HASH : IndexType::BTREE);
+            break;
+        case WalOp::DROP_INDEX:
+            dropIndex(record.tableName, record.args.at(0));
+            break;
+    }
+}
+
+TableCatalog Database::catalogSnapshot() const {
+    std::shared_lock catalogLock(catalogMutex);
+    return tables;
+}
+
+std::shared_ptr<Table> Database::findTable(const std::string &tableName) const {
+    std::shared_lock catalogLock(catalogMutex);
+    auto tableIt = tables.find(tableName);
+    return tableIt == tables.end() ? nullptr : tableIt->second;
+}
+
+LockedTable<std::shared_lock<TableMutex>> Database::lockForRead(std::shared_ptr<Table> table,
+                                                                const std::string &tableName) {
+    if (!table) {
+        errorStream() << "Table " << tableName << " does not exist." << std::endl;
+        return {};
+    }
+    // Czas liczony tylko, gdy blokada jest zajęta
+    std::shared_lock lock(table->mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        StageTimer waiting(QueryStage::LOCK_WAIT);
+        lock.lock();
+    }
+    if (table->dropped) {
+        errorStream() << "Table " << tableName << " does not exist." << std::endl;
+        return {};
+    }
+    return {std::move(table), std::move(lock)};
+}
+
+LockedTable<std::shared_lock<TableMutex>> Database::readTable(const std::string &tableName) const {
+    return lockForRead(findTable(tableName), tableName);
+}
+
+LockedTable<std::unique_lock<TableMutex>> Database::writeTable(const std::string &tableName) {
+    std::shared_ptr<Table> table = findTable(tableName);
+    if (!table) {
+        errorStream() << "Table " << tableName << " does not exist." << std::endl;
+        return {};
+    }
+    // Czas liczony tylko, gdy blokada jest zajęta
+    std::unique_lock lock(table->mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        StageTimer waiting(QueryStage::LOCK_WAIT);
+        lock.lock();
+    }
+    if (table->dropped) {
+        errorStream() << "Table " << tableName << " does not exist." << std::endl;
+        return {};
+    }
+    return {std::move(table), std::move(lock)};
+}
+
+LockedTable<std::unique_lock<TableMutex>> Database::writeTableOwned(const std::string &tableName,
+                                                                    const std::vector<std::string> &columnNames,
+                                                                    bool appending) {
+    auto handle = writeTable(tableName);
+    if (!handle.table) {
+        return handle;
+    }
+    Table& table = *handle.table;
+    auto mappedColumns = [&table, &columnNames] {
+        std::vector<int> mapped;
+        for (const auto& col : table.columns) {
+            bool written = columnNames.empty()
+                           || std::find(columnNames.begin(), columnNames.end(), col.first) != columnNames.end();
+            if (written && table.data[col.second.index].isMapped()) {
+                mapped.push_back(col.second.index);
             }
-            data.push_back(rowData);
         }
+        return mapped;
+    };
+    if (mappedColumns().empty()) {
+        return handle;
     }
 
-    if (!tableName.empty()) {
-        std::map<std::string, std::vector<std::string>> convertedData(data.begin(), data.end());
-        tables.emplace(tableName, Table{tableName, columns, convertedData});
+    // Kopie pod blokadą współdzieloną, równolegle po kolumnach
+    handle.lock.unlock();
+    std::vector<int> mapped;
+    std::vector<ColumnData> copies;
+    std::vector<std::shared_ptr<const void>> sources;
+    uint64_t dataVersion;
+    uint64_t schemaVersion;
+    {
+        std::shared_lock readLock(table.mutex);
+        mapped = mappedColumns();
+        dataVersion = table.dataVersion;
+        schemaVersion = table.schemaVersion;
+        copies.resize(mapped.size());
+        sources.resize(mapped.size());
+        ThreadPool::shared().parallelFor(mapped.size(), [&](size_t i, unsigned) {
+            const ColumnData &source = table.data[mapped[i]];
+            sources[i] = source.mapping();
+            copies[i] = source.materialized(appending ? source.size() * 2 : source.size());
+        });
     }
 
-    inputFile.close();
+    // Podmiana tylko kolumn niezmienionych w międzyczasie (punkt kontrolny mapuje kolumny od nowa
+    // bez zmiany wersji); pozostałe skopiuje sam zapis jak dotąd
+    handle.lock.lock();
+    if (table.dropped) {
+        errorStream() << "Table " << tableName << " does not exist." << std::endl;
+        return {};
+    }
+    if (table.dataVersion == dataVersion && table.schemaVersion == schemaVersion) {
+        for (size_t i = 0; i < mapped.size(); ++i) {
+            if (table.data[mapped[i]].mapping() == sources[i]) {
+                table.data[mapped[i]] = std::move(copies[i]);
+            }
+        }
+    }
+    return handle;
 }
- */
+
 bool Column::isValidType(const std::string &value) const {
     switch (type) {
         case DataType::INT: {
-            char *end;
-            std::strtol(value.c_str(), &end, 10);
-            return *end == '\0';
+            int64_t parsed;
+            return value.empty() || parseIntValue(value, parsed);
         }
         case DataType::FLOAT: {
-            char *end;
-            std::strtof(value.c_str(), &end);
-            return *end == '\0';
+            double parsed;
+            return value.empty() || parseFloatValue(value, parsed);
         }
         case DataType::STRING:
             return true;
@@ -286,7 +1456,7 @@ bool Column::isValidType(const std::string &value) const {
 int Table::getConditionColumnIndex(const std::string &conditionColumn){
     auto colIt = columns.find(conditionColumn);
     if (colIt == columns.end()) {
-        std::cerr << "Condition column " << conditionColumn << " does not exist in table " << name << "." << std::endl;
+        errorStream() << "Condition column " << conditionColumn << " does not exist in table " << name << "." << std::endl;
         return -1;
     }
     else {
@@ -294,51 +1464,638 @@ int Table::getConditionColumnIndex(const std::string &conditionColumn){
     }
 }
 
-bool Table::isValidColumnType(const Column &column) {
-    for (const auto& existingColumn : columns) {
-        if (existingColumn.second.type != column.type) {
-            return false;
+const Column *Table::findColumn(const std::string &columnName) const {
+    auto colIt = columns.find(columnName);
+    if (colIt == columns.end() && columnName.size() > name.size() && columnName[name.size()] == '.'
+        && columnName.compare(0, name.size(), name) == 0) {
+        colIt = columns.find(columnName.substr(name.size() + 1));
+    }
+    return colIt == columns.end() ? nullptr : &colIt->second;
+}
+
+const TableIndex *Table::findIndex(int columnIndex, CompareOp op) const {
+    const TableIndex *best = nullptr;
+    for (const auto& index : indexes) {
+        if (index->getColumnIndex() != columnIndex || !index->supports(op)) {
+            continue;
+        }
+        if (best == nullptr || index->getType() == IndexType::HASH) {
+            best = index.get();
         }
     }
-    return true;
+    return best;
+}
+
+ColumnData Table::removeColumnData(int columnIndex) {
+    ColumnData removed = std::move(data[columnIndex]);
+    data.erase(data.begin() + columnIndex);
+    for (auto& col : columns) {
+        if (col.second.index > columnIndex) {
+            --col.second.index;
+        }
+    }
+
+    // Indeksy usuniętej kolumny znikają, pozostałe dostają nowe numery kolumn
+    indexes.erase(std::remove_if(indexes.begin(), indexes.end(), [columnIndex](const auto& index) {
+        return index->getColumnIndex() == columnIndex;
+    }), indexes.end());
+    for (auto& index : indexes) {
+        if (index->getColumnIndex() > columnIndex) {
+            index->setColumnIndex(index->getColumnIndex() - 1);
+        }
+    }
+    return removed;
+}
+
+void Table::markDeleted(const std::vector<uint32_t> &rows) {
+    deleted.resize((rowCount + 63) >> 6, 0);
+    for (uint32_t row : rows) {
+        for (auto& index : indexes) {
+            index->eraseRow(data[index->getColumnIndex()], row);
+        }
+        deleted[row >> 6] |= uint64_t(1) << (row & 63);
+    }
+    deletedCount += rows.size();
+}
+
+void Table::maskDeleted(size_t firstRow, size_t count, uint64_t *bits) const {
+    size_t firstWord = firstRow >> 6;
+    if (deletedCount == 0 || firstWord >= deleted.size()) {
+        return;
+    }
+    FilterKernels::andNotBitmap(bits, deleted.data() + firstWord, std::min((count + 63) >> 6, deleted.size() - firstWord));
+}
+
+void Table::eraseDeleted(TableIndex &index) const {
+    const ColumnData& column = data[index.getColumnIndex()];
+    forEachSelected(deleted, [&](size_t row) {
+        index.eraseRow(column, row);
+    });
+}
+
+void Table::optimizeEncoding(size_t previousRows) {
+    if (std::bit_width(previousRows) == std::bit_width(rowCount) || rowCount < ColumnData::DICTIONARY_MIN_ROWS) {
+        return;
+    }
+    for (auto &column : data) {
+        column.optimizeEncoding();
+    }
+}
+
+bool Table::isValidColumnType(const Column &column) const {
+    // Kolumny tabeli mogą mieć różne typy; sprawdzany jest sam typ i zgodność wartości domyślnej
+    return column.isValidType(column.defaultValue);
 }
 
 
 void Database::executeQuery(const std::string& query){
-    DBQLParser dbqlParser(query);
+    // SELECT wypisywany porcjami z kursora, bez składania całego wyniku w pamięci
+    DBQLLexer lexer(query);
+    if (lexer.next().is("SELECT")) {
+        auto cursor = openCursor(query);
+        printCursor(*cursor);
+        return;
+    }
+    printResult(execute(query));
+}
 
+std::unique_ptr<ResultCursor> Database::openCursor(const std::string &query) const {
+    Statement statement;
+    ErrorCapture capture;
+    if (!DBQLParser::parseStatement(query, statement)) {
+        std::unique_ptr<ResultCursor> cursor(new ResultCursor());
+        cursor->error = capture.str();
+        return cursor;
+    }
+    return openStatementCursor(statement);
+}
 
-    // Otrzymujemy elementy zapytania
-    auto tableName = dbqlParser.getTableName();
-    auto columns = dbqlParser.getColumns();
-    auto condition = dbqlParser.getCondition();
+std::unique_ptr<ResultCursor> Database::openCursor(const PreparedStatement &statement) const {
+    if (!statement.ok() || statement.firstUnbound() < statement.parameterCount()) {
+        std::unique_ptr<ResultCursor> cursor(new ResultCursor());
+        cursor->error = statement.ok() ? "Parameter " + std::to_string(statement.firstUnbound()) + " is not bound.\n"
+                                       : statement.getError();
+        return cursor;
+    }
+    return openStatementCursor(statement.getStatement());
+}
 
-    // Wykonanie zapytania
-    selectData(tableName, columns, condition);
+std::unique_ptr<ResultCursor> Database::openStatementCursor(const Statement &statement) const {
+    std::unique_ptr<ResultCursor> cursor(new ResultCursor());
+    ErrorCapture capture;
+    prepareCursor(statement, *cursor);
+    cursor->error = capture.str();
+    return cursor;
 }
 
-void Database::addNewColumn(const std::string& tableName, const std::string& columnName, DataType columnType) {
-    auto tableIt = tables.find(tableName);
-    if (tableIt == tables.end()) {
-        std::cerr << "Table " << tableName << " does not exist." << std::endl;
+void Database::prepareCursor(const Statement &statement, ResultCursor &cursor) const {
+    if (statement.type != StatementType::SELECT || statement.explain != ExplainMode::NONE) {
+        errorStream() << "Only SELECT can be read through a cursor." << std::endl;
+        return;
+    }
+    size_t limit = ResultCursor::NO_LIMIT;
+    size_t offset = 0;
+    if (!parseRowCount(statement.limit, "LIMIT", limit) || !parseRowCount(statement.offset, "OFFSET", offset)) {
+        return;
+    }
+    // OFFSET pomijany przed ustawieniem LIMIT, żeby nie pomniejszał liczby wierszy do wydania
+    auto start = [&cursor, limit, offset]() {
+        cursor.skip(offset);
+        cursor.remaining = limit;
+    };
+
+    // Złączenia i agregaty liczone w całości, kursor tylko je stronicuje
+    auto materialize = [&cursor, &start](ResultSet result) {
+        cursor.materialized = true;
+        cursor.columnNames = result.columnNames;
+        for (const auto& column : result.columns) {
+            cursor.types.push_back(column.getType());
+        }
+        cursor.result = std::move(result);
+        start();
+    };
+    if (!statement.join.tableName.empty()) {
+        if (!statement.groupBy.empty()) {
+            errorStream() << "GROUP BY over joins is not supported." << std::endl;
+            return;
+        }
+        ResultSet result = runJoin(statement.tableName, statement.join.tableName, statement.join.leftColumn,
+                                   statement.join.rightColumn, statement.columns, statement.conditions);
+        if (!statement.orderBy.empty() && !result.columnNames.empty()
+            && !sortResult(result, statement.orderBy, rowsToKeep(limit, offset))) {
+            return;
+        }
+        materialize(std::move(result));
         return;
     }
 
-    // Sprawdzenie, czy kolumna o podanej nazwie już istnieje
-    if (tableIt->second.columns.find(columnName) != tableIt->second.columns.end()) {
-        std::cerr << "Column " << columnName << " already exists in table " << tableName << "." << std::endl;
+    auto handle = readTable(statement.tableName);
+    if (!handle.table) {
+        return;
+    }
+    const Table& table = *handle.table;
+    std::optional<StageTimer> planning(std::in_place, QueryStage::PLAN);
+    SelectPlan plan;
+    if (!resolveProjection(table, statement.columns, plan)) {
         return;
     }
+    auto predicate = Predicate::compile(table, statement.conditions);
+    if (!predicate) {
+        return;
+    }
+    ScanPlan scan = QueryPlanner::plan(table, *predicate);
+    planning.reset();
+    // ORDER BY z LIMIT sortuje tylko LIMIT + OFFSET najlepszych wierszy (top-N), kursor stronicuje wynik
+    if (!plan.aggregates.empty() || !statement.groupBy.empty() || !statement.orderBy.empty()) {
+        ResultSet result = runScan(table, plan, *predicate, scan, statement.groupBy, statement.orderBy,
+                                   rowsToKeep(limit, offset));
+        handle.lock.unlock();
+        materialize(std::move(result));
+        return;
+    }
+
+    // Skan leniwy. Indeks tylko dla równości - zakres (np. stronicowanie po kluczu "id > ?")
+    // czyta tabelę po kolei z pomijaniem bloków przez zone maps i kończy po LIMIT wierszach
+    cursor.table = handle.table;
+    cursor.schemaVersion = table.schemaVersion;
+    cursor.dataVersion = table.dataVersion;
+    cursor.conditions = statement.conditions;
+    for (const Column* col : plan.projection) {
+        cursor.columnNames.push_back(col->name);
+        cursor.projection.push_back(col->index);
+        cursor.types.push_back(col->type);
+    }
+    if (scan.usesIndex() && scan.indexComparison->op == CompareOp::EQ) {
+        cursor.useIndex = true;
+        scan.index->lookup(*scan.indexComparison, cursor.candidates);
+        std::sort(cursor.candidates.begin(), cursor.candidates.end());
+    }
+    if (QueryProfile *profile = QueryProfile::active(); profile != nullptr && profile->collectsOperators()) {
+        // Wiersze skanu leniwego liczy dopiero odczyt z kursora
+        profile->addOperator({"Streaming scan", describeAccess(table, cursor.useIndex ? scan : ScanPlan()), 0});
+    }
+    cursor.predicate = std::move(predicate);
+    cursor.compactions = table.compactions;
+    handle.table->lastCursorUse = std::chrono::steady_clock::now().time_since_epoch().count();
+    ++handle.table->openCursors;
+    handle.lock.unlock();
+    start();
+}
+
+void Database::printCursor(ResultCursor &cursor) {
+    while (!cursor.done()) {
+        ResultSet batch = cursor.next();
+        std::cout << batch.format();
+    }
+    if (!cursor.ok()) {
+        errorStream() << cursor.getError();
+    }
+    std::cout.flush();
+}
+
+ResultSet Database::execute(const std::string &query) {
+    QueryProfile profile;
+    ErrorCapture capture;
+    ResultSet result;
+
+    // Ten sam kształt zapytania z innymi literałami trafia w ten sam wpis pamięci podręcznej
+    std::string key;
+    std::vector<std::string_view> literals;
+    std::shared_ptr<CachedQuery> cached;
+    std::optional<StageTimer> parsing(std::in_place, QueryStage::PARSE);
+    if (DBQLParser::normalize(query, key, literals)) {
+        cached = planCache->find(key);
+        if (!cached) {
+            auto fresh = std::make_shared<CachedQuery>();
+            bool parsed;
+            {
+                // Błędy zgłaszamy dla oryginalnego tekstu, nie dla postaci znormalizowanej
+                ErrorCapture ignored;
+                parsed = DBQLParser::parseStatement(key, fresh->statement)
+                         && fresh->statement.parameters.size() == literals.size();
+            }
+            if (parsed) {
+                StatementType type = fresh->statement.type;
+                if (type == StatementType::SELECT || type == StatementType::INSERT || type == StatementType::UPDATE
+                    || type == StatementType::DELETE) {
+                    planCache->insert(key, fresh);
+                }
+                cached = std::move(fresh);
+            }
+        }
+    }
+    if (cached) {
+        parsing.reset();
+        result = runCached(*cached, literals);
+    } else {
+        Statement statement;
+        bool parsed = DBQLParser::parseStatement(query, statement);
+        parsing.reset();
+        if (parsed) {
+            result = runStatement(statement);
+        }
+    }
+    result.error = capture.str();
+    profile.rowsReturned = result.rowCount();
+    monitor->record(query, profile, !result.ok());
+    return result;
+}
+
+ResultSet Database::execute(const PreparedStatement &statement) {
+    QueryProfile profile;
+    ErrorCapture capture;
+    ResultSet result;
+    if (!statement.ok()) {
+        errorStream() << statement.getError();
+    } else if (statement.firstUnbound() < statement.parameterCount()) {
+        errorStream() << "Parameter " << statement.firstUnbound() << " is not bound." << std::endl;
+    } else {
+        result = runStatement(statement.getStatement());
+    }
+    result.error = capture.str();
+    profile.rowsReturned = result.rowCount();
+    monitor->record(statement.getText(), profile, !result.ok());
+    return result;
+}
+
+ResultSet Database::runCached(CachedQuery &query, const std::vector<std::string_view> &literals) {
+    const Statement& statement = query.statement;
+    if (statement.type == StatementType::SELECT && statement.join.tableName.empty() && !statement.paged()
+        && statement.explain == ExplainMode::NONE) {
+        // Literały warunków: z tekstu zapytania albo z pozostawionych w drzewie słów
+        std::vector<std::string_view> values(statement.conditions.size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = statement.conditions[i].value;
+        }
+        for (size_t i = 0; i < literals.size(); ++i) {
+            values[statement.parameters[i].index] = literals[i];
+        }
+        return runCachedSelect(query, values);
+    }
+
+    Statement bound = statement;
+    for (size_t i = 0; i < literals.size(); ++i) {
+        bound.parameterValue(statement.parameters[i]).assign(literals[i]);
+    }
+    return runStatement(bound);
+}
+
+ResultSet Database::runExplain(const Statement &statement) {
+    if (statement.type != StatementType::SELECT) {
+        errorStream() << "EXPLAIN supports only SELECT." << std::endl;
+        return {};
+    }
+    Statement query = statement;
+    query.explain = ExplainMode::NONE;
+    std::vector<OperatorStats> steps;
+    std::vector<std::string> summary;
+    if (statement.explain == ExplainMode::PLAN) {
+        if (!describePlan(query, steps)) {
+            return {};
+        }
+    } else {
+        // Wykonanie z profilem zbierającym kroki; wynik zapytania jest odrzucany
+        QueryProfile profile(true);
+        ResultSet executed;
+        std::string error;
+        {
+            ErrorCapture capture;
+            executed = runStatement(query);
+            error = capture.str();
+        }
+        if (!error.empty()) {
+            errorStream() << error;
+            return {};
+        }
+        steps = std::move(profile.operators);
+        if (query.paged()) {
+            for (auto& step : steps) {
+                ++step.depth;
+            }
+            steps.push_back({"Limit", query.limit + (query.offset.empty() ? "" : " offset " + query.offset), 0, true,
+                             executed.rowCount(), profile.elapsedNanos()});
+        }
+        std::string stages;
+        for (size_t i = 0; i < QUERY_STAGE_COUNT; ++i) {
+            if (profile.stageNanos[i] != 0) {
+                stages += (stages.empty() ? "Stages: " : ", ") + std::string(stageName(static_cast<QueryStage>(i)))
+                          + " " + formatMillis(profile.stageNanos[i]);
+            }
+        }
+        if (!stages.empty()) {
+            summary.push_back(stages);
+        }
+        summary.push_back("Total: " + formatMillis(profile.elapsedNanos()) + ", rows " + std::to_string(executed.rowCount())
+                          + ", rows scanned " + std::to_string(profile.rowsScanned)
+                          + ", blocks skipped " + std::to_string(profile.blocksSkipped));
+    }
+
+    // Kroki zapisane w kolejności wykonania - wypisywane od korzenia planu
+    ResultSet result;
+    result.columnNames.push_back("QUERY PLAN");
+    result.columns.emplace_back(DataType::STRING);
+    for (auto step = steps.rbegin(); step != steps.rend(); ++step) {
+        std::string line = std::string(step->depth * 2, ' ') + (step->depth > 0 ? "-> " : "") + step->name;
+        if (!step->detail.empty()) {
+            line += " " + step->detail;
+        }
+        if (step->analyzed) {
+            line += " (rows=" + std::to_string(step->rows) + ", time=" + formatMillis(step->nanos) + ")";
+        }
+        result.columns.back().appendString(line);
+    }
+    for (const auto& line : summary) {
+        result.columns.back().appendString(line);
+    }
+    return result;
+}
+
+bool Database::describePlan(const Statement &statement, std::vector<OperatorStats> &steps) const {
+    if (!statement.join.tableName.empty()) {
+        // Strony złączenia planowane dopiero przy wykonaniu (warunki dzielone między tabele)
+        steps.push_back({"Scan", statement.tableName, 2});
+        steps.push_back({"Scan", statement.join.tableName, 2});
+        steps.push_back({"Hash join", statement.join.leftColumn + " = " + statement.join.rightColumn, 1});
+        steps.push_back({"Project", joinNames(statement.columns), 0});
+        if (!statement.orderBy.empty()) {
+            for (auto& step : steps) {
+                ++step.depth;
+            }
+            steps.push_back({statement.paged() ? "Top-N sort" : "Sort", describeOrder(statement.orderBy), 0});
+        }
+    } else {
+        auto handle = readTable(statement.tableName);
+        if (!handle.table) {
+            return false;
+        }
+        const Table& table = *handle.table;
+        SelectPlan plan;
+        if (!resolveProjection(table, statement.columns, plan)) {
+            return false;
+        }
+        auto predicate = Predicate::compile(table, statement.conditions);
+        if (!predicate) {
+            return false;
+        }
+        ScanPlan scan = QueryPlanner::plan(table, *predicate);
+        if (!plan.aggregates.empty() || !statement.groupBy.empty()) {
+            if (scan.usesIndex()) {
+                steps.push_back({"Index scan", describeAccess(table, scan), 1});
+            }
+            std::string detail = statement.groupBy.empty() ? "all rows" : "by " + joinNames(statement.groupBy);
+            steps.push_back({"Hash aggregate", scan.usesIndex() ? detail : detail + ", fused scan of " + table.name, 0});
+            if (!statement.orderBy.empty()) {
+                for (auto& step : steps) {
+                    ++step.depth;
+                }
+                steps.push_back({statement.paged() ? "Top-N sort" : "Sort", describeOrder(statement.orderBy), 0});
+            }
+        } else {
+            // Sortowanie numerów wierszy między skanem a projekcją
+            for (const auto& key : statement.orderBy) {
+                if (table.findColumn(key.column) == nullptr) {
+                    errorStream() << "Column " << key.column << " does not exist in table " << table.name << "."
+                                  << std::endl;
+                    return false;
+                }
+            }
+            size_t limit = RowSorter::ALL_ROWS;
+            size_t offset = 0;
+            if (!parseRowCount(statement.limit, "LIMIT", limit) || !parseRowCount(statement.offset, "OFFSET", offset)) {
+                return false;
+            }
+            size_t keep = rowsToKeep(limit, offset);
+            if (statement.orderBy.empty()) {
+                steps.push_back({scan.usesIndex() ? "Index scan" : "Scan", describeAccess(table, scan), 1});
+            } else if (!scan.usesIndex() && RowSorter::prefersTopN(keep, table.rowCount)) {
+                steps.push_back({"Top-N sort", describeOrder(statement.orderBy) + ", fused scan of " + table.name, 1});
+            } else {
+                steps.push_back({scan.usesIndex() ? "Index scan" : "Scan", describeAccess(table, scan), 2});
+                steps.push_back({statement.paged() ? "Top-N sort" : "Sort", describeOrder(statement.orderBy), 1});
+            }
+            steps.push_back({"Project", joinNames(statement.columns), 0});
+        }
+    }
+    if (statement.paged()) {
+        for (auto& step : steps) {
+            ++step.depth;
+        }
+        steps.push_back({"Limit", statement.limit + (statement.offset.empty() ? "" : " offset " + statement.offset), 0});
+    }
+    return true;
+}
 
-    // Dodanie nowej kolumny do istniejącej tabeli
-    int columnIndex = static_cast<int>(tableIt->second.columns.size());
-    tableIt->second.columns[columnName] = Column{columnName, columnType, columnIndex};
+ResultSet Database::runStatement(const Statement &statement) {
+    if (statement.explain != ExplainMode::NONE) {
+        return runExplain(statement);
+    }
+    std::optional<StageTimer> writing;
+    if (statement.type != StatementType::SELECT) {
+        writing.emplace(QueryStage::WRITE);
+    }
+    switch (statement.type) {
+        case StatementType::SELECT:
+            if (!statement.limit.empty() || !statement.offset.empty()) {
+                auto cursor = openStatementCursor(statement);
+                if (!cursor->ok()) {
+                    errorStream() << cursor->getError();
+                    return {};
+                }
+                ResultSet result = cursor->fetchAll();
+                errorStream() << result.error;
+                return result;
+            }
+            if (statement.join.tableName.empty()) {
+                return runSelect(statement.tableName, statement.columns, statement.conditions, statement.groupBy,
+                                 statement.orderBy);
+            }
+            if (!statement.groupBy.empty()) {
+                errorStream() << "GROUP BY over joins is not supported." << std::endl;
+                return {};
+            }
+            {
+                ResultSet result = runJoin(statement.tableName, statement.join.tableName, statement.join.leftColumn,
+                                           statement.join.rightColumn, statement.columns, statement.conditions);
+                if (!statement.orderBy.empty() && !result.columnNames.empty()
+                    && !sortResult(result, statement.orderBy, RowSorter::ALL_ROWS)) {
+                    return {};
+                }
+                return result;
+            }
+        case StatementType::INSERT: {
+            // Bez listy kolumn wartości idą do kolumn w kolejności schematu
+            std::vector<std::string> columnNames = statement.columns;
+            if (columnNames.empty()) {
+                for (const auto& column : getSchema(statement.tableName)) {
+                    columnNames.push_back(column.name);
+                }
+                if (columnNames.size() != statement.rowWidth) {
+                    errorStream() << "Table " << statement.tableName << " has " << columnNames.size()
+                                  << " columns but INSERT has " << statement.rowWidth << " values." << std::endl;
+                    return {};
+                }
+            }
+            for (size_t first = 0; first < statement.values.size(); first += statement.rowWidth) {
+                std::map<std::string, std::string> rowData;
+                for (size_t i = 0; i < statement.rowWidth; ++i) {
+                    rowData[columnNames[i]] = statement.values[first + i];
+                }
+                insertData(statement.tableName, rowData);
+            }
+            break;
+        }
+        case StatementType::UPDATE: {
+            std::map<std::string, std::string> updateValues;
+            for (size_t i = 0; i < statement.columns.size(); ++i) {
+                updateValues[statement.columns[i]] = statement.values[i];
+            }
+            const Condition& condition = statement.conditions.front();
+            updateData(statement.tableName, updateValues, condition.column, condition.value);
+            break;
+        }
+        case StatementType::DELETE:
+            deleteData(statement.tableName, statement.conditions.front().column, statement.conditions.front().value);
+            break;
+        case StatementType::CREATE_TABLE: {
+            // Kolumny dodawane tylko do nowo utworzonej tabeli
+            std::string createError;
+            {
+                ErrorCapture created;
+                createTable(statement.tableName);
+                createError = created.str();
+            }
+            if (!createError.empty()) {
+                errorStream() << createError;
+                break;
+            }
+            for (size_t i = 0; i < statement.columns.size(); ++i) {
+                addNewColumn(statement.tableName, statement.columns[i], statement.columnTypes[i]);
+            }
+            break;
+        }
+        case StatementType::DROP_TABLE:
+            dropTable(statement.tableName);
+            break;
+        case StatementType::CREATE_INDEX:
+            createIndex(statement.index.tableName, statement.index.indexName, statement.index.columnName,
+                        statement.index.method == "HASH" ? IndexType::HASH : IndexType::BTREE);
+            break;
+        case StatementType::DROP_INDEX:
+            dropIndex(statement.tableName, statement.index.indexName);
+            break;
+        case StatementType::ADD_COLUMN:
+            addNewColumn(statement.tableName, statement.columns.front(), statement.columnTypes.front(),
+                         statement.values.empty() ? std::string() : statement.values.front());
+            break;
+        case StatementType::DROP_COLUMN:
+            removeColumn(statement.tableName, statement.columns.front());
+            break;
+    }
+    return {};
+}
+
+void Database::addNewColumn(const std::string& tableName, const std::string& columnName, DataType columnType,
+                            const std::string& defaultValue) {
+    Column column(columnName, columnType, -1);
+    column.defaultValue = defaultValue;
+
+    // Wartości nowej kolumny budowane bez blokady tabeli - odczyty i zapisy trwają w tym czasie;
+    // pod blokadą wyłączną zostaje dopisanie wierszy wstawionych w międzyczasie i zmiana schematu
+    size_t rows = 0;
+    {
+        auto handle = readTable(tableName);
+        if (!handle.table) {
+            return;
+        }
+        if (handle.table->columns.find(columnName) != handle.table->columns.end()) {
+            errorStream() << "Column " << columnName << " already exists in table " << tableName << "." << std::endl;
+            return;
+        }
+        if (!handle.table->isValidColumnType(column)) {
+            errorStream() << "Invalid default value for column " << columnName << " in table " << tableName << "." << std::endl;
+            return;
+        }
+        rows = handle.table->rowCount;
+    }
+    // NULL, napisy i zera bez wypełniania kolumny (attachRepeated) - wiersze powstają przed pierwszym zapisem
+    // do kolumny, pod blokadą współdzieloną (writeTableOwned), albo przy kompakcji; inne liczby budowane tu,
+    // poza blokadą
+    bool null = defaultValue.empty();
+    ColumnData values(columnType);
+    bool lazy = values.attachRepeated(defaultValue, null, rows);
+    if (!lazy) {
+        appendDefault(values, column, rows);
+    }
 
+    auto handle = writeTable(tableName);
+    if (!handle.table) {
+        return;
+    }
+    Table& table = *handle.table;
+    if (table.columns.find(columnName) != table.columns.end()) {
+        errorStream() << "Column " << columnName << " already exists in table " << tableName << "." << std::endl;
+        return;
+    }
 
-    // Zainicjowanie pustych wartości dla nowej kolumny we wszystkich wierszach
-    for (auto& row : tableIt->second.data) {
-        row.second.push_back("");
+    uint64_t lsn = logMutation({WalOp::ADD_COLUMN, tableName, {columnName, getTypeName(columnType), defaultValue}, {}, {}});
+
+    // Tabela mogła w międzyczasie urosnąć (wstawienia) albo zmaleć (kompakcja)
+    if (lazy && values.size() != table.rowCount) {
+        lazy = values.attachRepeated(defaultValue, null, table.rowCount);
+    }
+    if (!lazy) {
+        if (values.size() > table.rowCount) {
+            values = ColumnData(columnType);
+        }
+        appendDefault(values, column, table.rowCount - values.size());
     }
+    column.index = static_cast<int>(table.data.size());
+    table.columns.emplace(columnName, column);
+    table.data.push_back(std::move(values));
+    ++table.schemaVersion;
+    planCache->invalidate(tableName);
+    handle.lock.unlock();
+    awaitDurable(lsn);
 }
 
 
@@ -2,14 +2,19 @@
 #define DATABASE_DATABASE_H
 
 #include "PreRequistion.h"
-
-// Definicje typów danych
-enum class DataType {
-    INT, FLOAT, STRING
-};
-
-DataType getTypeFromString(const std::string &typeString);
-
+#include "ColumnStore.h"
+#include "Index.h"
+#include "WriteAheadLog.h"
+#include "ResultSet.h"
+#include "Join.h"
+#include "Sorting.h"
+#include "DBQLParser.h"
+#include "Instrumentation.h"
+#include "TableMutex.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
 
 // Struktura reprezentująca kolumnę
 struct Column {
@@ -23,6 +28,7 @@ struct Column {
     bool isValidType(const std::string &value) const;
 
     int index;
+    std::string defaultValue; // dla istniejących wierszy przy ALTER ADD i wstawień bez tej kolumny; pusta = NULL
 
 
 };
@@ -30,18 +36,97 @@ struct Column {
 // Struktura reprezentująca tabelę
 struct Table {
     std::string name;
-    std::map<std::string, std::vector<std::string>> data;
     std::map<std::string, Column> columns;
+    std::vector<ColumnData> data; // Dane kolumnowe, indeks = Column::index
+    size_t rowCount = 0;
+    std::vector<std::unique_ptr<TableIndex>> indexes; // Indeksy pomocnicze
+
+    // Blokada tabeli: odczyty współdzielone, modyfikacje na wyłączność (czekający piszący wstrzymuje nowe odczyty)
+    mutable TableMutex mutex;
+    bool dropped = false; // ustawiane pod blokadą przy DROP TABLE, uchwyty sprawdzają je po zablokowaniu
+    uint64_t schemaVersion = 0; // zwiększane przy zmianie kolumn albo indeksów; plan z PlanCache jest ważny dla jednej wersji
+
+    // Usunięte wiersze (tombstones): bit row & 63 słowa row >> 6. Zostają w kolumnach do kompakcji;
+    // skany i agregaty je pomijają, indeksy ich nie zawierają. rowCount liczy też usunięte wiersze.
+    std::vector<uint64_t> deleted;
+    size_t deletedCount = 0;
+    uint64_t dataVersion = 0; // zwiększane przy każdej zmianie wierszy; kompakcja w tle sprawdza, czy tabela się nie zmieniła
+    std::atomic<bool> compactionScheduled{false};
+    std::atomic<int> openCursors{0}; // kursory skanujące tabelę (ResultCursor) trzymają numery wierszy - kompakcja czeka
+    std::atomic<std::chrono::steady_clock::rep> lastCursorUse{0}; // ostatni odczyt przez kursor (steady_clock)
+    uint64_t compactions = 0; // przepisania przez kompakcję; kursory otwarte wcześniej są nieważne
+
+    int getConditionColumnIndex(const std::string &conditionColumn);
+    bool isValidColumnType(const Column &column) const;
+
+    // Kolumna po nazwie, także z prefiksem tabeli ("u.k" dla tabeli u); nullptr, gdy jej nie ma
+    const Column *findColumn(const std::string &columnName) const;
+
+    // Najlepszy indeks na kolumnie obsługujący dany operator (nullptr, jeśli brak)
+    const TableIndex *findIndex(int columnIndex, CompareOp op) const;
+
+    // Przenumerowanie Column::index i indeksów po usunięciu kolumny; zwraca dane usuniętej kolumny,
+    // żeby wywołujący zwolnił je po zdjęciu blokady
+    ColumnData removeColumnData(int columnIndex);
+
+    bool isDeleted(size_t row) const {
+        return (row >> 6) < deleted.size() && ((deleted[row >> 6] >> (row & 63)) & 1);
+    }
+
+    // Oznacza wiersze jako usunięte (każdy żywy, bez powtórzeń) i usuwa je z indeksów
+    void markDeleted(const std::vector<uint32_t> &rows);
+
+    // bits &= ~deleted dla wierszy [firstRow, firstRow + count); firstRow wielokrotnością 64
+    void maskDeleted(size_t firstRow, size_t count, uint64_t *bits) const;
+
+    // Usuwa z indeksu (np. właśnie zbudowanego ze wszystkich wierszy) wiersze oznaczone jako usunięte
+    void eraseDeleted(TableIndex &index) const;
+
+    // Po przekroczeniu kolejnej potęgi dwójki wierszy kolumny STRING wybierają kodowanie
+    // (słownik albo zwykłe napisy, ColumnData::optimizeEncoding); koszt rozłożony na wstawienia
+    void optimizeEncoding(size_t previousRows);
+};
 
+// Wsad wierszy w układzie kolumnowym: columns[i] to wartości kolumny columnNames[i],
+// wszystkie kolumny tej samej długości i typu zgodnego z tabelą
+struct RowBatch {
+    std::vector<std::string> columnNames;
+    std::vector<ColumnData> columns;
 
-    int getConditionColumnIndex(const std::string &conditionColumn); // Mapa kolumna -> lista wartości
-    bool isValidColumnType(const Column &column);
+    size_t rowCount() const { return columns.empty() ? 0 : columns.front().size(); }
 };
 
+class Predicate;
+
+struct ScanPlan;
+
+struct AggregateSpec;
+
+struct SelectPlan;
+
+class CachedQuery;
+
+class PlanCache;
+
+class ResultCursor;
+
+using TableCatalog = std::map<std::string, std::shared_ptr<Table>>; // Mapa nazwa tabeli -> tabela
+
+// Tabela utrzymywana przy życiu i zablokowana na czas jednej operacji
+template<typename Lock>
+struct LockedTable {
+    std::shared_ptr<Table> table;
+    Lock lock;
+};
+
+// Operacje na różnych tabelach biegną równolegle, na jednej tabeli wielu czytelników
+// albo jeden piszący. Katalog tabel ma osobną blokadę trzymaną tylko na czas wyszukania.
 class Database {
 public:
     Database();
 
+    ~Database();
+
 
     // Metody DDL
     void createTable(const std::string &tableName);
@@ -50,13 +135,27 @@ public:
 
     void addColumn(const std::string &tableName, const Column &column);
 
-    void addNewColumn(const std::string& tableName, const std::string& columnName, DataType columnType);
+    // Istniejące wiersze dostają defaultValue (pusta = NULL). Dla NULL, napisów i zera tylko metadane:
+    // kolumna czyta wyzerowaną pamięć i wypełnia się przy pierwszym zapisie do niej albo przy kompakcji
+    // (ColumnData::attachRepeated). Inne liczby budowane poza blokadą tabeli, więc ALTER TABLE ADD
+    // nie wstrzymuje zapytań na czas wypełniania kolumny.
+    void addNewColumn(const std::string& tableName, const std::string& columnName, DataType columnType,
+                      const std::string& defaultValue = std::string());
 
     void removeColumn(const std::string &tableName, const std::string &columnName);
 
+    void createIndex(const std::string &tableName, const std::string &indexName, const std::string &columnName,
+                     IndexType indexType);
+
+    void dropIndex(const std::string &tableName, const std::string &indexName);
+
     // Metody DML
     void insertData(const std::string &tableName, const std::map<std::string, std::string> &rowData);
 
+    // Wstawienie wielu wierszy naraz (jeden rekord WAL, kolumny dopisywane blokami);
+    // false (z komunikatem), gdy wsad odrzucono i nic nie wstawiono
+    bool insertBatch(const std::string &tableName, const RowBatch &batch);
+
     void updateData(const std::string &tableName, const std::map<std::string, std::string> &updateValues,
                     const std::string &conditionColumn, const std::string &conditionValue);
 
@@ -67,19 +166,188 @@ public:
     void
     selectData(const std::string &tableName, const std::vector<std::string> &columns, const std::string &condition);
 
+    // Jak selectData, ale wynik (albo komunikaty błędów) wraca jako ResultSet zamiast na std::cout.
+    // Kolumny mogą zawierać agregaty COUNT/SUM/MIN/MAX/AVG, np. "SUM(price)" albo "COUNT(*)";
+    // pozostałe kolumny muszą wtedy należeć do groupBy.
+    ResultSet select(const std::string &tableName, const std::vector<std::string> &columns,
+                     const std::string &condition, const std::vector<std::string> &groupBy = {}) const;
+
+    // SELECT ... FROM leftTable JOIN rightTable ON leftColumn = rightColumn [WHERE ...] jako złączenie
+    // haszujące. Kolumny i warunki mogą mieć prefiks tabeli ("a.x"); "*" to wszystkie kolumny obu tabel.
+    // Warunki WHERE filtrują każdą tabelę przed złączeniem, więc OR nie może łączyć obu tabel.
+    ResultSet selectJoin(const std::string &leftTable, const std::string &rightTable, const std::string &leftColumn,
+                         const std::string &rightColumn, const std::vector<std::string> &columns,
+                         const std::string &condition) const;
+
+    // Pamięć podręczna i budżet pamięci złączeń; ustawiane przed uruchomieniem zapytań
+    void setJoinOptions(const JoinOptions &options);
+
+    // Budżet pamięci sortowania ORDER BY i katalog jego plików tymczasowych; ustawiane przed uruchomieniem zapytań
+    void setSortOptions(const SortOptions &options);
+
+    // DELETE tylko oznacza wiersze; gdy usunięte stanowią więcej niż fraction wierszy tabeli
+    // (i co najmniej COMPACTION_MIN_ROWS), tabela jest przepisywana w tle. fraction >= 1 wyłącza kompakcję w tle.
+    void setCompactionThreshold(double fraction);
+
+    // Natychmiastowa kompakcja tabeli (usunięcie oznaczonych wierszy z kolumn i przenumerowanie indeksów);
+    // pomijana, gdy tabela ma otwarte kursory używane w ciągu setCursorIdleTimeout
+    void compactTable(const std::string &tableName);
+
+    // Kursory tabeli nieużywane dłużej niż timeout nie wstrzymują kompakcji - przepisanie tabeli je unieważnia
+    // (kolejny next() zwraca błąd), więc kursor porzucony przez klienta bez zamknięcia nie blokuje jej na zawsze
+    void setCursorIdleTimeout(std::chrono::milliseconds timeout);
 
+    static constexpr size_t COMPACTION_MIN_ROWS = 1024;
 
 
-    // Zapis/Odczyt
-    //void saveToFile(const std::string &fileName);
 
-    // void loadDataFromFile(const std::string &fileName);
+
+    // Zapis/Odczyt (binarna migawka, patrz Snapshot.h)
+    void saveToFile(const std::string &fileName);
+
+    void loadDataFromFile(const std::string &fileName);
+
+    // Trwałość: migawka + dziennik WAL. Wczytuje migawkę, odtwarza dziennik i od tej pory
+    // każda operacja modyfikująca jest logowana przed wykonaniem (grupowy fsync, patrz WriteAheadLog).
+    void openStorage(const std::string &snapshotFileName, const std::string &walFileName,
+                     std::chrono::microseconds commitWindow = std::chrono::microseconds(0));
+
+    // Zapis migawki i wyczyszczenie dziennika; wstrzymuje zapisy na czas zapisu migawki.
+    // Z limitem pamięci (BufferPool) wszystkie tabele przechodzą potem na strony zapisanej migawki.
+    // Limit obejmuje tylko te strony: kolumna zapisywana po punkcie kontrolnym jest kopiowana do pamięci
+    // przy pierwszym zapisie i zostaje poza limitem do następnego punktu kontrolnego.
+    void checkpoint();
 
     void executeQuery(const std::string &query);
 
+    // Wykonanie zapytania DBQL bez wypisywania; bezpieczne z wielu wątków naraz
+    ResultSet execute(const std::string &query);
+
+    // Wykonanie przygotowanego zapytania z bieżącymi wartościami parametrów, bez ponownego parsowania
+    ResultSet execute(const PreparedStatement &statement);
+
+    // SELECT czytany porcjami przez ResultCursor (LIMIT i OFFSET uwzględnione); błędy, także
+    // składni, w getError() zwróconego kursora
+    std::unique_ptr<ResultCursor> openCursor(const std::string &query) const;
+
+    std::unique_ptr<ResultCursor> openCursor(const PreparedStatement &statement) const;
+
+    // Liczba kształtów zapytań w pamięci podręcznej planów execute (0 wyłącza pamięć podręczną)
+    void setPlanCacheCapacity(size_t capacity);
+
+    const PlanCache &getPlanCache() const { return *planCache; }
+
+    // Kolumny tabeli w kolejności Column::index (pusta lista, gdy tabela nie istnieje)
+    std::vector<Column> getSchema(const std::string &tableName) const;
+
+    // Ostatnie zapytania execute z czasami etapów, od najnowszego
+    std::vector<QueryStats> recentQueries(size_t maxCount = QueryMonitor::CAPACITY) const;
+
+    // Liczniki zapytań, pamięci podręcznej planów i alokatorów w jednej migawce
+    MetricsSnapshot metrics() const;
+
 
 private:
-    std::map<std::string, Table> tables; // Mapa nazwa tabeli -> tabela
+    uint64_t logMutation(const WalRecord &record);
+
+    void awaitDurable(uint64_t lsn);
+
+    void applyLogRecord(const WalRecord &record);
+
+    ResultSet runStatement(const Statement &statement);
+
+    // EXPLAIN [ANALYZE]: kroki planu jako wiersze wyniku
+    ResultSet runExplain(const Statement &statement);
+
+    // Kroki planu SELECT bez wykonania; false (z komunikatem), gdy zapytania nie da się zaplanować
+    bool describePlan(const Statement &statement, std::vector<OperatorStats> &steps) const;
+
+    std::unique_ptr<ResultCursor> openStatementCursor(const Statement &statement) const;
+
+    void prepareCursor(const Statement &statement, ResultCursor &cursor) const;
+
+    // Wypisanie wyniku kursora porcja po porcji
+    static void printCursor(ResultCursor &cursor);
+
+    ResultSet runCached(CachedQuery &query, const std::vector<std::string_view> &literals);
+
+    ResultSet runCachedSelect(CachedQuery &query, const std::vector<std::string_view> &values) const;
+
+    bool resolveProjection(const Table &table, const std::vector<std::string> &columns, SelectPlan &plan) const;
+
+    // keep = LIMIT + OFFSET zapytania z ORDER BY (wiersze za nimi nie są sortowane)
+    ResultSet runScan(const Table &table, const SelectPlan &plan, const Predicate &predicate, const ScanPlan &scan,
+                      const std::vector<std::string> &groupBy, const std::vector<OrderKey> &orderBy = {},
+                      size_t keep = RowSorter::ALL_ROWS) const;
+
+    ResultSet runSelect(const std::string &tableName, const std::vector<std::string> &columns,
+                        const std::vector<Condition> &conditions, const std::vector<std::string> &groupBy,
+                        const std::vector<OrderKey> &orderBy = {}) const;
+
+    // ORDER BY po kolumnach gotowego wyniku (agregaty, złączenia); false (z komunikatem) przy nieznanej kolumnie
+    bool sortResult(ResultSet &result, const std::vector<OrderKey> &orderBy, size_t keep) const;
+
+    ResultSet runJoin(const std::string &leftTable, const std::string &rightTable, const std::string &leftColumn,
+                      const std::string &rightColumn, const std::vector<std::string> &columns,
+                      const std::vector<Condition> &conditions) const;
+
+    ResultSet runAggregate(const Table &table, const Predicate &predicate, const ScanPlan &plan,
+                           const std::vector<const Column *> &projection, const std::vector<int> &aggregateOf,
+                           const std::vector<AggregateSpec> &aggregates, const std::vector<std::string> &groupBy) const;
+
+    static void printResult(const ResultSet &result);
+
+    // Tabela z katalogu; blokada katalogu tylko na czas wyszukania. Nigdy pod blokadą tabeli - DROP TABLE
+    // i checkpoint biorą katalog przed tabelami
+    std::shared_ptr<Table> findTable(const std::string &tableName) const;
+
+    // Kopia katalogu (same wskaźniki) - blokady tabel brane potem bez blokady katalogu
+    TableCatalog catalogSnapshot() const;
+
+    // Zablokowanie wyszukanej tabeli; pusty uchwyt (z komunikatem), gdy tabela nie istnieje albo została usunięta
+    static LockedTable<std::shared_lock<TableMutex>> lockForRead(std::shared_ptr<Table> table,
+                                                                 const std::string &tableName);
+
+    // Wyszukanie i zablokowanie tabeli; pusty uchwyt (z komunikatem), gdy tabela nie istnieje
+    LockedTable<std::shared_lock<TableMutex>> readTable(const std::string &tableName) const;
+
+    LockedTable<std::unique_lock<TableMutex>> writeTable(const std::string &tableName);
+
+    // writeTable przed zapisem do kolumn columnNames (puste - wszystkich). Kolumny zmapowane (migawka, ADD COLUMN)
+    // kopiowane są do własnych tablic pod blokadą współdzieloną - odczyty trwają dalej, a pod wyłączną zostaje
+    // podmiana zamiast kopii całej kolumny przy pierwszym zapisie. appending - kopie z zapasem jak po podwojeniu
+    // wektora, żeby dopisanie nie kopiowało kolumny drugi raz
+    LockedTable<std::unique_lock<TableMutex>> writeTableOwned(const std::string &tableName,
+                                                              const std::vector<std::string> &columnNames,
+                                                              bool appending);
+
+    void scheduleCompaction(const std::shared_ptr<Table> &table);
+
+    // Nowe kolumny budowane pod blokadą współdzieloną (odczyty trwają dalej), podmiana pod wyłączną;
+    // false, gdy tabela zmieniła się w międzyczasie. exclusive - całość pod blokadą wyłączną (zawsze się udaje)
+    static bool rewriteTable(const std::shared_ptr<Table> &table, std::chrono::milliseconds cursorIdleTimeout,
+                             bool exclusive = false);
+
+    // Otwarte kursory tabeli używane w ciągu idleTimeout; pod blokadą tabeli
+    static bool cursorsActive(const Table &table, std::chrono::milliseconds idleTimeout);
+
+    // Nieudane przepisania compactTable przed przepisaniem pod blokadą wyłączną
+    static constexpr int COMPACTION_MAX_RETRIES = 3;
+
+    TableCatalog tables;
+    mutable std::shared_mutex catalogMutex;
+    // Zmiany katalogu (CREATE/DROP TABLE, wczytanie) i zapis migawki po kolei; brana przed catalogMutex,
+    // nigdy pod blokadą tabeli
+    std::mutex catalogChangeMutex;
+    std::unique_ptr<WriteAheadLog> wal;
+    std::string snapshotFile;
+    bool replaying = false;
+    JoinOptions joinOptions;
+    SortOptions sortOptions;
+    std::unique_ptr<PlanCache> planCache;
+    std::unique_ptr<QueryMonitor> monitor;
+    std::atomic<double> compactionThreshold{0.2};
+    std::atomic<std::chrono::milliseconds> cursorIdleTimeout{std::chrono::seconds(30)};
 };
 
 
@@ -0,0 +1,17 @@
+#include "Diagnostics.h"
+
+namespace {
+    thread_local std::ostream *currentErrorStream = nullptr;
+}
+
+std::ostream &errorStream() {
+    return currentErrorStream != nullptr ? *currentErrorStream : std::cerr;
+}
+
+ErrorCapture::ErrorCapture() : previous(currentErrorStream) {
+    currentErrorStream = &buffer;
+}
+
+ErrorCapture::~ErrorCapture() {
+    currentErrorStream = previous;
+}
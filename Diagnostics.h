@@ -0,0 +1,28 @@
+#ifndef DATABASE_DIAGNOSTICS_H
+#define DATABASE_DIAGNOSTICS_H
+
+#include "PreRequistion.h"
+
+// Strumień komunikatów o błędach bieżącego wątku: std::cerr albo bufor aktywnego ErrorCapture.
+// Dzięki temu wynik i błędy jednego zapytania można zebrać bez podmiany std::cerr dla całego procesu.
+std::ostream &errorStream();
+
+// Przechwytuje komunikaty errorStream() bieżącego wątku na czas swojego życia (zagnieżdżalne)
+class ErrorCapture {
+public:
+    ErrorCapture();
+
+    ~ErrorCapture();
+
+    ErrorCapture(const ErrorCapture &) = delete;
+
+    ErrorCapture &operator=(const ErrorCapture &) = delete;
+
+    std::string str() const { return buffer.str(); }
+
+private:
+    std::ostringstream buffer;
+    std::ostream *previous;
+};
+
+#endif //DATABASE_DIAGNOSTICS_H
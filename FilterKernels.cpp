@@ -0,0 +1,330 @@
+#include "FilterKernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DATABASE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    FilterKernels::Isa detectIsa() {
+#ifdef DATABASE_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return FilterKernels::Isa::AVX2;
+        }
+        if (__builtin_cpu_supports("sse4.2")) {
+            return FilterKernels::Isa::SSE42;
+        }
+#endif
+        return FilterKernels::Isa::SCALAR;
+    }
+
+    const FilterKernels::Isa supportedIsa = detectIsa();
+    FilterKernels::Isa selectedIsa = supportedIsa;
+
+    template<typename T>
+    bool compareScalar(T left, CompareOp op, T right) {
+        switch (op) {
+            case CompareOp::EQ:
+                return left == right;
+            case CompareOp::NE:
+                return left != right;
+            case CompareOp::LT:
+                return left < right;
+            case CompareOp::LE:
+                return left <= right;
+            case CompareOp::GT:
+                return left > right;
+            case CompareOp::GE:
+                return left >= right;
+        }
+        return false;
+    }
+
+    // Słowa od firstWord do końca liczone skalarnie (ogon i brak SIMD)
+    template<typename T>
+    void compareTail(const T *values, size_t count, CompareOp op, T literal, uint64_t *out, size_t firstWord) {
+        for (size_t word = firstWord; word * 64 < count; ++word) {
+            size_t end = std::min(count, word * 64 + 64);
+            uint64_t bits = 0;
+            for (size_t row = word * 64; row < end; ++row) {
+                bits |= uint64_t(compareScalar(values[row], op, literal)) << (row & 63);
+            }
+            out[word] = bits;
+        }
+    }
+
+#ifdef DATABASE_X86_KERNELS
+    // Dla liczb całkowitych NE/LE/GE to negacje EQ/GT/LT
+    bool invertedIntOp(CompareOp op) {
+        return op == CompareOp::NE || op == CompareOp::LE || op == CompareOp::GE;
+    }
+
+    __attribute__((target("avx2")))
+    void compareIntAvx2(const int64_t *values, size_t words, CompareOp op, int64_t literal, uint64_t *out) {
+        const __m256i lit = _mm256_set1_epi64x(literal);
+        const uint64_t flip = invertedIntOp(op) ? ~uint64_t(0) : 0;
+        for (size_t word = 0; word < words; ++word) {
+            const int64_t *v = values + word * 64;
+            uint64_t bits = 0;
+            for (int i = 0; i < 64; i += 4) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(v + i));
+                __m256i mask;
+                if (op == CompareOp::EQ || op == CompareOp::NE) {
+                    mask = _mm256_cmpeq_epi64(x, lit);
+                } else if (op == CompareOp::GT || op == CompareOp::LE) {
+                    mask = _mm256_cmpgt_epi64(x, lit);
+                } else {
+                    mask = _mm256_cmpgt_epi64(lit, x);
+                }
+                bits |= uint64_t(_mm256_movemask_pd(_mm256_castsi256_pd(mask))) << i;
+            }
+            out[word] = bits ^ flip;
+        }
+    }
+
+    __attribute__((target("sse4.2")))
+    void compareIntSse42(const int64_t *values, size_t words, CompareOp op, int64_t literal, uint64_t *out) {
+        const __m128i lit = _mm_set1_epi64x(literal);
+        const uint64_t flip = invertedIntOp(op) ? ~uint64_t(0) : 0;
+        for (size_t word = 0; word < words; ++word) {
+            const int64_t *v = values + word * 64;
+            uint64_t bits = 0;
+            for (int i = 0; i < 64; i += 2) {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + i));
+                __m128i mask;
+                if (op == CompareOp::EQ || op == CompareOp::NE) {
+                    mask = _mm_cmpeq_epi64(x, lit);
+                } else if (op == CompareOp::GT || op == CompareOp::LE) {
+                    mask = _mm_cmpgt_epi64(x, lit);
+                } else {
+                    mask = _mm_cmpgt_epi64(lit, x);
+                }
+                bits |= uint64_t(_mm_movemask_pd(_mm_castsi128_pd(mask))) << i;
+            }
+            out[word] = bits ^ flip;
+        }
+    }
+
+    // Predykaty _mm256_cmp_pd odpowiadają semantyce operatorów C++ (także dla NaN)
+    template<int Predicate>
+    __attribute__((target("avx2")))
+    void compareFloatAvx2Op(const double *values, size_t words, double literal, uint64_t *out) {
+        const __m256d lit = _mm256_set1_pd(literal);
+        for (size_t word = 0; word < words; ++word) {
+            const double *v = values + word * 64;
+            uint64_t bits = 0;
+            for (int i = 0; i < 64; i += 4) {
+                __m256d mask = _mm256_cmp_pd(_mm256_loadu_pd(v + i), lit, Predicate);
+                bits |= uint64_t(_mm256_movemask_pd(mask)) << i;
+            }
+            out[word] = bits;
+        }
+    }
+
+    void compareFloatAvx2(const double *values, size_t words, CompareOp op, double literal, uint64_t *out) {
+        switch (op) {
+            case CompareOp::EQ:
+                compareFloatAvx2Op<_CMP_EQ_OQ>(values, words, literal, out);
+                break;
+            case CompareOp::NE:
+                compareFloatAvx2Op<_CMP_NEQ_UQ>(values, words, literal, out);
+                break;
+            case CompareOp::LT:
+                compareFloatAvx2Op<_CMP_LT_OQ>(values, words, literal, out);
+                break;
+            case CompareOp::LE:
+                compareFloatAvx2Op<_CMP_LE_OQ>(values, words, literal, out);
+                break;
+            case CompareOp::GT:
+                compareFloatAvx2Op<_CMP_GT_OQ>(values, words, literal, out);
+                break;
+            case CompareOp::GE:
+                compareFloatAvx2Op<_CMP_GE_OQ>(values, words, literal, out);
+                break;
+        }
+    }
+
+    __attribute__((target("sse4.2")))
+    void compareFloatSse42(const double *values, size_t words, CompareOp op, double literal, uint64_t *out) {
+        const __m128d lit = _mm_set1_pd(literal);
+        for (size_t word = 0; word < words; ++word) {
+            const double *v = values + word * 64;
+            uint64_t bits = 0;
+            for (int i = 0; i < 64; i += 2) {
+                __m128d x = _mm_loadu_pd(v + i);
+                __m128d mask;
+                switch (op) {
+                    case CompareOp::EQ:
+                        mask = _mm_cmpeq_pd(x, lit);
+                        break;
+                    case CompareOp::NE:
+                        mask = _mm_cmpneq_pd(x, lit);
+                        break;
+                    case CompareOp::LT:
+                        mask = _mm_cmplt_pd(x, lit);
+                        break;
+                    case CompareOp::LE:
+                        mask = _mm_cmple_pd(x, lit);
+                        break;
+                    case CompareOp::GT:
+                        mask = _mm_cmpgt_pd(x, lit);
+                        break;
+                    default:
+                        mask = _mm_cmpge_pd(x, lit);
+                        break;
+                }
+                bits |= uint64_t(_mm_movemask_pd(mask)) << i;
+            }
+            out[word] = bits;
+        }
+    }
+#endif
+}
+
+FilterKernels::Isa FilterKernels::activeIsa() {
+    return selectedIsa;
+}
+
+const char *FilterKernels::isaName(Isa isa) {
+    switch (isa) {
+        case Isa::AVX2:
+            return "avx2";
+        case Isa::SSE42:
+            return "sse4.2";
+        case Isa::SCALAR:
+            return "scalar";
+    }
+    return "scalar";
+}
+
+void FilterKernels::forceIsa(Isa isa) {
+    selectedIsa = static_cast<int>(isa) <= static_cast<int>(supportedIsa) ? isa : supportedIsa;
+}
+
+void FilterKernels::compareInt(const int64_t *values, size_t count, CompareOp op, int64_t literal, uint64_t *out) {
+    size_t fullWords = 0;
+#ifdef DATABASE_X86_KERNELS
+    if (selectedIsa == Isa::AVX2) {
+        fullWords = count / 64;
+        compareIntAvx2(values, fullWords, op, literal, out);
+    } else if (selectedIsa == Isa::SSE42) {
+        fullWords = count / 64;
+        compareIntSse42(values, fullWords, op, literal, out);
+    }
+#endif
+    compareTail(values, count, op, literal, out, fullWords);
+}
+
+void FilterKernels::compareFloat(const double *values, size_t count, CompareOp op, double literal, uint64_t *out) {
+    size_t fullWords = 0;
+#ifdef DATABASE_X86_KERNELS
+    if (selectedIsa == Isa::AVX2) {
+        fullWords = count / 64;
+        compareFloatAvx2(values, fullWords, op, literal, out);
+    } else if (selectedIsa == Isa::SSE42) {
+        fullWords = count / 64;
+        compareFloatSse42(values, fullWords, op, literal, out);
+    }
+#endif
+    compareTail(values, count, op, literal, out, fullWords);
+}
+
+namespace {
+    template<typename Code>
+    Code loadCode(const uint8_t *codes, size_t row) {
+        Code code;
+        std::memcpy(&code, codes + row * sizeof(Code), sizeof(Code));
+        return code;
+    }
+
+    template<typename Code>
+    void compareCodesOf(const uint8_t *codes, size_t count, uint32_t low, uint32_t high, bool negate, uint64_t *out) {
+        const uint32_t span = high - low;
+        const uint64_t flip = negate ? ~uint64_t(0) : 0;
+        for (size_t word = 0; word * 64 < count; ++word) {
+            size_t end = std::min(count, word * 64 + 64);
+            uint64_t bits = 0;
+            for (size_t row = word * 64; row < end; ++row) {
+                bits |= uint64_t(uint32_t(loadCode<Code>(codes, row) - low) < span) << (row & 63);
+            }
+            uint64_t valid = end - word * 64 == 64 ? ~uint64_t(0) : (uint64_t(1) << (end - word * 64)) - 1;
+            out[word] = (bits ^ flip) & valid;
+        }
+    }
+
+    template<typename Code>
+    void lookupCodesOf(const uint8_t *codes, size_t count, const uint8_t *matches, uint64_t *out) {
+        for (size_t word = 0; word * 64 < count; ++word) {
+            size_t end = std::min(count, word * 64 + 64);
+            uint64_t bits = 0;
+            for (size_t row = word * 64; row < end; ++row) {
+                bits |= uint64_t(matches[loadCode<Code>(codes, row)]) << (row & 63);
+            }
+            out[word] = bits;
+        }
+    }
+}
+
+void FilterKernels::compareCodes(const uint8_t *codes, uint32_t width, size_t count, uint32_t low, uint32_t high,
+                                 bool negate, uint64_t *out) {
+    switch (width) {
+        case 1:
+            compareCodesOf<uint8_t>(codes, count, low, high, negate, out);
+            break;
+        case 2:
+            compareCodesOf<uint16_t>(codes, count, low, high, negate, out);
+            break;
+        default:
+            compareCodesOf<uint32_t>(codes, count, low, high, negate, out);
+            break;
+    }
+}
+
+void FilterKernels::lookupCodes(const uint8_t *codes, uint32_t width, size_t count, const uint8_t *matches,
+                                uint64_t *out) {
+    switch (width) {
+        case 1:
+            lookupCodesOf<uint8_t>(codes, count, matches, out);
+            break;
+        case 2:
+            lookupCodesOf<uint16_t>(codes, count, matches, out);
+            break;
+        default:
+            lookupCodesOf<uint32_t>(codes, count, matches, out);
+            break;
+    }
+}
+
+void FilterKernels::andBitmap(uint64_t *out, const uint64_t *in, size_t words) {
+    for (size_t word = 0; word < words; ++word) {
+        out[word] &= in[word];
+    }
+}
+
+void FilterKernels::orBitmap(uint64_t *out, const uint64_t *in, size_t words) {
+    for (size_t word = 0; word < words; ++word) {
+        out[word] |= in[word];
+    }
+}
+
+void FilterKernels::andNotBitmap(uint64_t *out, const uint64_t *in, size_t words) {
+    for (size_t word = 0; word < words; ++word) {
+        out[word] &= ~in[word];
+    }
+}
+
+size_t FilterKernels::countBits(const uint64_t *bits, size_t words) {
+    size_t count = 0;
+    for (size_t word = 0; word < words; ++word) {
+        count += static_cast<size_t>(std::popcount(bits[word]));
+    }
+    return count;
+}
+
+std::vector<uint32_t> FilterKernels::toSelectionVector(const SelectionBitmap &bitmap) {
+    std::vector<uint32_t> rows;
+    rows.reserve(countBits(bitmap.data(), bitmap.size()));
+    forEachSelected(bitmap, [&rows](size_t row) { rows.push_back(static_cast<uint32_t>(row)); });
+    return rows;
+}
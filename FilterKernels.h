@@ -0,0 +1,71 @@
+#ifndef DATABASE_FILTERKERNELS_H
+#define DATABASE_FILTERKERNELS_H
+
+#include "PreRequistion.h"
+#include <bit>
+
+enum class CompareOp {
+    EQ, NE, LT, LE, GT, GE
+};
+
+// Bitmapa wyboru: bit (row & 63) słowa (row >> 6) = wiersz spełnia warunek
+using SelectionBitmap = std::vector<uint64_t>;
+
+// Wektorowe porównania kolumn liczbowych z literałem. Implementacja (AVX2, SSE4.2
+// albo skalarna) wybierana jest raz, w czasie działania programu, według możliwości CPU.
+namespace FilterKernels {
+    enum class Isa {
+        SCALAR, SSE42, AVX2
+    };
+
+    Isa activeIsa();
+
+    const char *isaName(Isa isa);
+
+    // Wymusza daną implementację (np. do porównań w benchmarkach); ogranicza się do wspieranych przez CPU
+    void forceIsa(Isa isa);
+
+    // out musi mieć (count + 63) / 64 słów; bity za count są zerowane
+    void compareInt(const int64_t *values, size_t count, CompareOp op, int64_t literal, uint64_t *out);
+
+    void compareFloat(const double *values, size_t count, CompareOp op, double literal, uint64_t *out);
+
+    // Kody słownika (width = 1, 2 albo 4 bajty): bit = kod w [low, high), odwrócony przy negate.
+    // Pętle skalarne bez rozgałęzień - kompilator wektoryzuje je sam.
+    void compareCodes(const uint8_t *codes, uint32_t width, size_t count, uint32_t low, uint32_t high, bool negate,
+                      uint64_t *out);
+
+    // bit = matches[kod] (słownik nieposortowany: wynik porównania policzony raz na wpis)
+    void lookupCodes(const uint8_t *codes, uint32_t width, size_t count, const uint8_t *matches, uint64_t *out);
+
+    // out &= in, out |= in, out &= ~in
+    void andBitmap(uint64_t *out, const uint64_t *in, size_t words);
+
+    void orBitmap(uint64_t *out, const uint64_t *in, size_t words);
+
+    void andNotBitmap(uint64_t *out, const uint64_t *in, size_t words);
+
+    size_t countBits(const uint64_t *bits, size_t words);
+
+    // Zamiana bitmapy na wektor numerów wierszy
+    std::vector<uint32_t> toSelectionVector(const SelectionBitmap &bitmap);
+}
+
+// Wywołuje f(row) dla każdego zapalonego bitu
+template<typename F>
+void forEachSelected(const uint64_t *bitmap, size_t words, F &&f) {
+    for (size_t word = 0; word < words; ++word) {
+        uint64_t bits = bitmap[word];
+        while (bits) {
+            f((word << 6) + static_cast<size_t>(std::countr_zero(bits)));
+            bits &= bits - 1;
+        }
+    }
+}
+
+template<typename F>
+void forEachSelected(const SelectionBitmap &bitmap, F &&f) {
+    forEachSelected(bitmap.data(), bitmap.size(), std::forward<F>(f));
+}
+
+#endif //DATABASE_FILTERKERNELS_H
@@ -0,0 +1,33 @@
+#ifndef DATABASE_HASHING_H
+#define DATABASE_HASHING_H
+
+#include "PreRequistion.h"
+
+// Szybkie 64-bitowe hasze dla tablic haszujących silnika (agregacja, złączenia); nie kryptograficzne
+inline uint64_t hashInt(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDull;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ull;
+    return value ^ (value >> 33);
+}
+
+inline uint64_t hashBytes(std::string_view bytes) {
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ bytes.size();
+    size_t position = 0;
+    for (; position + 8 <= bytes.size(); position += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes.data() + position, 8);
+        hash = (hash ^ word) * 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 31;
+    }
+    // Pusty widok może mieć data() == nullptr - memcpy z nullptr to UB nawet dla 0 bajtów
+    uint64_t tail = 0;
+    if (position < bytes.size()) {
+        std::memcpy(&tail, bytes.data() + position, bytes.size() - position);
+    }
+    hash = (hash ^ tail) * 0x94D049BB133111EBull;
+    return hash ^ (hash >> 29);
+}
+
+#endif //DATABASE_HASHING_H
@@ -0,0 +1,58 @@
+#include "Index.h"
+#include "Predicate.h"
+
+bool TableIndex::supports(CompareOp op) const {
+    if (type == IndexType::HASH) {
+        return op == CompareOp::EQ;
+    }
+    return op != CompareOp::NE;
+}
+
+std::unique_ptr<TableIndex> createTableIndex(const std::string &name, IndexType type, int columnIndex,
+                                             DataType columnType) {
+    switch (columnType) {
+        case DataType::INT:
+            if (type == IndexType::HASH) {
+                return std::make_unique<HashIndex<int64_t>>(name, columnIndex);
+            }
+            return std::make_unique<BTreeIndex<int64_t>>(name, columnIndex);
+        case DataType::FLOAT:
+            if (type == IndexType::HASH) {
+                return std::make_unique<HashIndex<double>>(name, columnIndex);
+            }
+            return std::make_unique<BTreeIndex<double>>(name, columnIndex);
+        case DataType::STRING:
+            if (type == IndexType::HASH) {
+                return std::make_unique<HashIndex<std::string>>(name, columnIndex);
+            }
+            return std::make_unique<BTreeIndex<std::string>>(name, columnIndex);
+    }
+    return nullptr;
+}
+
+std::vector<uint32_t> buildRowRemap(const std::vector<bool> &keep) {
+    std::vector<uint32_t> remap(keep.size(), UINT32_MAX);
+    uint32_t next = 0;
+    for (size_t row = 0; row < keep.size(); ++row) {
+        if (keep[row]) {
+            remap[row] = next++;
+        }
+    }
+    return remap;
+}
+
+void IndexKeys::literal(const Comparison &comparison, int64_t &key) {
+    key = comparison.intValue;
+}
+
+void IndexKeys::literal(const Comparison &comparison, double &key) {
+    key = comparison.floatValue;
+}
+
+void IndexKeys::literal(const Comparison &comparison, std::string &key) {
+    key = comparison.stringValue;
+}
+
+CompareOp IndexKeys::op(const Comparison &comparison) {
+    return comparison.op;
+}
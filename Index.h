@@ -0,0 +1,284 @@
+#ifndef DATABASE_INDEX_H
+#define DATABASE_INDEX_H
+
+#include "PreRequistion.h"
+#include "ColumnStore.h"
+#include "FilterKernels.h"
+#include "BPlusTree.h"
+#include "ThreadPool.h"
+#include <memory>
+#include <cmath>
+
+struct Comparison;
+
+enum class IndexType {
+    HASH, BTREE
+};
+
+// Indeks pomocniczy na jednej kolumnie tabeli. Wartości NULL (i NaN) nie są indeksowane.
+class TableIndex {
+public:
+    TableIndex(const std::string &indexName, IndexType indexType, int indexColumn)
+            : name(indexName), type(indexType), columnIndex(indexColumn) {}
+
+    virtual ~TableIndex() = default;
+
+    const std::string &getName() const { return name; }
+
+    IndexType getType() const { return type; }
+
+    int getColumnIndex() const { return columnIndex; }
+
+    void setColumnIndex(int index) { columnIndex = index; }
+
+    // Czy indeks potrafi obsłużyć porównanie z danym operatorem
+    bool supports(CompareOp op) const;
+
+    virtual void build(const ColumnData &column, size_t rowCount) = 0;
+
+    virtual void insertRow(const ColumnData &column, size_t row) = 0;
+
+    // Wywoływane przed zmianą albo usunięciem wartości w wierszu
+    virtual void eraseRow(const ColumnData &column, size_t row) = 0;
+
+    // Po usunięciu wierszy (keep[row] == false) przenumerowuje pozostałe
+    virtual void remapRows(const std::vector<bool> &keep) = 0;
+
+    // Dopisuje do rows wiersze spełniające porównanie (w dowolnej kolejności)
+    virtual void lookup(const Comparison &comparison, std::vector<uint32_t> &rows) const = 0;
+
+    virtual size_t size() const = 0;
+
+private:
+    std::string name;
+    IndexType type;
+    int columnIndex;
+};
+
+std::unique_ptr<TableIndex> createTableIndex(const std::string &name, IndexType type, int columnIndex,
+                                             DataType columnType);
+
+// Nowe numery wierszy po usunięciu (UINT32_MAX dla usuniętych)
+std::vector<uint32_t> buildRowRemap(const std::vector<bool> &keep);
+
+namespace IndexKeys {
+    template<typename Key>
+    Key keyAt(const ColumnData &column, size_t row);
+
+    template<>
+    inline int64_t keyAt<int64_t>(const ColumnData &column, size_t row) { return column.getInt(row); }
+
+    template<>
+    inline double keyAt<double>(const ColumnData &column, size_t row) { return column.getFloat(row); }
+
+    template<>
+    inline std::string keyAt<std::string>(const ColumnData &column, size_t row) {
+        return std::string(column.getString(row));
+    }
+
+    template<typename Key>
+    bool indexable(const ColumnData &column, size_t row) {
+        if (column.isNull(row)) {
+            return false;
+        }
+        if constexpr (std::is_same_v<Key, double>) {
+            return !std::isnan(column.getFloat(row));
+        }
+        return true;
+    }
+
+    // Literał porównania w typie klucza
+    void literal(const Comparison &comparison, int64_t &key);
+
+    void literal(const Comparison &comparison, double &key);
+
+    void literal(const Comparison &comparison, std::string &key);
+
+    CompareOp op(const Comparison &comparison);
+}
+
+// Indeks haszujący: wyszukiwanie równościowe w O(1)
+template<typename Key>
+class HashIndex : public TableIndex {
+public:
+    HashIndex(const std::string &indexName, int indexColumn) : TableIndex(indexName, IndexType::HASH, indexColumn) {}
+
+    void build(const ColumnData &column, size_t rowCount) override {
+        entries.clear();
+        entryCount = 0;
+        for (size_t row = 0; row < rowCount; ++row) {
+            insertRow(column, row);
+        }
+    }
+
+    void insertRow(const ColumnData &column, size_t row) override {
+        if (IndexKeys::indexable<Key>(column, row)) {
+            entries[IndexKeys::keyAt<Key>(column, row)].push_back(static_cast<uint32_t>(row));
+            ++entryCount;
+        }
+    }
+
+    void eraseRow(const ColumnData &column, size_t row) override {
+        if (!IndexKeys::indexable<Key>(column, row)) {
+            return;
+        }
+        auto it = entries.find(IndexKeys::keyAt<Key>(column, row));
+        if (it == entries.end()) {
+            return;
+        }
+        auto &rows = it->second;
+        auto pos = std::find(rows.begin(), rows.end(), static_cast<uint32_t>(row));
+        if (pos != rows.end()) {
+            *pos = rows.back();
+            rows.pop_back();
+            --entryCount;
+        }
+        if (rows.empty()) {
+            entries.erase(it);
+        }
+    }
+
+    void remapRows(const std::vector<bool> &keep) override {
+        std::vector<uint32_t> remap = buildRowRemap(keep);
+        entryCount = 0;
+        for (auto it = entries.begin(); it != entries.end();) {
+            auto &rows = it->second;
+            size_t out = 0;
+            for (uint32_t row : rows) {
+                if (remap[row] != UINT32_MAX) {
+                    rows[out++] = remap[row];
+                }
+            }
+            rows.resize(out);
+            entryCount += out;
+            it = rows.empty() ? entries.erase(it) : std::next(it);
+        }
+    }
+
+    void lookup(const Comparison &comparison, std::vector<uint32_t> &rows) const override {
+        Key key;
+        IndexKeys::literal(comparison, key);
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            rows.insert(rows.end(), it->second.begin(), it->second.end());
+        }
+    }
+
+    size_t size() const override { return entryCount; }
+
+private:
+    std::unordered_map<Key, std::vector<uint32_t>> entries;
+    size_t entryCount = 0;
+};
+
+// Indeks uporządkowany (B+-drzewo): równość i zakresy w O(log n + wynik)
+template<typename Key>
+class BTreeIndex : public TableIndex {
+public:
+    BTreeIndex(const std::string &indexName, int indexColumn) : TableIndex(indexName, IndexType::BTREE, indexColumn) {}
+
+    void build(const ColumnData &column, size_t rowCount) override {
+        // Klucze zbierane i sortowane równolegle morselami, potem scalane parami
+        using Entry = typename BPlusTree<Key>::Entry;
+        ThreadPool &pool = ThreadPool::shared();
+        std::vector<std::vector<Entry>> runs(ThreadPool::morselCount(rowCount));
+        pool.forEachMorsel(rowCount, [&](size_t morsel, size_t firstRow, size_t count, unsigned) {
+            std::vector<Entry> &run = runs[morsel];
+            for (size_t row = firstRow; row < firstRow + count; ++row) {
+                if (IndexKeys::indexable<Key>(column, row)) {
+                    run.emplace_back(IndexKeys::keyAt<Key>(column, row), static_cast<uint32_t>(row));
+                }
+            }
+            std::sort(run.begin(), run.end());
+        });
+        while (runs.size() > 1) {
+            std::vector<std::vector<Entry>> merged((runs.size() + 1) / 2);
+            pool.parallelFor(merged.size(), [&](size_t i, unsigned) {
+                if (2 * i + 1 == runs.size()) {
+                    merged[i] = std::move(runs[2 * i]);
+                    return;
+                }
+                std::vector<Entry> &left = runs[2 * i];
+                std::vector<Entry> &right = runs[2 * i + 1];
+                merged[i].reserve(left.size() + right.size());
+                std::merge(std::make_move_iterator(left.begin()), std::make_move_iterator(left.end()),
+                           std::make_move_iterator(right.begin()), std::make_move_iterator(right.end()),
+                           std::back_inserter(merged[i]));
+            });
+            runs = std::move(merged);
+        }
+        if (runs.empty()) {
+            runs.emplace_back();
+        }
+        tree.bulkLoad(runs.front());
+    }
+
+    void insertRow(const ColumnData &column, size_t row) override {
+        if (IndexKeys::indexable<Key>(column, row)) {
+            tree.insert(IndexKeys::keyAt<Key>(column, row), static_cast<uint32_t>(row));
+        }
+    }
+
+    void eraseRow(const ColumnData &column, size_t row) override {
+        if (IndexKeys::indexable<Key>(column, row)) {
+            tree.erase(IndexKeys::keyAt<Key>(column, row), static_cast<uint32_t>(row));
+        }
+    }
+
+    void remapRows(const std::vector<bool> &keep) override {
+        // Przenumerowanie jest monotoniczne, więc kolejność par się nie zmienia
+        std::vector<uint32_t> remap = buildRowRemap(keep);
+        std::vector<typename BPlusTree<Key>::Entry> sorted;
+        sorted.reserve(tree.size());
+        tree.scanAll([&](const Key &key, uint32_t row) {
+            if (remap[row] != UINT32_MAX) {
+                sorted.emplace_back(key, remap[row]);
+            }
+            return true;
+        });
+        tree.bulkLoad(sorted);
+    }
+
+    void lookup(const Comparison &comparison, std::vector<uint32_t> &rows) const override {
+        Key key;
+        IndexKeys::literal(comparison, key);
+        auto collect = [&rows](const Key &, uint32_t row) {
+            rows.push_back(row);
+            return true;
+        };
+        switch (IndexKeys::op(comparison)) {
+            case CompareOp::EQ:
+                tree.scanFrom(key, 0, [&](const Key &value, uint32_t row) {
+                    return value == key && collect(value, row);
+                });
+                break;
+            case CompareOp::GE:
+                tree.scanFrom(key, 0, collect);
+                break;
+            case CompareOp::GT:
+                tree.scanFrom(key, UINT32_MAX, [&](const Key &value, uint32_t row) {
+                    return value == key || collect(value, row);
+                });
+                break;
+            case CompareOp::LT:
+                tree.scanAll([&](const Key &value, uint32_t row) {
+                    return value < key && collect(value, row);
+                });
+                break;
+            case CompareOp::LE:
+                tree.scanAll([&](const Key &value, uint32_t row) {
+                    return value <= key && collect(value, row);
+                });
+                break;
+            case CompareOp::NE:
+                break;
+        }
+    }
+
+    size_t size() const override { return tree.size(); }
+
+private:
+    BPlusTree<Key> tree;
+};
+
+#endif //DATABASE_INDEX_H
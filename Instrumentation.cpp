@@ -0,0 +1,223 @@
+#include "Instrumentation.h"
+
+namespace {
+    thread_local QueryProfile *activeProfile = nullptr;
+
+    uint64_t nanosSince(std::chrono::steady_clock::time_point start) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+const char *stageName(QueryStage stage) {
+    switch (stage) {
+        case QueryStage::PARSE:
+            return "parse";
+        case QueryStage::PLAN:
+            return "plan";
+        case QueryStage::LOCK_WAIT:
+            return "lock_wait";
+        case QueryStage::SCAN:
+            return "scan";
+        case QueryStage::PROJECT:
+            return "project";
+        case QueryStage::AGGREGATE:
+            return "aggregate";
+        case QueryStage::JOIN:
+            return "join";
+        case QueryStage::SORT:
+            return "sort";
+        case QueryStage::WRITE:
+            return "write";
+        case QueryStage::WAL:
+            return "wal";
+    }
+    return "unknown";
+}
+
+QueryProfile::QueryProfile(bool collectOperators)
+        : previous(activeProfile), collectOperators(collectOperators), start(std::chrono::steady_clock::now()) {
+    activeProfile = this;
+}
+
+QueryProfile::~QueryProfile() {
+    activeProfile = previous;
+    if (previous == nullptr) {
+        return;
+    }
+    for (size_t i = 0; i < QUERY_STAGE_COUNT; ++i) {
+        previous->stageNanos[i] += stageNanos[i];
+    }
+    previous->attributedNanos += attributedNanos;
+    previous->rowsScanned += rowsScanned;
+    previous->rowsReturned += rowsReturned;
+    previous->blocksSkipped += blocksSkipped;
+}
+
+QueryProfile *QueryProfile::active() {
+    return activeProfile;
+}
+
+void QueryProfile::addOperator(OperatorStats step) {
+    if (collectOperators) {
+        operators.push_back(std::move(step));
+    }
+}
+
+uint64_t QueryProfile::elapsedNanos() const {
+    return nanosSince(start);
+}
+
+StageTimer::StageTimer(QueryStage stage) : profile(activeProfile), stage(stage) {
+    if (profile != nullptr) {
+        attributedBefore = profile->attributedNanos;
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+StageTimer::~StageTimer() {
+    if (profile == nullptr) {
+        return;
+    }
+    uint64_t nested = profile->attributedNanos - attributedBefore;
+    uint64_t total = elapsed();
+    uint64_t own = total > nested ? total - nested : 0;
+    profile->stageNanos[static_cast<size_t>(stage)] += own;
+    profile->attributedNanos += own;
+}
+
+uint64_t StageTimer::elapsed() const {
+    return profile != nullptr ? nanosSince(start) : 0;
+}
+
+OperatorTimer::OperatorTimer() : profile(activeProfile) {
+    if (profile != nullptr && profile->collectsOperators()) {
+        start = std::chrono::steady_clock::now();
+    } else {
+        profile = nullptr;
+    }
+}
+
+void OperatorTimer::record(const char *name, std::string detail, size_t depth, size_t rows) {
+    profile->addOperator({name, std::move(detail), depth, true, rows, nanosSince(start)});
+}
+
+QueryMonitor::QueryMonitor()
+        : slots(new Slot[CAPACITY]),
+          steadyToSystem(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                  std::chrono::system_clock::now().time_since_epoch()
+                  - std::chrono::steady_clock::now().time_since_epoch())) {
+}
+
+void QueryMonitor::record(std::string_view query, const QueryProfile &profile, bool queryFailed) {
+    QueryStats stats;
+    stats.startedAtMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(profile.startedAt().time_since_epoch())
+            + steadyToSystem).count();
+    stats.totalNanos = profile.elapsedNanos();
+    stats.stageNanos = profile.stageNanos;
+    stats.rowsScanned = profile.rowsScanned;
+    stats.rowsReturned = profile.rowsReturned;
+    stats.failed = queryFailed;
+    query.copy(stats.text, std::min(query.size(), QueryStats::TEXT_BYTES - 1));
+
+    queries.fetch_add(1, std::memory_order_relaxed);
+    if (queryFailed) {
+        failed.fetch_add(1, std::memory_order_relaxed);
+    }
+    totalNanos.fetch_add(stats.totalNanos, std::memory_order_relaxed);
+    for (size_t i = 0; i < QUERY_STAGE_COUNT; ++i) {
+        if (stats.stageNanos[i] != 0) {
+            stageNanos[i].fetch_add(stats.stageNanos[i], std::memory_order_relaxed);
+        }
+    }
+    rowsScanned.fetch_add(stats.rowsScanned, std::memory_order_relaxed);
+    rowsReturned.fetch_add(stats.rowsReturned, std::memory_order_relaxed);
+    if (profile.blocksSkipped != 0) {
+        blocksSkipped.fetch_add(profile.blocksSkipped, std::memory_order_relaxed);
+    }
+
+    // Slot zajmowany tylko, gdy nie wyprzedził go zapis o CAPACITY nowszy (wtedy wpis przepada)
+    uint64_t sequence = head.fetch_add(1);
+    stats.sequence = sequence;
+    Slot &slot = slots[sequence % CAPACITY];
+    uint64_t version = slot.version.load(std::memory_order_relaxed);
+    do {
+        if (version > 2 * sequence) {
+            return;
+        }
+    } while (!slot.version.compare_exchange_weak(version, 2 * sequence + 1, std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint64_t words[WORDS] = {};
+    std::memcpy(words, &stats, sizeof(stats));
+    for (size_t i = 0; i < WORDS; ++i) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.version.store(2 * sequence + 2, std::memory_order_release);
+}
+
+std::vector<QueryStats> QueryMonitor::recent(size_t maxCount) const {
+    std::vector<QueryStats> result;
+    uint64_t end = head.load();
+    uint64_t count = std::min<uint64_t>({maxCount, end, CAPACITY});
+    for (uint64_t sequence = end; sequence-- > end - count;) {
+        const Slot &slot = slots[sequence % CAPACITY];
+        uint64_t version = slot.version.load(std::memory_order_acquire);
+        if (version != 2 * sequence + 2) {
+            continue;
+        }
+        uint64_t words[WORDS];
+        for (size_t i = 0; i < WORDS; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.version.load(std::memory_order_relaxed) != version) {
+            continue;
+        }
+        std::memcpy(&result.emplace_back(), words, sizeof(QueryStats));
+    }
+    return result;
+}
+
+QueryCounters QueryMonitor::counters() const {
+    QueryCounters result;
+    result.queries = queries;
+    result.failed = failed;
+    result.totalNanos = totalNanos;
+    for (size_t i = 0; i < QUERY_STAGE_COUNT; ++i) {
+        result.stageNanos[i] = stageNanos[i].load(std::memory_order_relaxed);
+    }
+    result.rowsScanned = rowsScanned;
+    result.rowsReturned = rowsReturned;
+    result.blocksSkipped = blocksSkipped;
+    return result;
+}
+
+std::string MetricsSnapshot::format() const {
+    std::ostringstream out;
+    out << "db_queries_total " << queries.queries << "\n";
+    out << "db_queries_failed_total " << queries.failed << "\n";
+    out << "db_query_seconds_total " << static_cast<double>(queries.totalNanos) / 1e9 << "\n";
+    for (size_t i = 0; i < QUERY_STAGE_COUNT; ++i) {
+        out << "db_stage_seconds_total{stage=\"" << stageName(static_cast<QueryStage>(i)) << "\"} "
+            << static_cast<double>(queries.stageNanos[i]) / 1e9 << "\n";
+    }
+    out << "db_rows_scanned_total " << queries.rowsScanned << "\n";
+    out << "db_rows_returned_total " << queries.rowsReturned << "\n";
+    out << "db_blocks_skipped_total " << queries.blocksSkipped << "\n";
+    out << "db_plan_cache_hits_total " << planCacheHits << "\n";
+    out << "db_plan_cache_misses_total " << planCacheMisses << "\n";
+    out << "db_plan_cache_entries " << planCacheEntries << "\n";
+    out << "db_tables " << tables << "\n";
+    out << "db_pool_used_bytes " << poolUsedBytes << "\n";
+    out << "db_pool_cached_bytes " << poolCachedBytes << "\n";
+    out << "db_arena_bytes " << arenaBytes << "\n";
+    out << "db_buffer_pool_capacity_bytes " << bufferPool.capacityBytes << "\n";
+    out << "db_buffer_pool_resident_bytes " << bufferPool.residentBytes << "\n";
+    out << "db_buffer_pool_hits_total " << bufferPool.hits << "\n";
+    out << "db_buffer_pool_misses_total " << bufferPool.misses << "\n";
+    out << "db_buffer_pool_evictions_total " << bufferPool.evictions << "\n";
+    out << "db_buffer_pool_readahead_pages_total " << bufferPool.readaheads << "\n";
+    return out.str();
+}
@@ -0,0 +1,188 @@
+#ifndef DATABASE_INSTRUMENTATION_H
+#define DATABASE_INSTRUMENTATION_H
+
+#include "PreRequistion.h"
+#include "BufferPool.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+// Etapy wykonania zapytania. Czasy etapów są rozłączne: etap zagnieżdżony (np. LOCK_WAIT
+// w trakcie WRITE) jest odejmowany od etapu zewnętrznego.
+enum class QueryStage {
+    PARSE, PLAN, LOCK_WAIT, SCAN, PROJECT, AGGREGATE, JOIN, SORT, WRITE, WAL
+};
+
+constexpr size_t QUERY_STAGE_COUNT = 10;
+
+const char *stageName(QueryStage stage);
+
+// Krok planu w EXPLAIN [ANALYZE]; rows i nanos tylko po wykonaniu
+struct OperatorStats {
+    std::string name;
+    std::string detail;
+    size_t depth = 0;
+    bool analyzed = false;
+    size_t rows = 0;
+    uint64_t nanos = 0;
+};
+
+// Pomiary jednego zapytania. Profil utworzony na stosie jest aktywny w swoim wątku do końca
+// zasięgu: StageTimer i liczniki w silniku zapisują do niego, bez aktywnego profilu pomiar kosztuje
+// tylko sprawdzenie wskaźnika. Profil zagnieżdżony po zakończeniu dolicza się do zewnętrznego.
+// Kroki operatorów (do EXPLAIN ANALYZE) zbierane tylko na życzenie.
+class QueryProfile {
+public:
+    explicit QueryProfile(bool collectOperators = false);
+
+    ~QueryProfile();
+
+    QueryProfile(const QueryProfile &) = delete;
+
+    QueryProfile &operator=(const QueryProfile &) = delete;
+
+    static QueryProfile *active();
+
+    bool collectsOperators() const { return collectOperators; }
+
+    void addOperator(OperatorStats step);
+
+    uint64_t elapsedNanos() const;
+
+    std::chrono::steady_clock::time_point startedAt() const { return start; }
+
+    std::array<uint64_t, QUERY_STAGE_COUNT> stageNanos{};
+    uint64_t attributedNanos = 0; // suma stageNanos
+    uint64_t rowsScanned = 0;     // wiersze sprawdzone przez filtr albo wskazane przez indeks
+    uint64_t rowsReturned = 0;
+    uint64_t blocksSkipped = 0;   // morsele pominięte dzięki zone maps
+    std::vector<OperatorStats> operators;
+
+private:
+    QueryProfile *previous;
+    bool collectOperators;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Czas od utworzenia do końca zasięgu doliczany do etapu aktywnego profilu (bez czasu etapów zagnieżdżonych)
+class StageTimer {
+public:
+    explicit StageTimer(QueryStage stage);
+
+    ~StageTimer();
+
+    StageTimer(const StageTimer &) = delete;
+
+    StageTimer &operator=(const StageTimer &) = delete;
+
+    // Nanosekundy od utworzenia (także etapy zagnieżdżone)
+    uint64_t elapsed() const;
+
+private:
+    QueryProfile *profile;
+    QueryStage stage;
+    uint64_t attributedBefore = 0;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Krok planu mierzony od utworzenia do finish(); bez profilu zbierającego operatory nic nie robi
+// (opis kroku, detail(), liczony tylko wtedy, gdy jest zapisywany)
+class OperatorTimer {
+public:
+    OperatorTimer();
+
+    template<typename Detail>
+    void finish(const char *name, Detail detail, size_t depth, size_t rows) {
+        if (profile != nullptr) {
+            record(name, detail(), depth, rows);
+        }
+    }
+
+private:
+    void record(const char *name, std::string detail, size_t depth, size_t rows);
+
+    QueryProfile *profile;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Wpis dziennika zapytań (typ trywialnie kopiowalny - zapisywany słowami do pierścienia)
+struct QueryStats {
+    static constexpr size_t TEXT_BYTES = 120;
+
+    uint64_t sequence = 0;       // numer zapytania w dzienniku
+    int64_t startedAtMicros = 0; // system_clock od epoki
+    uint64_t totalNanos = 0;
+    std::array<uint64_t, QUERY_STAGE_COUNT> stageNanos{};
+    uint64_t rowsScanned = 0;
+    uint64_t rowsReturned = 0;
+    bool failed = false;
+    char text[TEXT_BYTES] = {};  // początek tekstu zapytania, zakończony zerem
+
+    std::string_view query() const { return text; }
+};
+
+// Liczniki wszystkich zapytań od startu
+struct QueryCounters {
+    uint64_t queries = 0;
+    uint64_t failed = 0;
+    uint64_t totalNanos = 0;
+    std::array<uint64_t, QUERY_STAGE_COUNT> stageNanos{};
+    uint64_t rowsScanned = 0;
+    uint64_t rowsReturned = 0;
+    uint64_t blocksSkipped = 0;
+};
+
+// Statystyki ostatnich zapytań w pierścieniu bez blokad (seqlock na slot: zapis nie czeka na
+// odczyt, odczyt pomija slot nadpisywany w tej chwili) i liczniki zbiorcze na atomikach
+class QueryMonitor {
+public:
+    static constexpr size_t CAPACITY = 1024; // potęga dwójki
+
+    QueryMonitor();
+
+    // Dopisuje zapytanie do pierścienia i liczników
+    void record(std::string_view query, const QueryProfile &profile, bool failed);
+
+    // Do maxCount ostatnich zapytań, od najnowszego
+    std::vector<QueryStats> recent(size_t maxCount = CAPACITY) const;
+
+    QueryCounters counters() const;
+
+private:
+    static constexpr size_t WORDS = (sizeof(QueryStats) + 7) / 8;
+
+    struct Slot {
+        std::atomic<uint64_t> version{0}; // 2n+1 w trakcie zapisu n-tego wpisu, 2n+2 po zapisie
+        std::array<std::atomic<uint64_t>, WORDS> words{};
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::chrono::system_clock::duration steadyToSystem; // czas startu zapytań bez odczytu drugiego zegara
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> queries{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> totalNanos{0};
+    std::array<std::atomic<uint64_t>, QUERY_STAGE_COUNT> stageNanos{};
+    std::atomic<uint64_t> rowsScanned{0};
+    std::atomic<uint64_t> rowsReturned{0};
+    std::atomic<uint64_t> blocksSkipped{0};
+};
+
+// Migawka liczników do odczytu z zewnątrz (Database::metrics)
+struct MetricsSnapshot {
+    QueryCounters queries;
+    uint64_t planCacheHits = 0;
+    uint64_t planCacheMisses = 0;
+    size_t planCacheEntries = 0;
+    size_t tables = 0;
+    size_t poolUsedBytes = 0;
+    size_t poolCachedBytes = 0;
+    size_t arenaBytes = 0;
+    BufferPoolStats bufferPool;
+
+    // Format tekstowy Prometheusa: "nazwa wartość" w wierszach
+    std::string format() const;
+};
+
+#endif //DATABASE_INSTRUMENTATION_H
@@ -0,0 +1,314 @@
+#include "Join.h"
+#include "Diagnostics.h"
+#include "Hashing.h"
+#include "SpillFiles.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <filesystem>
+
+namespace {
+    const uint32_t END_OF_CHAIN = UINT32_MAX;
+
+    // Wpisy zapisywane do plików partycji paczkami tej wielkości
+    const size_t SPILL_BATCH = 4096;
+
+    // Pamięć jednego wpisu strony budującej: sam wpis oraz head/next tablicy łańcuchów
+    const size_t BUILD_ENTRY_BYTES = sizeof(JoinEntry) + 2 * sizeof(uint32_t);
+
+    // Bity hasza: łańcuchy biorą dolne, partycje radix bity od 32., partycje na dysku najwyższe
+    const unsigned RADIX_SHIFT = 32;
+    const unsigned MAX_RADIX_BITS = 12;
+    const unsigned MAX_SPILL_BITS = 10;
+
+    bool keyHash(const ColumnData &key, uint32_t row, uint64_t &hash) {
+        switch (key.getType()) {
+            case DataType::INT:
+                hash = hashInt(static_cast<uint64_t>(key.getInt(row)));
+                return true;
+            case DataType::FLOAT: {
+                double value = key.getFloat(row);
+                if (std::isnan(value)) {
+                    return false;
+                }
+                if (value == 0.0) {
+                    value = 0.0; // -0.0 == 0.0, więc ten sam hasz
+                }
+                uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                hash = hashInt(bits);
+                return true;
+            }
+            case DataType::STRING:
+                hash = hashBytes(key.getString(row));
+                return true;
+        }
+        return false;
+    }
+
+    bool keysEqual(const ColumnData &build, uint32_t buildRow, const ColumnData &probe, uint32_t probeRow) {
+        switch (build.getType()) {
+            case DataType::INT:
+                return build.getInt(buildRow) == probe.getInt(probeRow);
+            case DataType::FLOAT:
+                return build.getFloat(buildRow) == probe.getFloat(probeRow);
+            case DataType::STRING:
+                return build.getString(buildRow) == probe.getString(probeRow);
+        }
+        return false;
+    }
+
+    unsigned bitsFor(size_t partitions, unsigned maxBits) {
+        unsigned bits = 0;
+        while ((size_t(1) << bits) < partitions && bits < maxBits) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    // Tablica haszująca z łańcuchami w dwóch tablicach indeksów: heads[kubełek] i next[wpis]
+    class ChainTable {
+    public:
+        ChainTable(const JoinEntry *entries, size_t count) : entries(entries) {
+            size_t buckets = 1;
+            while (buckets < count) {
+                buckets <<= 1;
+            }
+            mask = buckets - 1;
+            heads.assign(buckets, END_OF_CHAIN);
+            next.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t &head = heads[entries[i].hash & mask];
+                next[i] = head;
+                head = static_cast<uint32_t>(i);
+            }
+        }
+
+        template<typename Emit>
+        void probe(uint64_t hash, Emit &&emit) const {
+            for (uint32_t i = heads[hash & mask]; i != END_OF_CHAIN; i = next[i]) {
+                if (entries[i].hash == hash) {
+                    emit(entries[i].row);
+                }
+            }
+        }
+
+    private:
+        const JoinEntry *entries;
+        uint64_t mask;
+        std::vector<uint32_t> heads;
+        std::vector<uint32_t> next;
+    };
+
+    // Sortowanie kubełkowe wpisów po bitach radix; zwraca początki partycji (partitions + 1 wartości)
+    std::vector<size_t> radixPartition(std::vector<JoinEntry> &entries, unsigned bits) {
+        size_t partitions = size_t(1) << bits;
+        uint64_t mask = partitions - 1;
+        std::vector<size_t> offsets(partitions + 1, 0);
+        for (const auto &entry : entries) {
+            ++offsets[((entry.hash >> RADIX_SHIFT) & mask) + 1];
+        }
+        for (size_t p = 0; p < partitions; ++p) {
+            offsets[p + 1] += offsets[p];
+        }
+        std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+        std::vector<JoinEntry> scattered(entries.size());
+        for (const auto &entry : entries) {
+            scattered[cursor[(entry.hash >> RADIX_SHIFT) & mask]++] = entry;
+        }
+        entries.swap(scattered);
+        return offsets;
+    }
+
+    void appendResult(JoinResult &target, const JoinResult &part) {
+        target.left.insert(target.left.end(), part.left.begin(), part.left.end());
+        target.right.insert(target.right.end(), part.right.begin(), part.right.end());
+    }
+
+    bool readSpill(const std::filesystem::path &path, std::vector<JoinEntry> &entries) {
+        std::error_code error;
+        auto bytes = std::filesystem::file_size(path, error);
+        if (error) {
+            return false;
+        }
+        entries.resize(bytes / sizeof(JoinEntry));
+        std::ifstream file(path, std::ios::binary);
+        return file.read(reinterpret_cast<char *>(entries.data()), static_cast<std::streamsize>(bytes)).good()
+               || entries.empty();
+    }
+}
+
+HashJoin::HashJoin(const JoinInput &left, const JoinInput &right, const JoinOptions &options)
+        : left(left), right(right), options(options) {
+}
+
+bool HashJoin::run(JoinResult &result) {
+    if (left.key->getType() != right.key->getType()) {
+        errorStream() << "Join columns have different types." << std::endl;
+        return false;
+    }
+
+    // Budujemy na stronie z mniejszą liczbą wierszy po filtrze
+    buildIsLeft = left.rows.size() <= right.rows.size();
+    const JoinInput &build = buildIsLeft ? left : right;
+    const JoinInput &probe = buildIsLeft ? right : left;
+    buildKey = build.key;
+    probeKey = probe.key;
+
+    size_t stateBytes = build.rows.size() * BUILD_ENTRY_BYTES + probe.rows.size() * sizeof(JoinEntry);
+    if (stateBytes > options.memoryBudget) {
+        return joinSpilled(build, probe, result);
+    }
+    std::vector<JoinEntry> buildEntries = makeEntries(build, 0, build.rows.size());
+    std::vector<JoinEntry> probeEntries = makeEntries(probe, 0, probe.rows.size());
+    joinInMemory(buildEntries, probeEntries, result);
+    return true;
+}
+
+std::vector<JoinEntry> HashJoin::makeEntries(const JoinInput &input, size_t first, size_t count) const {
+    std::vector<std::vector<JoinEntry>> parts(ThreadPool::morselCount(count));
+    ThreadPool::shared().forEachMorsel(count, [&](size_t morsel, size_t begin, size_t rows, unsigned) {
+        auto &part = parts[morsel];
+        part.reserve(rows);
+        for (size_t i = first + begin; i < first + begin + rows; ++i) {
+            uint32_t row = input.rows[i];
+            uint64_t hash;
+            if (!input.key->isNull(row) && keyHash(*input.key, row, hash)) {
+                part.push_back({hash, row});
+            }
+        }
+    });
+    if (parts.size() == 1) {
+        return std::move(parts.front());
+    }
+    std::vector<JoinEntry> entries;
+    for (const auto &part : parts) {
+        entries.insert(entries.end(), part.begin(), part.end());
+    }
+    return entries;
+}
+
+void HashJoin::joinInMemory(std::vector<JoinEntry> &build, std::vector<JoinEntry> &probe, JoinResult &result) const {
+    size_t buildBytes = build.size() * BUILD_ENTRY_BYTES;
+    if (buildBytes <= options.cacheBytes) {
+        // Jedna tablica w cache, sondowanie wsadami równolegle
+        ChainTable table(build.data(), build.size());
+        std::vector<JoinResult> parts(ThreadPool::morselCount(probe.size()));
+        ThreadPool::shared().forEachMorsel(probe.size(), [&](size_t morsel, size_t first, size_t count, unsigned) {
+            for (size_t i = first; i < first + count; ++i) {
+                uint32_t probeRow = probe[i].row;
+                table.probe(probe[i].hash, [&](uint32_t buildRow) {
+                    if (keysEqual(*buildKey, buildRow, *probeKey, probeRow)) {
+                        emit(buildRow, probeRow, parts[morsel]);
+                    }
+                });
+            }
+        });
+        for (const auto &part : parts) {
+            appendResult(result, part);
+        }
+        return;
+    }
+
+    // Partycje radix: tablica każdej partycji strony budującej mieści się w cache
+    unsigned bits = bitsFor((buildBytes + options.cacheBytes - 1) / std::max<size_t>(options.cacheBytes, 1),
+                            MAX_RADIX_BITS);
+    std::vector<size_t> buildOffsets = radixPartition(build, bits);
+    std::vector<size_t> probeOffsets = radixPartition(probe, bits);
+    std::vector<JoinResult> parts(buildOffsets.size() - 1);
+    ThreadPool::shared().parallelFor(parts.size(), [&](size_t p, unsigned) {
+        joinPartition(build.data() + buildOffsets[p], buildOffsets[p + 1] - buildOffsets[p],
+                      probe.data() + probeOffsets[p], probeOffsets[p + 1] - probeOffsets[p], parts[p]);
+    });
+    for (const auto &part : parts) {
+        appendResult(result, part);
+    }
+}
+
+void HashJoin::joinPartition(const JoinEntry *build, size_t buildCount, const JoinEntry *probe, size_t probeCount,
+                             JoinResult &result) const {
+    if (buildCount == 0 || probeCount == 0) {
+        return;
+    }
+    ChainTable table(build, buildCount);
+    for (size_t i = 0; i < probeCount; ++i) {
+        uint32_t probeRow = probe[i].row;
+        table.probe(probe[i].hash, [&](uint32_t buildRow) {
+            if (keysEqual(*buildKey, buildRow, *probeKey, probeRow)) {
+                emit(buildRow, probeRow, result);
+            }
+        });
+    }
+}
+
+bool HashJoin::joinSpilled(const JoinInput &build, const JoinInput &probe, JoinResult &result) const {
+    // Tyle partycji, żeby para partycji zajmowała najwyżej połowę budżetu
+    size_t stateBytes = build.rows.size() * BUILD_ENTRY_BYTES + probe.rows.size() * sizeof(JoinEntry);
+    size_t budget = std::max<size_t>(options.memoryBudget / 2, 1);
+    unsigned bits = std::max(1u, bitsFor((stateBytes + budget - 1) / budget, MAX_SPILL_BITS));
+    size_t partitions = size_t(1) << bits;
+
+    SpillFiles files(options.spillDirectory, "join");
+    for (const char *side : {"build", "probe"}) {
+        for (size_t p = 0; p < partitions; ++p) {
+            files.add(std::string(side) + "-" + std::to_string(p));
+        }
+    }
+
+    // Wpisy liczone równolegle porcjami morseli i rozrzucane do plików partycji
+    auto writeSide = [&](const JoinInput &input, const std::filesystem::path *paths) {
+        std::vector<std::ofstream> outputs;
+        for (size_t p = 0; p < partitions; ++p) {
+            outputs.emplace_back(paths[p], std::ios::binary | std::ios::trunc);
+            if (!outputs.back()) {
+                errorStream() << "Failed to create join spill file " << paths[p].string() << "." << std::endl;
+                return false;
+            }
+        }
+        std::vector<std::vector<JoinEntry>> buffers(partitions);
+        auto flush = [&](size_t p) {
+            outputs[p].write(reinterpret_cast<const char *>(buffers[p].data()),
+                             static_cast<std::streamsize>(buffers[p].size() * sizeof(JoinEntry)));
+            buffers[p].clear();
+        };
+        size_t step = ThreadPool::MORSEL_ROWS * ThreadPool::shared().concurrency();
+        for (size_t first = 0; first < input.rows.size(); first += step) {
+            std::vector<JoinEntry> entries = makeEntries(input, first, std::min(step, input.rows.size() - first));
+            for (const auto &entry : entries) {
+                size_t p = entry.hash >> (64 - bits);
+                buffers[p].push_back(entry);
+                if (buffers[p].size() == SPILL_BATCH) {
+                    flush(p);
+                }
+            }
+        }
+        for (size_t p = 0; p < partitions; ++p) {
+            flush(p);
+            if (!outputs[p].flush()) {
+                errorStream() << "Failed to write join spill file " << paths[p].string() << "." << std::endl;
+                return false;
+            }
+        }
+        return true;
+    };
+    if (!writeSide(build, files.paths().data()) || !writeSide(probe, files.paths().data() + partitions)) {
+        return false;
+    }
+
+    // Pary partycji wczytywane i łączone po jednej
+    for (size_t p = 0; p < partitions; ++p) {
+        std::vector<JoinEntry> buildEntries, probeEntries;
+        if (!readSpill(files.paths()[p], buildEntries) || !readSpill(files.paths()[partitions + p], probeEntries)) {
+            errorStream() << "Failed to read join spill partition " << p << "." << std::endl;
+            return false;
+        }
+        if (!buildEntries.empty() && !probeEntries.empty()) {
+            joinInMemory(buildEntries, probeEntries, result);
+        }
+    }
+    return true;
+}
+
+void HashJoin::emit(uint32_t buildRow, uint32_t probeRow, JoinResult &result) const {
+    result.left.push_back(buildIsLeft ? buildRow : probeRow);
+    result.right.push_back(buildIsLeft ? probeRow : buildRow);
+}
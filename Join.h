@@ -0,0 +1,64 @@
+#ifndef DATABASE_JOIN_H
+#define DATABASE_JOIN_H
+
+#include "PreRequistion.h"
+#include "ColumnStore.h"
+
+// Parametry złączenia haszującego
+struct JoinOptions {
+    size_t cacheBytes = size_t(1) << 20;       // większa strona budująca jest dzielona radix na partycje tej wielkości
+    size_t memoryBudget = size_t(256) << 20;   // stan złączenia ponad budżet jest partycjonowany na dysk
+    std::string spillDirectory;                // pusty = katalog tymczasowy systemu
+};
+
+// Jedna strona złączenia: kolumna klucza i wiersze, które przeszły filtr WHERE
+struct JoinInput {
+    const ColumnData *key = nullptr;
+    std::vector<uint32_t> rows;
+};
+
+// Pary złączonych wierszy: left[i] z tabeli po FROM, right[i] z tabeli po JOIN
+struct JoinResult {
+    std::vector<uint32_t> left;
+    std::vector<uint32_t> right;
+};
+
+// Wpis tablicy haszującej złączenia: hasz klucza i numer wiersza w tabeli
+struct JoinEntry {
+    uint64_t hash;
+    uint32_t row;
+};
+
+// Złączenie równościowe. Tablica haszująca budowana jest na mniejszej stronie, druga strona
+// sonduje ją wsadami (morselami) na wspólnej puli. Gdy strona budująca nie mieści się w cache,
+// obie strony dzielone są radix po bitach hasza i każda para partycji łączona jest osobno;
+// gdy stan złączenia przekracza budżet pamięci, partycje najpierw trafiają do plików
+// tymczasowych i są łączone po jednej (Grace hash join). Klucze NULL nie pasują do niczego.
+class HashJoin {
+public:
+    HashJoin(const JoinInput &left, const JoinInput &right, const JoinOptions &options);
+
+    // false (z komunikatem) przy niezgodnych typach kluczy albo błędzie plików tymczasowych
+    bool run(JoinResult &result);
+
+private:
+    std::vector<JoinEntry> makeEntries(const JoinInput &input, size_t first, size_t count) const;
+
+    void joinInMemory(std::vector<JoinEntry> &build, std::vector<JoinEntry> &probe, JoinResult &result) const;
+
+    void joinPartition(const JoinEntry *build, size_t buildCount, const JoinEntry *probe, size_t probeCount,
+                       JoinResult &result) const;
+
+    bool joinSpilled(const JoinInput &build, const JoinInput &probe, JoinResult &result) const;
+
+    void emit(uint32_t buildRow, uint32_t probeRow, JoinResult &result) const;
+
+    const JoinInput &left;
+    const JoinInput &right;
+    const JoinOptions &options;
+    bool buildIsLeft = false;
+    const ColumnData *buildKey = nullptr;
+    const ColumnData *probeKey = nullptr;
+};
+
+#endif //DATABASE_JOIN_H
@@ -0,0 +1,161 @@
+#include "MappedFile.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string &fileName) {
+    close();
+    // FILE_SHARE_DELETE - zmapowany plik można podmienić (MappedFile::replace); mapowanie zostaje przy starej treści
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    base = static_cast<const char *>(view);
+    length = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+bool MappedFile::replace(const std::string &source, const std::string &target) {
+    // Podmiana jednym krokiem, zapisana na dysk przed powrotem
+    return MoveFileExA(source.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+void MappedFile::close() {
+    if (base != nullptr) {
+        UnmapViewOfFile(base);
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+    }
+    base = nullptr;
+    length = 0;
+    fileHandle = mappingHandle = nullptr;
+}
+
+void MappedFile::prefetch(size_t offset, size_t bytes) const {
+#if _WIN32_WINNT >= 0x0602
+    if (offset < length) {
+        WIN32_MEMORY_RANGE_ENTRY range{const_cast<char *>(base) + offset, std::min(bytes, length - offset)};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    (void) offset;
+    (void) bytes;
+#endif
+}
+
+ZeroRegion::ZeroRegion(size_t bytes) {
+    void *region = bytes != 0 ? VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READONLY) : nullptr;
+    if (region != nullptr) {
+        base = static_cast<const char *>(region);
+        length = bytes;
+    }
+}
+
+ZeroRegion::~ZeroRegion() {
+    if (base != nullptr) {
+        VirtualFree(const_cast<char *>(base), 0, MEM_RELEASE);
+    }
+}
+
+void MappedFile::release(size_t offset, size_t bytes) const {
+    // VirtualUnlock na stronach niezablokowanych usuwa je z zestawu roboczego procesu
+    if (offset < length) {
+        VirtualUnlock(const_cast<char *>(base) + offset, std::min(bytes, length - offset));
+    }
+}
+
+#else
+
+bool MappedFile::open(const std::string &fileName) {
+    close();
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void *mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    base = static_cast<const char *>(mapping);
+    length = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+bool MappedFile::replace(const std::string &source, const std::string &target) {
+    // rename podmienia wpis w katalogu; istniejące mapowania zostają przy starym pliku
+    return std::rename(source.c_str(), target.c_str()) == 0;
+}
+
+void MappedFile::close() {
+    if (base != nullptr) {
+        munmap(const_cast<char *>(base), length);
+    }
+    base = nullptr;
+    length = 0;
+}
+
+void MappedFile::prefetch(size_t offset, size_t bytes) const {
+    if (offset < length) {
+        madvise(const_cast<char *>(base) + offset, std::min(bytes, length - offset), MADV_WILLNEED);
+    }
+}
+
+void MappedFile::release(size_t offset, size_t bytes) const {
+    if (offset < length) {
+        madvise(const_cast<char *>(base) + offset, std::min(bytes, length - offset), MADV_DONTNEED);
+    }
+}
+
+ZeroRegion::ZeroRegion(size_t bytes) {
+    void *region = bytes != 0 ? mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) : MAP_FAILED;
+    if (region != MAP_FAILED) {
+        base = static_cast<const char *>(region);
+        length = bytes;
+    }
+}
+
+ZeroRegion::~ZeroRegion() {
+    if (base != nullptr) {
+        munmap(const_cast<char *>(base), length);
+    }
+}
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef DATABASE_MAPPEDFILE_H
+#define DATABASE_MAPPEDFILE_H
+
+#include "PreRequistion.h"
+
+// Plik zmapowany tylko do odczytu (mmap / MapViewOfFile)
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const std::string &fileName);
+
+    void close();
+
+    const char *data() const { return base; }
+
+    size_t size() const { return length; }
+
+    // Wskazówki dla systemu o stronach [offset, offset + bytes); offset wielokrotnością rozmiaru strony.
+    // prefetch: asynchroniczny odczyt z wyprzedzeniem, release: zwolnienie stron z pamięci
+    // (plik jest tylko do odczytu, więc przy następnym dostępie strony są po prostu czytane ponownie)
+    void prefetch(size_t offset, size_t bytes) const;
+
+    void release(size_t offset, size_t bytes) const;
+
+    // Podmiana pliku target plikiem source, także gdy target jest zmapowany (wczytana migawka)
+    static bool replace(const std::string &source, const std::string &target);
+
+private:
+    const char *base = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#endif
+};
+
+// Wyzerowana pamięć tylko do odczytu (mapowanie anonimowe / VirtualAlloc). Strony nie zajmują pamięci
+// fizycznej, bo nikt do nich nie pisze - odczyty trafiają we wspólną stronę zer systemu.
+class ZeroRegion {
+public:
+    explicit ZeroRegion(size_t bytes);
+
+    ~ZeroRegion();
+
+    ZeroRegion(const ZeroRegion &) = delete;
+
+    ZeroRegion &operator=(const ZeroRegion &) = delete;
+
+    // nullptr, gdy mapowanie się nie udało
+    const char *data() const { return base; }
+
+    size_t size() const { return length; }
+
+private:
+    const char *base = nullptr;
+    size_t length = 0;
+};
+
+#endif //DATABASE_MAPPEDFILE_H
@@ -0,0 +1,176 @@
+#include "Memory.h"
+#include <bit>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    // Pamięć zarezerwowana przez areny wszystkich wątków
+    std::atomic<size_t> arenaBytes{0};
+}
+
+Arena::Arena(size_t chunkBytes) : chunkBytes(chunkBytes) {
+}
+
+Arena::~Arena() {
+    for (const Chunk &chunk : chunks) {
+        std::free(chunk.data);
+    }
+    arenaBytes -= reserved;
+}
+
+void *Arena::allocate(size_t bytes, size_t alignment) {
+    if (!chunks.empty()) {
+        auto address = reinterpret_cast<uintptr_t>(chunks[current].data) + used;
+        size_t padding = (alignment - address % alignment) % alignment;
+        if (used + padding + bytes <= chunks[current].size) {
+            used += padding + bytes;
+            return chunks[current].data + used - bytes;
+        }
+        ++current;
+    }
+
+    // Następny kawałek: zachowany z wcześniejszego użycia albo nowy (dość duży na tę alokację)
+    size_t needed = bytes + alignment;
+    if (current == chunks.size()) {
+        chunks.push_back({nullptr, 0});
+    }
+    Chunk &chunk = chunks[current];
+    if (chunk.size < needed) {
+        size_t size = std::max(chunkBytes, needed);
+        char *data = static_cast<char *>(std::malloc(size));
+        if (data == nullptr) {
+            throw std::bad_alloc();
+        }
+        std::free(chunk.data);
+        reserved += size - chunk.size;
+        arenaBytes += size - chunk.size;
+        chunk = {data, size};
+    }
+    used = 0;
+    return allocate(bytes, alignment);
+}
+
+void Arena::reset() {
+    current = 0;
+    used = 0;
+}
+
+Arena &Arena::local() {
+    thread_local Arena arena;
+    return arena;
+}
+
+BlockPool::~BlockPool() {
+    trim();
+}
+
+BlockPool &BlockPool::shared() {
+    static BlockPool *pool = new BlockPool();
+    return *pool;
+}
+
+size_t BlockPool::classOf(size_t bytes) {
+    if (bytes <= MIN_BLOCK) {
+        return 0;
+    }
+    // 2^k < bytes <= 2^(k+1), klasa w ćwiartkach przedziału
+    size_t k = std::bit_width(bytes - 1) - 1;
+    size_t quarter = size_t(1) << (k - 2);
+    size_t step = (bytes - (size_t(1) << k) + quarter - 1) / quarter;
+    return (k - 6) * 4 + step;
+}
+
+size_t BlockPool::classSize(size_t sizeClass) {
+    if (sizeClass == 0) {
+        return MIN_BLOCK;
+    }
+    size_t k = (sizeClass - 1) / 4 + 6;
+    return (size_t(1) << k) + ((sizeClass - 1) % 4 + 1) * (size_t(1) << (k - 2));
+}
+
+size_t BlockPool::blockSize(size_t bytes) {
+    if (bytes <= MIN_BLOCK) {
+        return MIN_BLOCK;
+    }
+    if (bytes > LARGE_BLOCK) {
+        return bytes;
+    }
+    size_t k = std::bit_width(bytes - 1) - 1;
+    size_t quarter = size_t(1) << (k - 2);
+    return (size_t(1) << k) + (bytes - (size_t(1) << k) + quarter - 1) / quarter * quarter;
+}
+
+void *BlockPool::allocate(size_t bytes) {
+    size_t size = blockSize(bytes);
+    usedBytes += size;
+    if (bytes <= LARGE_BLOCK) {
+        SizeClass &entry = classes[classOf(bytes)];
+        std::lock_guard<std::mutex> lock(entry.mutex);
+        if (!entry.blocks.empty()) {
+            void *block = entry.blocks.back();
+            entry.blocks.pop_back();
+            cachedBytes -= size;
+            ++hits;
+            return block;
+        }
+    }
+    ++misses;
+    void *block = std::malloc(size);
+    if (block == nullptr) {
+        usedBytes -= size;
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+void BlockPool::deallocate(void *block, size_t bytes) {
+    if (block == nullptr) {
+        return;
+    }
+    size_t size = blockSize(bytes);
+    usedBytes -= size;
+    if (bytes <= LARGE_BLOCK && cachedBytes + size <= cacheLimit) {
+        SizeClass &entry = classes[classOf(bytes)];
+        std::lock_guard<std::mutex> lock(entry.mutex);
+        entry.blocks.push_back(block);
+        cachedBytes += size;
+        return;
+    }
+    std::free(block);
+}
+
+void BlockPool::setCacheLimit(size_t bytes) {
+    cacheLimit = bytes;
+    if (cachedBytes > bytes) {
+        trim();
+    }
+}
+
+void BlockPool::trim() {
+    for (size_t sizeClass = 0; sizeClass < CLASS_COUNT; ++sizeClass) {
+        SizeClass &entry = classes[sizeClass];
+        std::lock_guard<std::mutex> lock(entry.mutex);
+        for (void *block : entry.blocks) {
+            std::free(block);
+        }
+        cachedBytes -= entry.blocks.size() * classSize(sizeClass);
+        entry.blocks.clear();
+        entry.blocks.shrink_to_fit();
+    }
+}
+
+BlockPool::Stats BlockPool::stats() const {
+    Stats result;
+    result.usedBytes = usedBytes;
+    result.cachedBytes = cachedBytes;
+    result.hits = hits;
+    result.misses = misses;
+    return result;
+}
+
+MemoryStats memoryStats() {
+    MemoryStats result;
+    result.pool = BlockPool::shared().stats();
+    result.arenaBytes = arenaBytes;
+    return result;
+}
@@ -0,0 +1,187 @@
+#ifndef DATABASE_MEMORY_H
+#define DATABASE_MEMORY_H
+
+#include "PreRequistion.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+// Arena (bump allocator) na przejściowy stan zapytania: alokacja przesuwa wskaźnik w bieżącym
+// kawałku pamięci, zwalniane jest wszystko naraz - Scope przywraca arenę do stanu z chwili
+// swojego utworzenia, a kawałki zostają do ponownego użycia. Arena nie jest współbieżna:
+// każdy wątek (także wątki puli wykonujące morsele) ma własną, Arena::local().
+class Arena {
+public:
+    explicit Arena(size_t chunkBytes = size_t(256) << 10);
+
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    template<typename T>
+    T *allocateArray(size_t count) {
+        return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Zwalnia wszystkie alokacje (kawałki zostają)
+    void reset();
+
+    size_t reservedBytes() const { return reserved; }
+
+    // Arena bieżącego wątku
+    static Arena &local();
+
+    class Scope {
+    public:
+        explicit Scope(Arena &arena) : arena(arena), chunk(arena.current), used(arena.used) {}
+
+        ~Scope() {
+            arena.current = chunk;
+            arena.used = used;
+        }
+
+        Scope(const Scope &) = delete;
+
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        Arena &arena;
+        size_t chunk;
+        size_t used;
+    };
+
+private:
+    struct Chunk {
+        char *data;
+        size_t size;
+    };
+
+    size_t chunkBytes;
+    std::vector<Chunk> chunks;
+    size_t current = 0; // kawałek, w którym trwa alokacja
+    size_t used = 0;    // zajęte bajty bieżącego kawałka
+    size_t reserved = 0;
+};
+
+// Alokator kontenerów std na arenie; deallocate nic nie robi
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(Arena &arena) : arena(&arena) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(size_t count) { return arena->allocateArray<T>(count); }
+
+    void deallocate(T *, size_t) {}
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U> &other) const { return arena == other.arena; }
+
+private:
+    template<typename U> friend class ArenaAllocator;
+
+    Arena *arena;
+};
+
+// Pula bloków w klasach rozmiarów (cztery klasy na każdą potęgę dwójki, od 64 B do LARGE_BLOCK). Zwolniony
+// blok trafia na listę swojej klasy i jest wydawany ponownie zamiast wracać do malloc; listy mają
+// wspólny limit bajtów, bloki ponad nim wracają do systemu od razu. Z puli korzystają tablice
+// kolumn tabel i wyników (PoolAllocator), więc ciągłe budowanie i zwalnianie wyników nie
+// fragmentuje sterty. Bloki większe niż LARGE_BLOCK idą prosto do malloc w dokładnym rozmiarze -
+// zaokrąglenie do klasy marnowałoby do 25% dużej kolumny, a malloc i tak obsługuje je przez mmap.
+class BlockPool {
+public:
+    static constexpr size_t MIN_BLOCK = 64;
+    static constexpr size_t LARGE_BLOCK = size_t(1) << 20;
+    static constexpr size_t CLASS_COUNT = 4 * 14 + 1; // klasy 64 B .. LARGE_BLOCK
+
+    struct Stats {
+        size_t usedBytes = 0;    // bloki wydane i jeszcze nie zwrócone
+        size_t cachedBytes = 0;  // zwolnione bloki czekające na listach
+        uint64_t hits = 0;       // alokacje z listy
+        uint64_t misses = 0;     // alokacje z malloc
+    };
+
+    BlockPool() = default;
+
+    ~BlockPool();
+
+    BlockPool(const BlockPool &) = delete;
+
+    BlockPool &operator=(const BlockPool &) = delete;
+
+    // Pula wspólna dla całego procesu (nigdy nie niszczona - kolumny statyczne mogą ją przeżyć)
+    static BlockPool &shared();
+
+    void *allocate(size_t bytes);
+
+    // bytes jak przy allocate
+    void deallocate(void *block, size_t bytes);
+
+    void setCacheLimit(size_t bytes);
+
+    // Oddaje do systemu wszystkie bloki z list
+    void trim();
+
+    Stats stats() const;
+
+    // Rozmiar bloku faktycznie przydzielanego dla bytes (ponad LARGE_BLOCK równy bytes)
+    static size_t blockSize(size_t bytes);
+
+private:
+    static size_t classOf(size_t bytes);
+
+    static size_t classSize(size_t sizeClass);
+
+    struct SizeClass {
+        std::mutex mutex;
+        std::vector<void *> blocks;
+    };
+
+    std::array<SizeClass, CLASS_COUNT> classes;
+    std::atomic<size_t> cacheLimit{size_t(64) << 20};
+    std::atomic<size_t> usedBytes{0};
+    std::atomic<size_t> cachedBytes{0};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+};
+
+template<typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    PoolAllocator() = default;
+
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U> &) {}
+
+    T *allocate(size_t count) { return static_cast<T *>(BlockPool::shared().allocate(count * sizeof(T))); }
+
+    void deallocate(T *block, size_t count) { BlockPool::shared().deallocate(block, count * sizeof(T)); }
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U> &) const { return true; }
+};
+
+template<typename T>
+using PooledVector = std::vector<T, PoolAllocator<T>>;
+
+// Liczniki alokatorów: pula bloków i areny wszystkich wątków
+struct MemoryStats {
+    BlockPool::Stats pool;
+    size_t arenaBytes = 0;
+};
+
+MemoryStats memoryStats();
+
+#endif //DATABASE_MEMORY_H
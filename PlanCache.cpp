@@ -0,0 +1,73 @@
+#include "PlanCache.h"
+
+std::shared_ptr<const SelectPlan> CachedQuery::selectPlan() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return plan;
+}
+
+void CachedQuery::setSelectPlan(std::shared_ptr<const SelectPlan> newPlan) {
+    std::lock_guard<std::mutex> lock(mutex);
+    plan = std::move(newPlan);
+}
+
+PlanCache::PlanCache(size_t capacity) : capacity(capacity) {
+}
+
+std::shared_ptr<CachedQuery> PlanCache::find(std::string_view key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto entryIt = lookup.find(key);
+    if (entryIt == lookup.end()) {
+        ++misses;
+        return nullptr;
+    }
+    ++hits;
+    entries.splice(entries.begin(), entries, entryIt->second);
+    return entryIt->second->second;
+}
+
+void PlanCache::insert(const std::string &key, std::shared_ptr<CachedQuery> query) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (capacity == 0 || lookup.count(key) != 0) {
+        return;
+    }
+    entries.emplace_front(key, std::move(query));
+    lookup.emplace(entries.front().first, entries.begin());
+    evictOverflow();
+}
+
+void PlanCache::invalidate(const std::string &tableName) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto entryIt = entries.begin(); entryIt != entries.end();) {
+        const Statement &statement = entryIt->second->statement;
+        if (statement.tableName == tableName || statement.join.tableName == tableName) {
+            lookup.erase(entryIt->first);
+            entryIt = entries.erase(entryIt);
+        } else {
+            ++entryIt;
+        }
+    }
+}
+
+void PlanCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    lookup.clear();
+    entries.clear();
+}
+
+void PlanCache::setCapacity(size_t newCapacity) {
+    std::lock_guard<std::mutex> lock(mutex);
+    capacity = newCapacity;
+    evictOverflow();
+}
+
+PlanCache::Stats PlanCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return {hits, misses, entries.size()};
+}
+
+void PlanCache::evictOverflow() {
+    while (entries.size() > capacity) {
+        lookup.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
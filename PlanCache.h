@@ -0,0 +1,80 @@
+#ifndef DATABASE_PLANCACHE_H
+#define DATABASE_PLANCACHE_H
+
+#include "PreRequistion.h"
+#include "Database.h"
+#include "Predicate.h"
+#include "Aggregation.h"
+#include <list>
+#include <mutex>
+
+// Skompilowany plan SELECT bez JOIN dla jednej wersji schematu tabeli: rozwiązane kolumny
+// projekcji i agregaty, predykat-szablon (literały podstawiane przy każdym wykonaniu przez
+// Predicate::bind) oraz wybrany indeks.
+struct SelectPlan {
+    std::weak_ptr<Table> table;
+    uint64_t schemaVersion = 0;
+    std::vector<const Column *> projection; // nullptr dla agregatu
+    std::vector<int> aggregateOf;           // numer agregatu albo -1
+    std::vector<AggregateSpec> aggregates;
+    std::unique_ptr<Predicate> predicate;
+    const TableIndex *index = nullptr;
+    size_t indexComparison = 0;             // Predicate::comparisonAt dla indeksu
+};
+
+// Kształt zapytania z pamięci podręcznej: drzewo z parametrami w miejscu literałów
+// i (dla SELECT) plan zbudowany przy pierwszym wykonaniu
+class CachedQuery {
+public:
+    Statement statement;
+
+    std::shared_ptr<const SelectPlan> selectPlan() const;
+
+    void setSelectPlan(std::shared_ptr<const SelectPlan> plan);
+
+private:
+    mutable std::mutex mutex;
+    std::shared_ptr<const SelectPlan> plan;
+};
+
+// Pamięć podręczna LRU zapytań według tekstu znormalizowanego przez DBQLParser::normalize.
+// Wpisy tabeli są usuwane przy zmianie jej schematu; dodatkowo plan sprawdza wersję schematu
+// pod blokadą tabeli, więc zmiana między wyszukaniem a wykonaniem wymusza przebudowę.
+class PlanCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t entries = 0;
+    };
+
+    explicit PlanCache(size_t capacity = 1024);
+
+    // nullptr, gdy brak wpisu; trafiony wpis staje się najświeższy
+    std::shared_ptr<CachedQuery> find(std::string_view key);
+
+    void insert(const std::string &key, std::shared_ptr<CachedQuery> query);
+
+    // Usuwa wpisy odwołujące się do tabeli (także przez JOIN)
+    void invalidate(const std::string &tableName);
+
+    void clear();
+
+    void setCapacity(size_t newCapacity);
+
+    Stats stats() const;
+
+private:
+    void evictOverflow();
+
+    using Entry = std::pair<std::string, std::shared_ptr<CachedQuery>>;
+
+    size_t capacity;
+    std::list<Entry> entries; // od najświeższego
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> lookup; // klucze wskazują na napisy w entries
+    mutable std::mutex mutex;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+#endif //DATABASE_PLANCACHE_H
@@ -2,6 +2,8 @@
 #define DATABASE_PREREQUISTION_H
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstdint>
 #include <map>
 #include <iostream>
 #include <ostream>
@@ -10,6 +12,5 @@
 #include <fstream>
 #include <algorithm>
 #include <unordered_map>
-#include <SFML/Graphics.hpp>
 
 #endif //DATABASE_PREREQUISTION_H
@@ -0,0 +1,496 @@
+#include "Predicate.h"
+#include "Diagnostics.h"
+#include "Memory.h"
+#include <cmath>
+
+namespace {
+    template<typename T>
+    bool compareValues(const T &left, CompareOp op, const T &right) {
+        switch (op) {
+            case CompareOp::EQ:
+                return left == right;
+            case CompareOp::NE:
+                return left != right;
+            case CompareOp::LT:
+                return left < right;
+            case CompareOp::LE:
+                return left <= right;
+            case CompareOp::GT:
+                return left > right;
+            case CompareOp::GE:
+                return left >= right;
+        }
+        return false;
+    }
+
+    // Usuwa cudzysłowy wokół literału napisowego
+    std::string_view unquote(std::string_view value) {
+        if (value.size() >= 2 && (value.front() == '\'' || value.front() == '"') && value.back() == value.front()) {
+            return value.substr(1, value.size() - 2);
+        }
+        return value;
+    }
+
+    std::unique_ptr<PredicateNode> cloneNode(const PredicateNode &node, const std::vector<std::string_view> &values,
+                                             size_t &position, const Comparison *&invalid) {
+        auto copy = std::make_unique<PredicateNode>();
+        copy->kind = node.kind;
+        if (node.kind == PredicateNode::Kind::COMPARE) {
+            copy->comparison.column = node.comparison.column;
+            copy->comparison.columnIndex = node.comparison.columnIndex;
+            copy->comparison.op = node.comparison.op;
+            if (!copy->comparison.setLiteral(values[position++]) && invalid == nullptr) {
+                invalid = &node.comparison;
+            }
+            return copy;
+        }
+        for (const auto &child : node.children) {
+            copy->children.push_back(cloneNode(*child, values, position, invalid));
+        }
+        return copy;
+    }
+
+    // Porównania w kolejności przejścia w głąb, czyli w kolejności warunków
+    template<typename Visit>
+    bool visitComparisons(const PredicateNode *node, Visit &&visit) {
+        if (node == nullptr) {
+            return false;
+        }
+        if (node->kind == PredicateNode::Kind::COMPARE) {
+            return visit(node->comparison);
+        }
+        for (const auto &child : node->children) {
+            if (visitComparisons(child.get(), visit)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Czy jakaś wartość z [low, high] może spełnić porównanie z literałem
+    template<typename T>
+    bool rangeMayMatch(T low, T high, CompareOp op, T literal) {
+        switch (op) {
+            case CompareOp::EQ:
+                return low <= literal && literal <= high;
+            case CompareOp::NE:
+                return !(low == literal && high == literal);
+            case CompareOp::LT:
+                return low < literal;
+            case CompareOp::LE:
+                return low <= literal;
+            case CompareOp::GT:
+                return high > literal;
+            case CompareOp::GE:
+                return high >= literal;
+        }
+        return true;
+    }
+
+    std::unique_ptr<PredicateNode> collapse(std::unique_ptr<PredicateNode> node) {
+        if (node->kind != PredicateNode::Kind::COMPARE && node->children.size() == 1) {
+            return std::move(node->children.front());
+        }
+        return node;
+    }
+
+    // Dołącza węzeł do rodzica; AND w AND i OR w OR rozwijane (a AND (b AND c) = jedna koniunkcja)
+    void adopt(PredicateNode &parent, std::unique_ptr<PredicateNode> child) {
+        if (child->kind == parent.kind) {
+            for (auto &grandchild : child->children) {
+                parent.children.push_back(std::move(grandchild));
+            }
+        } else {
+            parent.children.push_back(std::move(child));
+        }
+    }
+
+    // Poziom nawiasów przy kompilacji: alternatywa zamkniętych koniunkcji i bieżąca koniunkcja
+    struct GroupFrame {
+        std::unique_ptr<PredicateNode> orNode = std::make_unique<PredicateNode>();
+        std::unique_ptr<PredicateNode> andNode = std::make_unique<PredicateNode>();
+
+        GroupFrame() {
+            orNode->kind = PredicateNode::Kind::OR;
+            andNode->kind = PredicateNode::Kind::AND;
+        }
+
+        void closeConjunction() {
+            adopt(*orNode, collapse(std::move(andNode)));
+            andNode = std::make_unique<PredicateNode>();
+            andNode->kind = PredicateNode::Kind::AND;
+        }
+
+        std::unique_ptr<PredicateNode> finish() {
+            closeConjunction();
+            return collapse(std::move(orNode));
+        }
+    };
+}
+
+bool Comparison::setLiteral(std::string_view value) {
+    value = unquote(value);
+    switch (column->getType()) {
+        case DataType::INT:
+            return parseIntValue(value, intValue);
+        case DataType::FLOAT:
+            return parseFloatValue(value, floatValue);
+        case DataType::STRING:
+            stringValue.assign(value);
+            translateToCodes();
+            return true;
+    }
+    return false;
+}
+
+void Comparison::translateToCodes() {
+    useCodes = column->isDictionaryEncoded();
+    codeMatches.clear();
+    if (!useCodes) {
+        return;
+    }
+    auto size = static_cast<uint32_t>(column->dictionarySize());
+    std::string_view literal(stringValue);
+    if (!column->arrays().sortedDictionary) {
+        codeMatches.resize(size);
+        for (uint32_t code = 0; code < size; ++code) {
+            codeMatches[code] = compareValues(column->dictionaryEntry(code), op, literal);
+        }
+        return;
+    }
+
+    // Pierwszy kod z wpisem >= literał (lower) i > literał (upper)
+    auto firstCode = [&](bool strict) {
+        uint32_t low = 0, high = size;
+        while (low < high) {
+            uint32_t middle = low + (high - low) / 2;
+            std::string_view entry = column->dictionaryEntry(middle);
+            if (strict ? entry <= literal : entry < literal) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    };
+    uint32_t lower = firstCode(false);
+    uint32_t upper = firstCode(true);
+    switch (op) {
+        case CompareOp::EQ:
+        case CompareOp::NE:
+            codeLow = lower;
+            codeHigh = upper;
+            break;
+        case CompareOp::LT:
+            codeLow = 0;
+            codeHigh = lower;
+            break;
+        case CompareOp::LE:
+            codeLow = 0;
+            codeHigh = upper;
+            break;
+        case CompareOp::GT:
+            codeLow = upper;
+            codeHigh = size;
+            break;
+        case CompareOp::GE:
+            codeLow = lower;
+            codeHigh = size;
+            break;
+    }
+}
+
+bool Comparison::matchesCode(uint32_t code) const {
+    if (!codeMatches.empty()) {
+        return codeMatches[code] != 0;
+    }
+    bool inRange = code - codeLow < codeHigh - codeLow;
+    return op == CompareOp::NE ? !inRange : inRange;
+}
+
+bool Comparison::mayMatch(size_t zone) const {
+    const ColumnZone &stats = column->zoneMaps()[zone];
+    size_t zoneRows = std::min(ColumnData::ZONE_ROWS, column->size() - zone * ColumnData::ZONE_ROWS);
+    size_t values = zoneRows - stats.nullCount;
+    switch (column->getType()) {
+        case DataType::INT:
+            return values > 0 && rangeMayMatch(stats.minInt, stats.maxInt, op, intValue);
+        case DataType::FLOAT:
+            // NaN (w kolumnie albo jako literał) spełnia tylko NE
+            if (std::isnan(floatValue) || stats.nanCount > 0) {
+                if (op == CompareOp::NE && values > 0) {
+                    return true;
+                }
+                if (std::isnan(floatValue)) {
+                    return false;
+                }
+            }
+            return values > stats.nanCount && rangeMayMatch(stats.minFloat, stats.maxFloat, op, floatValue);
+        case DataType::STRING:
+            return values > 0;
+    }
+    return true;
+}
+
+bool Comparison::matches(size_t row) const {
+    if (column->isNull(row)) {
+        return false;
+    }
+    switch (column->getType()) {
+        case DataType::INT:
+            return compareValues(column->getInt(row), op, intValue);
+        case DataType::FLOAT:
+            return compareValues(column->getFloat(row), op, floatValue);
+        case DataType::STRING:
+            if (useCodes) {
+                return matchesCode(column->codeAt(row));
+            }
+            return compareValues(column->getString(row), op, std::string_view(stringValue));
+    }
+    return false;
+}
+
+void Comparison::evaluate(size_t firstRow, size_t rowCount, uint64_t *out) const {
+    size_t words = (rowCount + 63) / 64;
+    switch (column->getType()) {
+        case DataType::INT:
+            FilterKernels::compareInt(column->intData() + firstRow, rowCount, op, intValue, out);
+            break;
+        case DataType::FLOAT:
+            FilterKernels::compareFloat(column->floatData() + firstRow, rowCount, op, floatValue, out);
+            break;
+        case DataType::STRING:
+            if (useCodes) {
+                const ColumnArrays &arrays = column->arrays();
+                const uint8_t *codes = arrays.codes + firstRow * arrays.codeWidth;
+                if (codeMatches.empty()) {
+                    FilterKernels::compareCodes(codes, arrays.codeWidth, rowCount, codeLow, codeHigh,
+                                                op == CompareOp::NE, out);
+                } else {
+                    FilterKernels::lookupCodes(codes, arrays.codeWidth, rowCount, codeMatches.data(), out);
+                }
+                break;
+            }
+            std::fill(out, out + words, 0);
+            for (size_t row = 0; row < rowCount; ++row) {
+                if (compareValues(column->getString(firstRow + row), op, std::string_view(stringValue))) {
+                    out[row >> 6] |= uint64_t(1) << (row & 63);
+                }
+            }
+            break;
+    }
+    FilterKernels::andNotBitmap(out, column->nullData() + firstRow / 64, words);
+}
+
+bool PredicateNode::mayMatch(size_t zone) const {
+    switch (kind) {
+        case Kind::COMPARE:
+            return comparison.mayMatch(zone);
+        case Kind::AND:
+            return std::all_of(children.begin(), children.end(), [zone](const auto &child) { return child->mayMatch(zone); });
+        case Kind::OR:
+            return std::any_of(children.begin(), children.end(), [zone](const auto &child) { return child->mayMatch(zone); });
+    }
+    return true;
+}
+
+void PredicateNode::evaluate(size_t firstRow, size_t rowCount, uint64_t *out) const {
+    if (kind == Kind::COMPARE) {
+        comparison.evaluate(firstRow, rowCount, out);
+        return;
+    }
+    size_t words = (rowCount + 63) / 64;
+    children.front()->evaluate(firstRow, rowCount, out);
+    Arena &arena = Arena::local();
+    Arena::Scope scope(arena);
+    uint64_t *childBits = arena.allocateArray<uint64_t>(words);
+    for (size_t i = 1; i < children.size(); ++i) {
+        children[i]->evaluate(firstRow, rowCount, childBits);
+        if (kind == Kind::AND) {
+            FilterKernels::andBitmap(out, childBits, words);
+        } else {
+            FilterKernels::orBitmap(out, childBits, words);
+        }
+    }
+}
+
+bool Predicate::mayMatch(size_t firstRow, size_t rowCount) const {
+    if (root == nullptr || rowCount == 0) {
+        return root == nullptr;
+    }
+    for (size_t zone = firstRow / ColumnData::ZONE_ROWS; zone <= (firstRow + rowCount - 1) / ColumnData::ZONE_ROWS; ++zone) {
+        if (root->mayMatch(zone)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SelectionBitmap Predicate::evaluate(size_t firstRow, size_t rowCount) const {
+    SelectionBitmap bitmap((rowCount + 63) / 64);
+    evaluate(firstRow, rowCount, bitmap.data());
+    return bitmap;
+}
+
+void Predicate::evaluate(size_t firstRow, size_t rowCount, uint64_t *out) const {
+    size_t words = (rowCount + 63) / 64;
+    if (root) {
+        root->evaluate(firstRow, rowCount, out);
+        return;
+    }
+    std::fill(out, out + words, ~uint64_t(0));
+    if (rowCount & 63) {
+        out[words - 1] = (uint64_t(1) << (rowCount & 63)) - 1;
+    }
+}
+
+bool PredicateNode::matches(size_t row) const {
+    switch (kind) {
+        case Kind::COMPARE:
+            return comparison.matches(row);
+        case Kind::AND:
+            for (const auto &child : children) {
+                if (!child->matches(row)) {
+                    return false;
+                }
+            }
+            return true;
+        case Kind::OR:
+            for (const auto &child : children) {
+                if (child->matches(row)) {
+                    return true;
+                }
+            }
+            return false;
+    }
+    return false;
+}
+
+bool Predicate::parseOperator(const std::string &op, CompareOp &result) {
+    if (op == "==" || op == "=") {
+        result = CompareOp::EQ;
+    } else if (op == "!=" || op == "<>") {
+        result = CompareOp::NE;
+    } else if (op == "<") {
+        result = CompareOp::LT;
+    } else if (op == "<=") {
+        result = CompareOp::LE;
+    } else if (op == ">") {
+        result = CompareOp::GT;
+    } else if (op == ">=") {
+        result = CompareOp::GE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<Predicate> Predicate::compile(const Table &table, const std::vector<Condition> &conditions) {
+    auto predicate = std::make_unique<Predicate>();
+    if (conditions.empty()) {
+        return predicate;
+    }
+
+    // Ramka na poziom nawiasów; zamknięta grupa staje się jednym składnikiem koniunkcji poziomu wyżej
+    std::vector<GroupFrame> frames(1);
+    for (const auto &cond : conditions) {
+        const Column *column = table.findColumn(cond.column);
+        if (column == nullptr) {
+            errorStream() << "Column " << cond.column << " does not exist in table " << table.name << "." << std::endl;
+            return nullptr;
+        }
+
+        auto node = std::make_unique<PredicateNode>();
+        Comparison &comparison = node->comparison;
+        if (!parseOperator(cond.op, comparison.op)) {
+            errorStream() << "Unsupported operator " << cond.op << "." << std::endl;
+            return nullptr;
+        }
+
+        // Literał parsowany raz, do typu kolumny
+        comparison.columnIndex = column->index;
+        comparison.column = &table.data[comparison.columnIndex];
+        if (!comparison.setLiteral(cond.value)) {
+            errorStream() << "Invalid value " << cond.value << " for column " << cond.column << "." << std::endl;
+            return nullptr;
+        }
+
+        // OR zamyka bieżącą koniunkcję (na poziomie przed nawiasami warunku)
+        if (cond.logicalOperator == "OR" && !frames.back().andNode->children.empty()) {
+            frames.back().closeConjunction();
+        }
+        frames.resize(frames.size() + cond.openGroups);
+        frames.back().andNode->children.push_back(std::move(node));
+        for (size_t group = 0; group < cond.closeGroups; ++group) {
+            if (frames.size() == 1) {
+                errorStream() << "Unbalanced parentheses in condition." << std::endl;
+                return nullptr;
+            }
+            auto closed = frames.back().finish();
+            frames.pop_back();
+            adopt(*frames.back().andNode, std::move(closed));
+        }
+    }
+    if (frames.size() != 1) {
+        errorStream() << "Unbalanced parentheses in condition." << std::endl;
+        return nullptr;
+    }
+
+    predicate->root = frames.back().finish();
+    return predicate;
+}
+
+std::unique_ptr<Predicate> Predicate::bind(const Table &table, const std::vector<std::string_view> &values) const {
+    auto predicate = std::make_unique<Predicate>();
+    if (!root) {
+        return predicate;
+    }
+    size_t position = 0;
+    const Comparison *invalid = nullptr;
+    predicate->root = cloneNode(*root, values, position, invalid);
+    if (invalid != nullptr) {
+        for (const auto &col : table.columns) {
+            if (col.second.index == invalid->columnIndex) {
+                errorStream() << "Invalid value " << values[positionOf(invalid)] << " for column " << col.first
+                              << "." << std::endl;
+            }
+        }
+        return nullptr;
+    }
+    return predicate;
+}
+
+const Comparison *Predicate::comparisonAt(size_t position) const {
+    const Comparison *found = nullptr;
+    visitComparisons(root.get(), [&](const Comparison &comparison) {
+        if (position-- == 0) {
+            found = &comparison;
+            return true;
+        }
+        return false;
+    });
+    return found;
+}
+
+std::vector<const ColumnData *> Predicate::columns() const {
+    std::vector<const ColumnData *> result;
+    visitComparisons(root.get(), [&](const Comparison &comparison) {
+        if (std::find(result.begin(), result.end(), comparison.column) == result.end()) {
+            result.push_back(comparison.column);
+        }
+        return false;
+    });
+    return result;
+}
+
+size_t Predicate::positionOf(const Comparison *comparison) const {
+    size_t position = 0;
+    visitComparisons(root.get(), [&](const Comparison &candidate) {
+        if (&candidate == comparison) {
+            return true;
+        }
+        ++position;
+        return false;
+    });
+    return position;
+}
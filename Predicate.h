@@ -0,0 +1,102 @@
+#ifndef DATABASE_PREDICATE_H
+#define DATABASE_PREDICATE_H
+
+#include "PreRequistion.h"
+#include "Database.h"
+#include "DBQLParser.h"
+#include "FilterKernels.h"
+#include <memory>
+
+// Porównanie kolumny z literałem sparsowanym do typu kolumny
+struct Comparison {
+    const ColumnData *column = nullptr;
+    int columnIndex = -1;
+    CompareOp op = CompareOp::EQ;
+    int64_t intValue = 0;
+    double floatValue = 0.0;
+    std::string stringValue;
+
+    // Kolumna STRING kodowana słownikiem: warunek przełożony w setLiteral na kody. Przy posortowanym
+    // słowniku pasują kody z [codeLow, codeHigh) (dla NE spoza), przy nieposortowanym codeMatches[kod].
+    // Ważne, dopóki kolumna się nie zmieni - kompilacja i ocena pod tą samą blokadą tabeli.
+    bool useCodes = false;
+    uint32_t codeLow = 0;
+    uint32_t codeHigh = 0;
+    std::vector<uint8_t> codeMatches;
+
+    // Literał (w cudzysłowach albo bez) parsowany do typu kolumny; false, gdy nie pasuje do typu
+    bool setLiteral(std::string_view value);
+
+    void translateToCodes();
+
+    bool matchesCode(uint32_t code) const;
+
+    // false, gdy według statystyk bloku (ColumnData::zoneMaps) żaden jego wiersz nie spełnia porównania
+    bool mayMatch(size_t zone) const;
+
+    bool matches(size_t row) const;
+
+    // Wynik dla wierszy [firstRow, firstRow + rowCount) jako bitmapa; INT/FLOAT przez kernele SIMD.
+    // firstRow musi być wielokrotnością 64 (początek słowa bitmapy NULL-i).
+    void evaluate(size_t firstRow, size_t rowCount, uint64_t *out) const;
+};
+
+// Węzeł drzewa predykatu: porównanie albo AND/OR nad dziećmi
+struct PredicateNode {
+    enum class Kind {
+        COMPARE, AND, OR
+    };
+
+    Kind kind = Kind::COMPARE;
+    Comparison comparison;
+    std::vector<std::unique_ptr<PredicateNode>> children;
+
+    bool matches(size_t row) const;
+
+    bool mayMatch(size_t zone) const;
+
+    void evaluate(size_t firstRow, size_t rowCount, uint64_t *out) const;
+};
+
+// Warunek WHERE skompilowany raz na zapytanie: indeksy kolumn rozwiązane względem
+// Table::columns, literały sparsowane, AND wiąże mocniej niż OR, nawiasy (Condition::openGroups/closeGroups) grupują.
+class Predicate {
+public:
+    // Zwraca nullptr (i wypisuje błąd), gdy warunku nie da się skompilować
+    static std::unique_ptr<Predicate> compile(const Table &table, const std::vector<Condition> &conditions);
+
+    static bool parseOperator(const std::string &op, CompareOp &result);
+
+    // Kopia predykatu z nowymi literałami: values[i] zastępuje literał i-tego warunku z compile.
+    // Kolumny i operatory nie są ponownie rozwiązywane (plany z PlanCache).
+    std::unique_ptr<Predicate> bind(const Table &table, const std::vector<std::string_view> &values) const;
+
+    // Porównania w kolejności warunków z compile
+    const Comparison *comparisonAt(size_t position) const;
+
+    size_t positionOf(const Comparison *comparison) const;
+
+    // Kolumny czytane przez warunek, bez powtórzeń
+    std::vector<const ColumnData *> columns() const;
+
+    // Pusty predykat akceptuje każdy wiersz
+    bool empty() const { return root == nullptr; }
+
+    bool matches(size_t row) const { return root == nullptr || root->matches(row); }
+
+    // false, gdy statystyki bloków wykluczają wszystkie wiersze [firstRow, firstRow + rowCount)
+    bool mayMatch(size_t firstRow, size_t rowCount) const;
+
+    // Filtr fragmentu tabeli (np. jednego morsela): bit i = wiersz firstRow + i spełnia warunek
+    SelectionBitmap evaluate(size_t firstRow, size_t rowCount) const;
+
+    // To samo do gotowego bufora (np. z areny wątku) o (rowCount + 63) / 64 słowach
+    void evaluate(size_t firstRow, size_t rowCount, uint64_t *out) const;
+
+    const PredicateNode *getRoot() const { return root.get(); }
+
+private:
+    std::unique_ptr<PredicateNode> root;
+};
+
+#endif //DATABASE_PREDICATE_H
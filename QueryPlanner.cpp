@@ -0,0 +1,117 @@
+#include "QueryPlanner.h"
+#include "ThreadPool.h"
+#include "Memory.h"
+#include "Instrumentation.h"
+#include <atomic>
+#include <cmath>
+
+namespace {
+    // Lepszy kandydat: równość przed zakresem, HASH przed BTREE
+    int indexRank(const TableIndex *index, CompareOp op) {
+        int rank = op == CompareOp::EQ ? 2 : 0;
+        return rank + (index->getType() == IndexType::HASH ? 1 : 0);
+    }
+
+    void considerComparison(const Table &table, const Comparison &comparison, ScanPlan &best) {
+        if (comparison.column->getType() == DataType::FLOAT && std::isnan(comparison.floatValue)) {
+            return;
+        }
+        const TableIndex *index = table.findIndex(comparison.columnIndex, comparison.op);
+        if (index == nullptr) {
+            return;
+        }
+        if (best.index == nullptr || indexRank(index, comparison.op) > indexRank(best.index, best.indexComparison->op)) {
+            best.index = index;
+            best.indexComparison = &comparison;
+        }
+    }
+}
+
+ScanPlan QueryPlanner::plan(const Table &table, const Predicate &predicate) {
+    ScanPlan best;
+    const PredicateNode *root = predicate.getRoot();
+    if (root == nullptr || table.indexes.empty()) {
+        return best;
+    }
+    if (root->kind == PredicateNode::Kind::COMPARE) {
+        considerComparison(table, root->comparison, best);
+    } else if (root->kind == PredicateNode::Kind::AND) {
+        for (const auto &child : root->children) {
+            if (child->kind == PredicateNode::Kind::COMPARE) {
+                considerComparison(table, child->comparison, best);
+            }
+        }
+    }
+    return best;
+}
+
+void QueryPlanner::selectMorsel(const Table &table, const Predicate &predicate,
+                                const std::vector<const ColumnData *> &columns, size_t firstRow, size_t count,
+                                size_t aheadRow, std::vector<uint32_t> &rows) {
+    PageGuard pages;
+    pinScanMorsel(columns, firstRow, count, aheadRow, pages);
+    // Bitmapa morsela z areny wątku - bez malloc na każdy morsel
+    Arena &arena = Arena::local();
+    Arena::Scope scope(arena);
+    size_t words = (count + 63) / 64;
+    uint64_t *bitmap = arena.allocateArray<uint64_t>(words);
+    predicate.evaluate(firstRow, count, bitmap);
+    table.maskDeleted(firstRow, count, bitmap);
+    rows.reserve(rows.size() + FilterKernels::countBits(bitmap, words));
+    forEachSelected(bitmap, words, [&rows, firstRow](size_t row) {
+        rows.push_back(static_cast<uint32_t>(firstRow + row));
+    });
+}
+
+std::vector<uint32_t> QueryPlanner::matchingRows(const Table &table, const Predicate &predicate,
+                                                 const ScanPlan &plan) {
+    StageTimer timer(QueryStage::SCAN);
+    QueryProfile *profile = QueryProfile::active();
+    if (!plan.usesIndex()) {
+        // Skan morselami na wspólnej puli, wyniki łączone w kolejności morseli;
+        // morsele wykluczone przez statystyki bloków (zone maps) są pomijane bez czytania wierszy
+        std::vector<std::vector<uint32_t>> parts(ThreadPool::morselCount(table.rowCount));
+        std::atomic<size_t> skipped{0};
+        std::atomic<size_t> scanned{0};
+        std::vector<const ColumnData *> columns = predicate.columns();
+        size_t readahead = ThreadPool::MORSEL_ROWS * ThreadPool::shared().concurrency();
+        ThreadPool::shared().forEachMorsel(table.rowCount, [&](size_t morsel, size_t firstRow, size_t count, unsigned) {
+            if (!predicate.mayMatch(firstRow, count)) {
+                skipped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            scanned.fetch_add(count, std::memory_order_relaxed);
+            selectMorsel(table, predicate, columns, firstRow, count, firstRow + readahead, parts[morsel]);
+        });
+        size_t total = 0;
+        for (const auto &part : parts) {
+            total += part.size();
+        }
+        std::vector<uint32_t> rows;
+        rows.reserve(total);
+        for (const auto &part : parts) {
+            rows.insert(rows.end(), part.begin(), part.end());
+        }
+        if (profile != nullptr) {
+            profile->blocksSkipped += skipped;
+            profile->rowsScanned += scanned;
+        }
+        return rows;
+    }
+
+    // Kandydaci z indeksu, pozostałe warunki sprawdzane tylko dla nich
+    std::vector<uint32_t> candidates;
+    plan.index->lookup(*plan.indexComparison, candidates);
+    std::sort(candidates.begin(), candidates.end());
+    if (profile != nullptr) {
+        profile->rowsScanned += candidates.size();
+    }
+    std::vector<uint32_t> rows;
+    rows.reserve(candidates.size());
+    for (uint32_t row : candidates) {
+        if (predicate.matches(row)) {
+            rows.push_back(row);
+        }
+    }
+    return rows;
+}
@@ -0,0 +1,31 @@
+#ifndef DATABASE_QUERYPLANNER_H
+#define DATABASE_QUERYPLANNER_H
+
+#include "PreRequistion.h"
+#include "Database.h"
+#include "Predicate.h"
+
+// Wybrana ścieżka dostępu: indeks dla jednego porównania albo pełny skan
+struct ScanPlan {
+    const TableIndex *index = nullptr;
+    const Comparison *indexComparison = nullptr;
+
+    bool usesIndex() const { return index != nullptr; }
+};
+
+class QueryPlanner {
+public:
+    // Indeks jest wybierany, gdy korzeń predykatu (albo składnik koniunkcji na korzeniu)
+    // porównuje indeksowaną kolumnę; HASH ma pierwszeństwo dla równości.
+    static ScanPlan plan(const Table &table, const Predicate &predicate);
+
+    // Numery wierszy spełniających predykat, rosnąco
+    static std::vector<uint32_t> matchingRows(const Table &table, const Predicate &predicate, const ScanPlan &plan);
+
+    // Wiersze morsela [firstRow, firstRow + count) spełniające predykat (bez usuniętych), dopisywane rosnąco do rows.
+    // columns = predicate.columns(); od aheadRow odczyt z wyprzedzeniem (pinScanMorsel)
+    static void selectMorsel(const Table &table, const Predicate &predicate, const std::vector<const ColumnData *> &columns,
+                             size_t firstRow, size_t count, size_t aheadRow, std::vector<uint32_t> &rows);
+};
+
+#endif //DATABASE_QUERYPLANNER_H
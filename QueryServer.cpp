@@ -0,0 +1,289 @@
+#include "QueryServer.h"
+#include "Diagnostics.h"
+#include "ThreadPool.h"
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    const uint64_t LISTEN_ID = 0;
+    const uint64_t WAKE_ID = 1;
+
+    bool watch(int epollFd, int operation, int fd, uint64_t id, uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = id;
+        return epoll_ctl(epollFd, operation, fd, &event) == 0;
+    }
+
+    std::string encodeResponse(const ResultSet &result) {
+        std::string body = result.ok() ? result.format() : result.error;
+        return (result.ok() ? "OK " : "ERR ") + std::to_string(body.size()) + "\n" + body;
+    }
+
+    std::string encodeMetrics(const MetricsSnapshot &metrics) {
+        std::string body = metrics.format();
+        return "OK " + std::to_string(body.size()) + "\n" + body;
+    }
+}
+
+QueryServer::QueryServer(Database &database) : database(database) {
+}
+
+QueryServer::~QueryServer() {
+    // Zadania na puli odwołują się do serwera - czekamy na ich zakończenie
+    {
+        std::unique_lock<std::mutex> lock(completionMutex);
+        idle.wait(lock, [this] { return inFlight == 0; });
+    }
+    for (auto &connection : connections) {
+        close(connection.second.fd);
+    }
+    for (int fd : {listenFd, epollFd, wakeFd}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    if (listenFd >= 0) {
+        unlink(path.c_str());
+    }
+}
+
+bool QueryServer::listen(const std::string &socketPath) {
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        errorStream() << "Socket path " << socketPath << " is too long." << std::endl;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (listenFd < 0 || epollFd < 0 || wakeFd < 0) {
+        errorStream() << "Failed to create server sockets: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    unlink(socketPath.c_str());
+    if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0
+        || ::listen(listenFd, SOMAXCONN) != 0) {
+        errorStream() << "Failed to listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    path = socketPath;
+    return watch(epollFd, EPOLL_CTL_ADD, listenFd, LISTEN_ID, EPOLLIN)
+           && watch(epollFd, EPOLL_CTL_ADD, wakeFd, WAKE_ID, EPOLLIN);
+}
+
+void QueryServer::stop() {
+    stopping.store(true);
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = write(wakeFd, &one, sizeof(one));
+}
+
+void QueryServer::run() {
+    epoll_event events[64];
+    while (!stopping.load()) {
+        int ready = epoll_wait(epollFd, events, 64, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            errorStream() << "epoll_wait failed: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        for (int i = 0; i < ready; ++i) {
+            uint64_t id = events[i].data.u64;
+            if (id == LISTEN_ID) {
+                acceptConnections();
+            } else if (id == WAKE_ID) {
+                collectCompletions();
+            } else {
+                auto connectionIt = connections.find(id);
+                if (connectionIt == connections.end()) {
+                    continue;
+                }
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    closeConnection(id);
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT) {
+                    flushOutput(id, connectionIt->second);
+                }
+                if ((events[i].events & (EPOLLIN | EPOLLRDHUP)) && connections.count(id) != 0) {
+                    readConnection(id);
+                }
+            }
+        }
+    }
+}
+
+void QueryServer::acceptConnections() {
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                errorStream() << "accept failed: " << std::strerror(errno) << std::endl;
+            }
+            if (errno != EINTR) {
+                return;
+            }
+            continue;
+        }
+        uint64_t id = nextConnectionId++;
+        if (!watch(epollFd, EPOLL_CTL_ADD, fd, id, EPOLLIN | EPOLLRDHUP)) {
+            close(fd);
+            continue;
+        }
+        connections[id].fd = fd;
+        connections[id].events = EPOLLIN | EPOLLRDHUP;
+    }
+}
+
+void QueryServer::readConnection(uint64_t id) {
+    Connection &connection = connections[id];
+    char buffer[64 * 1024];
+    // Bez limitu klient wysyłający zapytania jedno za drugim rozdymałby bufor i zajmował pętlę zdarzeń
+    while (!connection.inputFull()) {
+        ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            connection.input.append(buffer, static_cast<size_t>(received));
+            continue;
+        }
+        if (received == 0) {
+            // Ostatnie zapytanie może nie mieć końcowego '\n'
+            connection.inputClosed = true;
+            if (!connection.input.empty() && connection.input.back() != '\n') {
+                connection.input += '\n';
+            }
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        closeConnection(id);
+        return;
+    }
+    if (connection.input.size() > MAX_QUERY_BYTES && connection.input.find('\n') == std::string::npos) {
+        errorStream() << "Query longer than " << MAX_QUERY_BYTES << " bytes, closing connection." << std::endl;
+        closeConnection(id);
+        return;
+    }
+    dispatchNext(id, connection);
+    updateConnection(id, connection);
+}
+
+void QueryServer::dispatchNext(uint64_t id, Connection &connection) {
+    while (!connection.busy && !connection.backedUp()) {
+        size_t newline = connection.input.find('\n');
+        if (newline == std::string::npos) {
+            return;
+        }
+        std::string query = connection.input.substr(0, newline);
+        connection.input.erase(0, newline + 1);
+        if (!query.empty() && query.back() == '\r') {
+            query.pop_back();
+        }
+        if (query.empty()) {
+            continue;
+        }
+
+        connection.busy = true;
+        {
+            std::lock_guard<std::mutex> lock(completionMutex);
+            ++inFlight;
+        }
+        ThreadPool::shared().submit([this, id, query] {
+            std::string response = query == "METRICS" ? encodeMetrics(database.metrics())
+                                                      : encodeResponse(database.execute(query));
+            {
+                std::lock_guard<std::mutex> lock(completionMutex);
+                completions.emplace_back(id, std::move(response));
+            }
+            uint64_t one = 1;
+            [[maybe_unused]] ssize_t written = write(wakeFd, &one, sizeof(one));
+            std::lock_guard<std::mutex> lock(completionMutex);
+            --inFlight;
+            idle.notify_all();
+        });
+    }
+}
+
+void QueryServer::collectCompletions() {
+    uint64_t counter;
+    [[maybe_unused]] ssize_t drained = read(wakeFd, &counter, sizeof(counter));
+    std::vector<std::pair<uint64_t, std::string>> finished;
+    {
+        std::lock_guard<std::mutex> lock(completionMutex);
+        finished.swap(completions);
+    }
+    for (auto &completion : finished) {
+        auto connectionIt = connections.find(completion.first);
+        if (connectionIt == connections.end()) {
+            continue;
+        }
+        Connection &connection = connectionIt->second;
+        connection.output += completion.second;
+        connection.busy = false;
+        dispatchNext(completion.first, connection);
+        flushOutput(completion.first, connection);
+    }
+}
+
+void QueryServer::flushOutput(uint64_t id, Connection &connection) {
+    size_t sent = 0;
+    while (sent < connection.output.size()) {
+        ssize_t written = send(connection.fd, connection.output.data() + sent, connection.output.size() - sent,
+                               MSG_NOSIGNAL);
+        if (written > 0) {
+            sent += static_cast<size_t>(written);
+            continue;
+        }
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        closeConnection(id);
+        return;
+    }
+    connection.output.erase(0, sent);
+    // Bufor mógł zejść poniżej limitu - wznawiamy wstrzymane zapytania
+    dispatchNext(id, connection);
+    updateConnection(id, connection);
+}
+
+void QueryServer::updateConnection(uint64_t id, Connection &connection) {
+    if (connection.inputClosed && !connection.busy && connection.output.empty()) {
+        closeConnection(id);
+        return;
+    }
+    // EPOLLIN do końca strumienia klienta (bez czytania, gdy klient nie odbiera odpowiedzi albo bufor wejścia
+    // jest pełny - wtedy zapełnia się bufor gniazda i klient blokuje się na wysyłaniu), EPOLLOUT tylko,
+    // dopóki w buforze zostały dane
+    bool paused = connection.inputClosed || connection.backedUp() || connection.inputFull();
+    uint32_t input = paused ? 0u : static_cast<uint32_t>(EPOLLIN | EPOLLRDHUP);
+    uint32_t events = input | (connection.output.empty() ? 0u : static_cast<uint32_t>(EPOLLOUT));
+    if (events != connection.events) {
+        connection.events = events;
+        watch(epollFd, EPOLL_CTL_MOD, connection.fd, id, events);
+    }
+}
+
+void QueryServer::closeConnection(uint64_t id) {
+    auto connectionIt = connections.find(id);
+    if (connectionIt == connections.end()) {
+        return;
+    }
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, connectionIt->second.fd, nullptr);
+    close(connectionIt->second.fd);
+    connections.erase(connectionIt);
+}
@@ -0,0 +1,91 @@
+#ifndef DATABASE_QUERYSERVER_H
+#define DATABASE_QUERYSERVER_H
+
+#include "PreRequistion.h"
+#include "Database.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+// Serwer zapytań bez GUI (Linux): gniazdo Unix, jedna pętla epoll obsługuje wszystkie połączenia,
+// a zapytania wykonywane są na wspólnej puli wątków (ThreadPool::shared).
+//
+// Protokół: klient wysyła zapytania DBQL zakończone '\n'. Odpowiedź na każde zapytanie to
+// nagłówek "OK <bajty>\n" z wynikiem w postaci ResultSet::format albo "ERR <bajty>\n"
+// z komunikatem błędu, po którym następuje podana liczba bajtów. Odpowiedzi jednego połączenia
+// przychodzą w kolejności zapytań; różne połączenia wykonywane są równolegle.
+// Wiersz "METRICS" zamiast zapytania zwraca liczniki Database::metrics (format Prometheusa).
+class QueryServer {
+public:
+    // Także limit nieprzetworzonych danych od klienta: ponad nim (albo gdy następne zapytanie czeka już
+    // za wykonywanym) połączenie nie jest czytane - reszta zostaje w gnieździe, a klient blokuje się na wysyłaniu
+    static constexpr size_t MAX_QUERY_BYTES = 1 << 20;
+    // Odpowiedzi nieodebrane przez klienta ponad ten rozmiar wstrzymują wykonywanie i czytanie
+    // kolejnych zapytań połączenia, dopóki bufor nie zostanie wysłany
+    static constexpr size_t MAX_PENDING_OUTPUT_BYTES = 4 << 20;
+
+    explicit QueryServer(Database &database);
+
+    ~QueryServer();
+
+    QueryServer(const QueryServer &) = delete;
+
+    QueryServer &operator=(const QueryServer &) = delete;
+
+    // Tworzy gniazdo (istniejący plik gniazda jest usuwany)
+    bool listen(const std::string &socketPath);
+
+    // Pętla zdarzeń; wraca po stop()
+    void run();
+
+    // Może być wołane z innego wątku albo z obsługi sygnału
+    void stop();
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::string input;
+        std::string output;
+        bool busy = false;        // zapytanie wykonywane na puli
+        bool inputClosed = false; // klient zamknął swoją stronę; zamykamy po ostatniej odpowiedzi
+        uint32_t events = 0;      // zdarzenia zarejestrowane w epoll
+
+        bool backedUp() const { return output.size() > MAX_PENDING_OUTPUT_BYTES; }
+
+        bool inputFull() const {
+            return input.size() > MAX_QUERY_BYTES || (busy && input.find('\n') != std::string::npos);
+        }
+    };
+
+    void acceptConnections();
+
+    void readConnection(uint64_t id);
+
+    void dispatchNext(uint64_t id, Connection &connection);
+
+    void flushOutput(uint64_t id, Connection &connection);
+
+    // Aktualizuje zdarzenia epoll połączenia albo zamyka je, gdy nie ma już nic do zrobienia
+    void updateConnection(uint64_t id, Connection &connection);
+
+    void closeConnection(uint64_t id);
+
+    void collectCompletions();
+
+    Database &database;
+    std::string path;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1; // eventfd: zakończone zapytania i stop()
+    std::atomic<bool> stopping{false};
+
+    std::map<uint64_t, Connection> connections;
+    uint64_t nextConnectionId = 2; // 0 i 1 to gniazdo nasłuchujące i eventfd w epoll
+
+    std::mutex completionMutex;
+    std::condition_variable idle;
+    std::vector<std::pair<uint64_t, std::string>> completions;
+    size_t inFlight = 0;
+};
+
+#endif //DATABASE_QUERYSERVER_H
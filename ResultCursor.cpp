@@ -0,0 +1,173 @@
+#include "ResultCursor.h"
+#include "FilterKernels.h"
+#include "Memory.h"
+#include "ThreadPool.h"
+
+ResultCursor::~ResultCursor() {
+    if (table && !materialized) {
+        --table->openCursors;
+    }
+}
+
+bool ResultCursor::validate() {
+    if (table->dropped || table->schemaVersion != schemaVersion) {
+        error = "Table " + table->name + " changed while the cursor was open.\n";
+        return false;
+    }
+    if (table->compactions != compactions) {
+        error = "Table " + table->name + " was compacted while the cursor was idle.\n";
+        return false;
+    }
+    table->lastCursorUse = std::chrono::steady_clock::now().time_since_epoch().count();
+    if (table->dataVersion != dataVersion) {
+        // Kodowanie kolumn (kody słownika) mogło się zmienić - warunek kompilowany od nowa
+        predicate = Predicate::compile(*table, conditions);
+        dataVersion = table->dataVersion;
+        if (!predicate) {
+            error = "Condition on table " + table->name + " can no longer be evaluated.\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+void ResultCursor::collectRows(size_t wanted, std::vector<uint32_t> &rows) {
+    if (useIndex) {
+        while (rows.size() < wanted && nextCandidate < candidates.size()) {
+            uint32_t row = candidates[nextCandidate++];
+            if (!table->isDeleted(row) && predicate->matches(row)) {
+                rows.push_back(row);
+            }
+        }
+        finished = nextCandidate == candidates.size();
+        return;
+    }
+
+    // Fragmenty CHUNK_ROWS wierszy od początku fragmentu zawierającego nextRow; bity przed nextRow
+    // (wydane w poprzednim wywołaniu) są czyszczone
+    Arena &arena = Arena::local();
+    Arena::Scope scope(arena);
+    uint64_t *bits = arena.allocateArray<uint64_t>(CHUNK_ROWS / 64);
+    while (rows.size() < wanted && nextRow < table->rowCount) {
+        size_t firstRow = nextRow / CHUNK_ROWS * CHUNK_ROWS;
+        size_t count = std::min(CHUNK_ROWS, table->rowCount - firstRow);
+        if (!predicate->mayMatch(firstRow, count)) {
+            nextRow = firstRow + count;
+            continue;
+        }
+        size_t words = (count + 63) / 64;
+        predicate->evaluate(firstRow, count, bits);
+        table->maskDeleted(firstRow, count, bits);
+        size_t skipped = nextRow - firstRow;
+        std::fill(bits, bits + skipped / 64, 0);
+        if (skipped % 64 != 0) {
+            bits[skipped / 64] &= ~uint64_t(0) << (skipped % 64);
+        }
+        nextRow = firstRow + count;
+        for (size_t word = skipped / 64; word < words; ++word) {
+            for (uint64_t set = bits[word]; set != 0; set &= set - 1) {
+                if (rows.size() == wanted) {
+                    nextRow = firstRow + (word << 6) + static_cast<size_t>(std::countr_zero(set));
+                    return;
+                }
+                rows.push_back(static_cast<uint32_t>(firstRow + (word << 6) + std::countr_zero(set)));
+            }
+        }
+    }
+    finished = nextRow >= table->rowCount;
+}
+
+ResultSet ResultCursor::next(size_t maxRows) {
+    ResultSet batch;
+    batch.columnNames = columnNames;
+    size_t wanted = std::min(maxRows, remaining);
+    if (!error.empty()) {
+        batch.error = error;
+        return batch;
+    }
+
+    if (materialized) {
+        size_t count = std::min(wanted, result.rowCount() - nextResultRow);
+        std::vector<uint32_t> rows(count);
+        for (size_t i = 0; i < count; ++i) {
+            rows[i] = static_cast<uint32_t>(nextResultRow + i);
+        }
+        for (const auto &column : result.columns) {
+            batch.columns.emplace_back(column.getType());
+            batch.columns.back().appendRows(column, rows.data(), count);
+        }
+        nextResultRow += count;
+        delivered += count;
+        remaining -= remaining == NO_LIMIT ? 0 : count;
+        return batch;
+    }
+
+    std::shared_lock lock(table->mutex);
+    if (!validate()) {
+        batch.error = error;
+        return batch;
+    }
+    std::vector<uint32_t> rows;
+    rows.reserve(std::min(wanted, CHUNK_ROWS));
+    collectRows(wanted, rows);
+    for (size_t i = 0; i < projection.size(); ++i) {
+        batch.columns.emplace_back(types[i]);
+        batch.columns.back().appendRows(table->data[projection[i]], rows.data(), rows.size());
+    }
+    delivered += rows.size();
+    remaining -= remaining == NO_LIMIT ? 0 : rows.size();
+    return batch;
+}
+
+size_t ResultCursor::skip(size_t count) {
+    count = std::min(count, remaining);
+    if (!error.empty() || count == 0) {
+        return 0;
+    }
+    size_t skipped = 0;
+    if (materialized) {
+        skipped = std::min(count, result.rowCount() - nextResultRow);
+        nextResultRow += skipped;
+    } else {
+        // Numery wierszy zbierane porcjami, żeby duży OFFSET nie zajmował pamięci
+        std::shared_lock lock(table->mutex);
+        if (!validate()) {
+            return 0;
+        }
+        std::vector<uint32_t> rows;
+        while (skipped < count && !finished) {
+            rows.clear();
+            collectRows(std::min(count - skipped, CHUNK_ROWS), rows);
+            skipped += rows.size();
+        }
+    }
+    delivered += skipped;
+    remaining -= remaining == NO_LIMIT ? 0 : skipped;
+    return skipped;
+}
+
+ResultSet ResultCursor::fetchAll() {
+    ResultSet all;
+    all.columnNames = columnNames;
+    for (DataType type : types) {
+        all.columns.emplace_back(type);
+    }
+    while (!done()) {
+        ResultSet batch = next(ThreadPool::MORSEL_ROWS);
+        if (!batch.ok()) {
+            all.error = batch.error;
+            break;
+        }
+        for (size_t i = 0; i < batch.columns.size(); ++i) {
+            all.columns[i].appendColumn(batch.columns[i]);
+        }
+    }
+    return all;
+}
+
+bool ResultCursor::done() const {
+    if (!error.empty() || remaining == 0) {
+        return true;
+    }
+    return materialized ? nextResultRow >= result.rowCount() : finished;
+}
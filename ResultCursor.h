@@ -0,0 +1,86 @@
+#ifndef DATABASE_RESULTCURSOR_H
+#define DATABASE_RESULTCURSOR_H
+
+#include "PreRequistion.h"
+#include "Database.h"
+#include "Predicate.h"
+
+// Wynik SELECT pobierany porcjami (Database::openCursor). Zwykły SELECT jest wykonywany leniwie:
+// next() blokuje tabelę tylko na czas sprawdzenia kolejnych fragmentów i kończy, gdy zbierze
+// porcję, więc pierwszy wiersz nie czeka na koniec skanu, a pamięć nie zależy od rozmiaru wyniku.
+// Agregaty, GROUP BY i JOIN są liczone w całości przy otwarciu i tylko wydawane porcjami.
+// Wiersze wstawione w trakcie trafiają do wyniku, jeśli skan do nich jeszcze nie doszedł.
+// Zmiana schematu tabeli unieważnia kursor (błąd); kompakcja czeka na zamknięcie kursorów tabeli, chyba że
+// wszystkie są bezczynne dłużej niż Database::setCursorIdleTimeout - wtedy przepisuje tabelę i je unieważnia.
+class ResultCursor {
+public:
+    static constexpr size_t DEFAULT_BATCH_ROWS = 1024;
+    static constexpr size_t NO_LIMIT = std::numeric_limits<size_t>::max();
+
+    // Fragment tabeli sprawdzany na raz przez next(); wielokrotność 64
+    static constexpr size_t CHUNK_ROWS = 4096;
+
+    ~ResultCursor();
+
+    ResultCursor(const ResultCursor &) = delete;
+
+    ResultCursor &operator=(const ResultCursor &) = delete;
+
+    bool ok() const { return error.empty(); }
+
+    const std::string &getError() const { return error; }
+
+    const std::vector<std::string> &getColumnNames() const { return columnNames; }
+
+    // Kolejne co najwyżej maxRows wierszy; pusty wynik oznacza koniec albo błąd (wtedy też w error)
+    ResultSet next(size_t maxRows = DEFAULT_BATCH_ROWS);
+
+    // Pomija do count wierszy bez ich projekcji; zwraca liczbę pominiętych
+    size_t skip(size_t count);
+
+    // Wszystkie pozostałe wiersze jednym wynikiem
+    ResultSet fetchAll();
+
+    bool done() const;
+
+    // Wiersze już wydane albo pominięte
+    size_t position() const { return delivered; }
+
+private:
+    friend class Database;
+
+    ResultCursor() = default;
+
+    // Numery kolejnych pasujących wierszy (do wanted) dopisywane do rows; tabela zablokowana
+    void collectRows(size_t wanted, std::vector<uint32_t> &rows);
+
+    // Pod blokadą tabeli: false (z błędem), gdy kursor nie może być kontynuowany
+    bool validate();
+
+    std::vector<std::string> columnNames;
+    std::string error;
+    size_t remaining = NO_LIMIT; // LIMIT jeszcze do wydania
+    size_t delivered = 0;
+
+    // Wynik policzony w całości przy otwarciu
+    bool materialized = false;
+    ResultSet result;
+    size_t nextResultRow = 0;
+
+    // Skan wykonywany leniwie
+    std::shared_ptr<Table> table;
+    uint64_t schemaVersion = 0;
+    uint64_t dataVersion = 0;
+    uint64_t compactions = 0;
+    std::vector<Condition> conditions; // do ponownej kompilacji po zmianie danych (kody słownika)
+    std::unique_ptr<Predicate> predicate;
+    std::vector<int> projection;       // Column::index kolejnych kolumn wyniku
+    std::vector<DataType> types;
+    size_t nextRow = 0;                // pierwszy niesprawdzony wiersz skanu
+    bool useIndex = false;
+    std::vector<uint32_t> candidates;  // wiersze z indeksu (warunek równości), rosnąco
+    size_t nextCandidate = 0;
+    bool finished = false;
+};
+
+#endif //DATABASE_RESULTCURSOR_H
@@ -0,0 +1,13 @@
+#include "ResultSet.h"
+
+std::string ResultSet::format() const {
+    std::string out;
+    for (size_t row = 0; row < rowCount(); ++row) {
+        for (const auto &column : columns) {
+            out += column.getAsString(row);
+            out += ' ';
+        }
+        out += '\n';
+    }
+    return out;
+}
@@ -0,0 +1,26 @@
+#ifndef DATABASE_RESULTSET_H
+#define DATABASE_RESULTSET_H
+
+#include "PreRequistion.h"
+#include "ColumnStore.h"
+
+// Wynik zapytania zwracany zamiast wypisywania: kolumny projekcji z typami
+// (ColumnData, wartości dostępne przez getInt/getFloat/getString/isNull) albo komunikat błędu.
+struct ResultSet {
+    std::vector<std::string> columnNames;
+    std::vector<ColumnData> columns;
+    std::string error; // komunikaty błędów zapytania; pusty, gdy się powiodło
+
+    bool ok() const { return error.empty(); }
+
+    size_t rowCount() const { return columns.empty() ? 0 : columns.front().size(); }
+
+    size_t columnCount() const { return columns.size(); }
+
+    DataType columnType(size_t column) const { return columns[column].getType(); }
+
+    // Tekstowa postać jak w selectData: wartości wiersza rozdzielone spacjami, wiersz w linii
+    std::string format() const;
+};
+
+#endif //DATABASE_RESULTSET_H
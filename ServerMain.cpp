@@ -0,0 +1,41 @@
+#include "Database.h"
+#include "QueryServer.h"
+#include <csignal>
+
+namespace {
+    QueryServer *runningServer = nullptr;
+
+    void handleSignal(int) {
+        if (runningServer != nullptr) {
+            runningServer->stop();
+        }
+    }
+}
+
+// Serwer bez GUI: dbserver <gniazdo> [<migawka> <dziennik WAL>]
+int main(int argc, char *argv[]) {
+    if (argc != 2 && argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " <socket> [<snapshot> <wal>]" << std::endl;
+        return 1;
+    }
+    Database database;
+    bool persistent = argc == 4;
+    if (persistent) {
+        database.openStorage(argv[2], argv[3]);
+    }
+
+    QueryServer server(database);
+    if (!server.listen(argv[1])) {
+        return 1;
+    }
+    runningServer = &server;
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+    server.run();
+    runningServer = nullptr;
+
+    if (persistent) {
+        database.checkpoint();
+    }
+    return 0;
+}
@@ -0,0 +1,598 @@
+#include "Snapshot.h"
+#include "BlockCodec.h"
+#include "BufferPool.h"
+#include "Diagnostics.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <cstdio>
+#include <cstddef>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char SNAPSHOT_MAGIC[8] = {'D', 'B', 'S', 'N', 'A', 'P', '\0', '\0'};
+    const uint32_t ENDIAN_MARKER = 0x01020304;
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t endianMarker;
+        uint32_t tableCount;
+        uint32_t reserved;
+        uint64_t fileSize;
+        uint64_t walLsn;
+    };
+
+    struct TableHeader {
+        uint64_t rowCount;
+        uint32_t nameLength;
+        uint32_t columnCount;
+        uint32_t indexCount;
+        uint32_t reserved;
+    };
+
+    struct ColumnHeader {
+        uint64_t nullOffset;
+        uint64_t dataOffset;    // int64[], double[] albo offsety napisów
+        uint64_t lengthsOffset; // tylko STRING
+        uint64_t charsOffset;   // tylko STRING
+        uint64_t charBytes;
+        int32_t index;
+        uint32_t type;
+        uint32_t nameLength;
+        uint32_t defaultLength; // od wersji 6: wartość domyślna zapisana po nazwie kolumny
+    };
+
+    // Od wersji 3, zaraz po ColumnHeader; codeWidth == 0 - kolumna bez słownika
+    struct ColumnEncoding {
+        uint64_t codesOffset;
+        uint64_t dictionarySize;
+        uint32_t codeWidth;
+        uint32_t sortedDictionary;
+    };
+
+    // Od wersji 4, po ColumnEncoding
+    struct ColumnZones {
+        uint64_t zonesOffset;
+        uint64_t zoneCount;
+    };
+
+    // Od wersji 7, po ColumnZones: rozmiary bloków zapisanych przez BlockCodec;
+    // 0 - blok bez kompresji, podpinany wprost z mapowania pliku
+    struct ColumnCompression {
+        uint64_t nullBytes;
+        uint64_t dataBytes;
+        uint64_t lengthsBytes;
+        uint64_t charsBytes;
+        uint64_t codesBytes;
+    };
+
+    // Od wersji 5, zaraz po TableHeader; bitmapWords == 0 - tabela bez usuniętych wierszy
+    struct TableDeletions {
+        uint64_t bitmapOffset;
+        uint64_t bitmapWords;
+        uint64_t deletedCount;
+    };
+
+    struct IndexHeader {
+        int32_t columnIndex;
+        uint32_t type;
+        uint32_t nameLength;
+        uint32_t reserved;
+    };
+
+    uint64_t alignUp(uint64_t offset) {
+        return (offset + Snapshot::SNAPSHOT_ALIGNMENT - 1) & ~uint64_t(Snapshot::SNAPSHOT_ALIGNMENT - 1);
+    }
+
+    // Blok do zapisania pod danym przesunięciem
+    struct Block {
+        uint64_t offset;
+        const void *data;
+        uint64_t size;
+    };
+
+    // Tablica kolumny do zapisu: zakodowana, jeśli to oszczędza co najmniej 1/MIN_SAVING jej rozmiaru
+    struct ColumnBlock {
+        static constexpr uint64_t MIN_SAVING = 8;
+
+        ColumnBlock() = default;
+
+        ColumnBlock(const void *data, size_t count, uint32_t width) : data(data), count(count), width(width) {}
+
+        const void *data = nullptr;
+        size_t count = 0;
+        uint32_t width = 1;
+        std::string encoded;
+
+        uint64_t rawBytes() const { return count * width; }
+
+        bool compressed() const { return encoded.size() <= rawBytes() - rawBytes() / MIN_SAVING; }
+    };
+
+    // Wczytane bloki skompresowane (rozkodowane do pamięci) razem z mapowaniem pliku dla pozostałych
+    struct DecodedBlocks {
+        std::shared_ptr<const PagedFile> file;
+        std::vector<std::unique_ptr<uint64_t[]>> buffers;
+    };
+
+    std::vector<const Column *> columnsByIndex(const Table &table) {
+        std::vector<const Column *> ordered(table.columns.size());
+        for (const auto &col : table.columns) {
+            ordered[col.second.index] = &col.second;
+        }
+        return ordered;
+    }
+
+    // Odczyt nagłówków ze sprawdzaniem granic pliku
+    class Reader {
+    public:
+        Reader(const char *fileData, size_t fileSize) : base(fileData), size(fileSize) {}
+
+        template<typename T>
+        bool read(T &value) {
+            if (position + sizeof(T) > size) {
+                return false;
+            }
+            std::memcpy(&value, base + position, sizeof(T));
+            position += sizeof(T);
+            return true;
+        }
+
+        bool readString(uint32_t length, std::string &value) {
+            if (position + length > size) {
+                return false;
+            }
+            value.assign(base + position, length);
+            position += length;
+            return true;
+        }
+
+    private:
+        const char *base;
+        size_t size;
+        size_t position = 0;
+    };
+
+    bool validBlock(uint64_t offset, uint64_t bytes, size_t fileSize) {
+        return offset % Snapshot::SNAPSHOT_ALIGNMENT == 0 && offset <= fileSize && bytes <= fileSize - offset;
+    }
+
+    // Zapis pliku na dysk przed podmianą migawki. Katalog (nowy wpis po rename) tylko na POSIX -
+    // na Windows podmianę zapisuje MOVEFILE_WRITE_THROUGH w MappedFile::replace
+    bool syncToDisk(const std::string &path, bool directory) {
+#ifdef _WIN32
+        if (directory) {
+            return true;
+        }
+        int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+        if (fd < 0) {
+            return false;
+        }
+        bool synced = _commit(fd) == 0;
+        _close(fd);
+        return synced;
+#else
+        int fd = ::open(path.c_str(), directory ? O_RDONLY | O_DIRECTORY : O_RDWR);
+        if (fd < 0) {
+            return false;
+        }
+        bool synced = fsync(fd) == 0;
+        ::close(fd);
+        return synced;
+#endif
+    }
+}
+
+bool Snapshot::save(const TableCatalog &tables, const std::string &fileName, uint64_t walLsn) {
+    // Pierwsze przejście: rozmiar nagłówków
+    uint64_t headerBytes = sizeof(FileHeader);
+    for (const auto &table : tables) {
+        headerBytes += sizeof(TableHeader) + sizeof(TableDeletions) + table.first.size();
+        for (const auto &col : table.second->columns) {
+            headerBytes += sizeof(ColumnHeader) + sizeof(ColumnEncoding) + sizeof(ColumnZones)
+                           + sizeof(ColumnCompression) + col.first.size() + col.second.defaultValue.size();
+        }
+        for (const auto &index : table.second->indexes) {
+            headerBytes += sizeof(IndexHeader) + index->getName().size();
+        }
+    }
+
+    // Kompresja tablic kolumn - równolegle, bo od rozmiarów zależą przesunięcia w nagłówkach.
+    // Z limitem pamięci (BufferPool) bloki zostają niekompresowane: rozkodowany blok siedziałby
+    // w pamięci w całości, a zmapowany można zwalniać stronami
+    bool compress = BufferPool::shared().capacity() == 0;
+    enum {
+        NULLS, DATA, LENGTHS, CHARS, CODES, ARRAY_COUNT
+    };
+    std::vector<std::array<ColumnBlock, ARRAY_COUNT>> columnBlocks;
+    for (const auto &entry : tables) {
+        const Table &table = *entry.second;
+        for (const Column *col : columnsByIndex(table)) {
+            const ColumnArrays &arrays = table.data[col->index].arrays();
+            auto &column = columnBlocks.emplace_back();
+            column[NULLS] = {arrays.nulls, (table.rowCount + 63) / 64, sizeof(uint64_t)};
+            switch (col->type) {
+                case DataType::INT:
+                    column[DATA] = {arrays.ints, table.rowCount, sizeof(int64_t)};
+                    break;
+                case DataType::FLOAT:
+                    column[DATA] = {arrays.floats, table.rowCount, sizeof(double)};
+                    break;
+                case DataType::STRING: {
+                    size_t entries = arrays.codes ? arrays.dictionarySize : table.rowCount;
+                    column[DATA] = {arrays.stringOffsets, entries, sizeof(uint64_t)};
+                    column[LENGTHS] = {arrays.stringLengths, entries, sizeof(uint32_t)};
+                    column[CHARS] = {arrays.chars, arrays.charBytes, 1};
+                    if (arrays.codes) {
+                        column[CODES] = {arrays.codes, table.rowCount, arrays.codeWidth};
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    ThreadPool::shared().parallelFor(columnBlocks.size() * ARRAY_COUNT, [&columnBlocks, compress](size_t i, unsigned) {
+        ColumnBlock &block = columnBlocks[i / ARRAY_COUNT][i % ARRAY_COUNT];
+        if (!compress || block.count == 0) {
+            return;
+        }
+        block.encoded = i % ARRAY_COUNT == CHARS
+                        ? BlockCodec::encodeBytes(static_cast<const char *>(block.data), block.count)
+                        : BlockCodec::encodeValues(block.data, block.count, block.width);
+        if (!block.compressed()) {
+            block.encoded = std::string();
+        }
+    });
+
+    // Drugie przejście: rozmieszczenie bloków kolumn
+    std::string headers;
+    headers.reserve(headerBytes);
+    std::vector<Block> blocks;
+    uint64_t offset = alignUp(headerBytes);
+    auto placeBlock = [&](const void *data, uint64_t size) {
+        uint64_t blockOffset = offset;
+        blocks.push_back({blockOffset, data, size});
+        offset = alignUp(offset + size);
+        return blockOffset;
+    };
+    // Zwraca przesunięcie bloku, storedBytes: rozmiar po kompresji albo 0
+    auto placeColumnBlock = [&](const ColumnBlock &block, uint64_t &storedBytes) {
+        if (block.count == 0 || block.encoded.empty()) {
+            storedBytes = 0;
+            return placeBlock(block.data, block.rawBytes());
+        }
+        storedBytes = block.encoded.size();
+        return placeBlock(block.encoded.data(), storedBytes);
+    };
+    auto appendRaw = [&headers](const void *data, size_t size) {
+        headers.append(static_cast<const char *>(data), size);
+    };
+
+    FileHeader fileHeader{};
+    std::memcpy(fileHeader.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    fileHeader.version = VERSION;
+    fileHeader.endianMarker = ENDIAN_MARKER;
+    fileHeader.tableCount = static_cast<uint32_t>(tables.size());
+    fileHeader.walLsn = walLsn;
+    appendRaw(&fileHeader, sizeof(fileHeader));
+
+    size_t columnNumber = 0;
+    for (const auto &entry : tables) {
+        const Table &table = *entry.second;
+        TableHeader tableHeader{};
+        tableHeader.rowCount = table.rowCount;
+        tableHeader.nameLength = static_cast<uint32_t>(entry.first.size());
+        tableHeader.columnCount = static_cast<uint32_t>(table.columns.size());
+        tableHeader.indexCount = static_cast<uint32_t>(table.indexes.size());
+        TableDeletions deletions{};
+        if (table.deletedCount > 0) {
+            deletions.bitmapWords = table.deleted.size();
+            deletions.deletedCount = table.deletedCount;
+            deletions.bitmapOffset = placeBlock(table.deleted.data(), table.deleted.size() * sizeof(uint64_t));
+        }
+        appendRaw(&tableHeader, sizeof(tableHeader));
+        appendRaw(&deletions, sizeof(deletions));
+        headers += entry.first;
+
+        for (const Column *col : columnsByIndex(table)) {
+            // Bufor znaków zapisywany w całości (z ewentualnymi nadpisanymi napisami),
+            // bo przesunięcia wskazują do niego wprost
+            const ColumnData &column = table.data[col->index];
+            const ColumnArrays &arrays = column.arrays();
+            const auto &columnArrays = columnBlocks[columnNumber++];
+
+            ColumnHeader columnHeader{};
+            ColumnEncoding encoding{};
+            ColumnZones zones{};
+            ColumnCompression compression{};
+            columnHeader.index = col->index;
+            columnHeader.type = static_cast<uint32_t>(col->type);
+            columnHeader.nameLength = static_cast<uint32_t>(col->name.size());
+            columnHeader.defaultLength = static_cast<uint32_t>(col->defaultValue.size());
+            columnHeader.nullOffset = placeColumnBlock(columnArrays[NULLS], compression.nullBytes);
+            columnHeader.dataOffset = placeColumnBlock(columnArrays[DATA], compression.dataBytes);
+            switch (col->type) {
+                case DataType::INT:
+                case DataType::FLOAT:
+                    break;
+                case DataType::STRING: {
+                    columnHeader.lengthsOffset = placeColumnBlock(columnArrays[LENGTHS], compression.lengthsBytes);
+                    columnHeader.charsOffset = placeColumnBlock(columnArrays[CHARS], compression.charsBytes);
+                    columnHeader.charBytes = arrays.charBytes;
+                    if (arrays.codes) {
+                        encoding.codesOffset = placeColumnBlock(columnArrays[CODES], compression.codesBytes);
+                        encoding.dictionarySize = arrays.dictionarySize;
+                        encoding.codeWidth = arrays.codeWidth;
+                        encoding.sortedDictionary = arrays.sortedDictionary;
+                    }
+                    break;
+                }
+            }
+            const std::vector<ColumnZone> &zoneMaps = column.zoneMaps();
+            zones.zoneCount = zoneMaps.size();
+            zones.zonesOffset = placeBlock(zoneMaps.data(), zoneMaps.size() * sizeof(ColumnZone));
+            appendRaw(&columnHeader, sizeof(columnHeader));
+            appendRaw(&encoding, sizeof(encoding));
+            appendRaw(&zones, sizeof(zones));
+            appendRaw(&compression, sizeof(compression));
+            headers += col->name;
+            headers += col->defaultValue;
+        }
+
+        for (const auto &index : table.indexes) {
+            IndexHeader indexHeader{};
+            indexHeader.columnIndex = index->getColumnIndex();
+            indexHeader.type = static_cast<uint32_t>(index->getType());
+            indexHeader.nameLength = static_cast<uint32_t>(index->getName().size());
+            appendRaw(&indexHeader, sizeof(indexHeader));
+            headers += index->getName();
+        }
+    }
+    uint64_t fileSize = offset;
+    std::memcpy(headers.data() + offsetof(FileHeader, fileSize), &fileSize, sizeof(fileSize));
+
+    // Zapis do pliku tymczasowego: nagłówki sekwencyjnie, bloki kolumn równolegle na wspólnej
+    // puli - każdy wątek przez własny strumień ustawiany na przesunięcie bloku. Podmiana na końcu,
+    // żeby nie naruszyć migawki, która może być właśnie zmapowana
+    std::string tempName = fileName + ".tmp";
+    std::ofstream outputFile(tempName, std::ios::binary | std::ios::trunc);
+    if (!outputFile) {
+        errorStream() << "Failed to open file: " << tempName << std::endl;
+        return false;
+    }
+    outputFile.write(headers.data(), static_cast<std::streamsize>(headers.size()));
+    if (fileSize > headers.size()) {
+        outputFile.seekp(static_cast<std::streamoff>(fileSize - 1));
+        outputFile.put('\0');
+    }
+    outputFile.close();
+
+    ThreadPool &pool = ThreadPool::shared();
+    std::vector<std::unique_ptr<std::ofstream>> streams(pool.concurrency());
+    std::atomic<bool> failed{!outputFile};
+    pool.parallelFor(blocks.size(), [&](size_t i, unsigned lane) {
+        const Block &block = blocks[i];
+        if (block.size == 0 || failed) {
+            return;
+        }
+        auto &stream = streams[lane];
+        if (!stream) {
+            stream = std::make_unique<std::ofstream>(tempName, std::ios::binary | std::ios::in | std::ios::out);
+        }
+        stream->seekp(static_cast<std::streamoff>(block.offset));
+        stream->write(static_cast<const char *>(block.data), static_cast<std::streamsize>(block.size));
+        if (!*stream) {
+            failed = true;
+        }
+    });
+    for (auto &stream : streams) {
+        if (stream) {
+            stream->close();
+            failed = failed || !*stream;
+        }
+    }
+    // Plik na dysku przed podmianą, a podmiana (wpis w katalogu) przed powrotem - dopiero wtedy checkpoint
+    // może wyczyścić dziennik; inaczej awaria zaraz po nim gubi potwierdzone zmiany
+    if (failed || !syncToDisk(tempName, false)) {
+        errorStream() << "Failed to write file: " << tempName << std::endl;
+        std::remove(tempName.c_str());
+        return false;
+    }
+    if (!MappedFile::replace(tempName, fileName)) {
+        errorStream() << "Failed to replace file: " << fileName << std::endl;
+        return false;
+    }
+    std::filesystem::path directory = std::filesystem::path(fileName).parent_path();
+    if (!syncToDisk(directory.empty() ? "." : directory.string(), true)) {
+        errorStream() << "Failed to sync directory of file: " << fileName << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Snapshot::load(const std::string &fileName, TableCatalog &tables, uint64_t &walLsn, bool buildIndexes) {
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(fileName)) {
+        errorStream() << "Failed to open file: " << fileName << std::endl;
+        return false;
+    }
+
+    Reader reader(file->data(), file->size());
+    FileHeader fileHeader{};
+    if (!reader.read(fileHeader) || std::memcmp(fileHeader.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        errorStream() << "File " << fileName << " is not a database snapshot." << std::endl;
+        return false;
+    }
+    if (fileHeader.version < MIN_VERSION || fileHeader.version > VERSION || fileHeader.endianMarker != ENDIAN_MARKER) {
+        errorStream() << "Unsupported snapshot version " << fileHeader.version << " in " << fileName << "." << std::endl;
+        return false;
+    }
+    if (fileHeader.fileSize != file->size()) {
+        errorStream() << "Snapshot " << fileName << " is truncated." << std::endl;
+        return false;
+    }
+
+    std::shared_ptr<PagedFile> paged = BufferPool::shared().registerFile(file);
+    TableCatalog loaded;
+    std::vector<std::pair<const Table *, TableIndex *>> pendingIndexes;
+    for (uint32_t tableNumber = 0; tableNumber < fileHeader.tableCount; ++tableNumber) {
+        TableHeader tableHeader{};
+        TableDeletions deletions{};
+        std::string tableName;
+        if (!reader.read(tableHeader) || (fileHeader.version >= 5 && !reader.read(deletions))
+            || !reader.readString(tableHeader.nameLength, tableName)
+            || deletions.bitmapWords > (tableHeader.rowCount + 63) / 64
+            || (deletions.bitmapWords > 0 && !validBlock(deletions.bitmapOffset, deletions.bitmapWords * sizeof(uint64_t),
+                                                         file->size()))) {
+            errorStream() << "Corrupted snapshot " << fileName << "." << std::endl;
+            return false;
+        }
+        auto &entry = loaded[tableName];
+        entry = std::make_shared<Table>();
+        Table &table = *entry;
+        table.name = tableName;
+        table.rowCount = tableHeader.rowCount;
+        table.data.resize(tableHeader.columnCount);
+        if (deletions.bitmapWords > 0) {
+            // Mała bitmapa zmieniana przy każdym DELETE - kopia zamiast widoku na plik
+            table.deleted.resize(deletions.bitmapWords);
+            std::memcpy(table.deleted.data(), file->data() + deletions.bitmapOffset, deletions.bitmapWords * sizeof(uint64_t));
+            table.deletedCount = deletions.deletedCount;
+        }
+
+        for (uint32_t columnNumber = 0; columnNumber < tableHeader.columnCount; ++columnNumber) {
+            ColumnHeader columnHeader{};
+            ColumnEncoding encoding{};
+            ColumnZones zones{};
+            ColumnCompression compression{};
+            std::string columnName;
+            std::string defaultValue;
+            if (!reader.read(columnHeader) || (fileHeader.version >= 3 && !reader.read(encoding))
+                || (fileHeader.version >= 4 && !reader.read(zones))
+                || (fileHeader.version >= 7 && !reader.read(compression))
+                || !reader.readString(columnHeader.nameLength, columnName)
+                || (fileHeader.version >= 6 && !reader.readString(columnHeader.defaultLength, defaultValue))
+                || columnHeader.index < 0 || columnHeader.index >= static_cast<int32_t>(tableHeader.columnCount)
+                || columnHeader.type > static_cast<uint32_t>(DataType::STRING)) {
+                errorStream() << "Corrupted snapshot " << fileName << "." << std::endl;
+                return false;
+            }
+            auto type = static_cast<DataType>(columnHeader.type);
+            uint64_t rows = tableHeader.rowCount;
+
+            // Wskaźniki prosto do zmapowanego pliku, bloki skompresowane rozkodowane do pamięci
+            // utrzymywanej razem z mapowaniem; nullptr - blok poza plikiem albo uszkodzony
+            const char *base = file->data();
+            std::shared_ptr<DecodedBlocks> decoded;
+            auto loadBlock = [&](uint64_t offset, uint64_t count, uint32_t width, uint64_t storedBytes) -> const char * {
+                if (storedBytes == 0) {
+                    return validBlock(offset, count * width, file->size()) ? base + offset : nullptr;
+                }
+                if (!validBlock(offset, storedBytes, file->size())) {
+                    return nullptr;
+                }
+                if (!decoded) {
+                    decoded = std::make_shared<DecodedBlocks>();
+                    decoded->file = paged;
+                }
+                auto &buffer = decoded->buffers.emplace_back(new uint64_t[(count * width + 7) / 8 + 1]);
+                bool ok = BlockCodec::decode(base + offset, storedBytes, buffer.get(), count, width);
+                return ok ? reinterpret_cast<const char *>(buffer.get()) : nullptr;
+            };
+
+            ColumnArrays arrays;
+            arrays.pages = paged.get();
+            arrays.nulls = reinterpret_cast<const uint64_t *>(
+                    loadBlock(columnHeader.nullOffset, (rows + 63) / 64, sizeof(uint64_t), compression.nullBytes));
+            bool valid = arrays.nulls != nullptr;
+            switch (type) {
+                case DataType::INT:
+                    arrays.ints = reinterpret_cast<const int64_t *>(
+                            loadBlock(columnHeader.dataOffset, rows, sizeof(int64_t), compression.dataBytes));
+                    valid = valid && arrays.ints != nullptr;
+                    break;
+                case DataType::FLOAT:
+                    arrays.floats = reinterpret_cast<const double *>(
+                            loadBlock(columnHeader.dataOffset, rows, sizeof(double), compression.dataBytes));
+                    valid = valid && arrays.floats != nullptr;
+                    break;
+                case DataType::STRING: {
+                    uint64_t entries = encoding.codeWidth != 0 ? encoding.dictionarySize : rows;
+                    arrays.stringOffsets = reinterpret_cast<const uint64_t *>(
+                            loadBlock(columnHeader.dataOffset, entries, sizeof(uint64_t), compression.dataBytes));
+                    arrays.stringLengths = reinterpret_cast<const uint32_t *>(
+                            loadBlock(columnHeader.lengthsOffset, entries, sizeof(uint32_t), compression.lengthsBytes));
+                    arrays.chars = loadBlock(columnHeader.charsOffset, columnHeader.charBytes, 1, compression.charsBytes);
+                    arrays.charBytes = columnHeader.charBytes;
+                    valid = valid && arrays.stringOffsets && arrays.stringLengths && arrays.chars;
+                    if (encoding.codeWidth != 0) {
+                        valid = valid && (encoding.codeWidth == 1 || encoding.codeWidth == 2 || encoding.codeWidth == 4);
+                        arrays.codes = reinterpret_cast<const uint8_t *>(
+                                loadBlock(encoding.codesOffset, rows, encoding.codeWidth, compression.codesBytes));
+                        valid = valid && arrays.codes != nullptr;
+                        arrays.codeWidth = encoding.codeWidth;
+                        arrays.dictionarySize = encoding.dictionarySize;
+                        arrays.sortedDictionary = encoding.sortedDictionary != 0;
+                    }
+                    break;
+                }
+            }
+            if (!valid) {
+                errorStream() << "Corrupted column " << columnName << " in snapshot " << fileName << "." << std::endl;
+                return false;
+            }
+
+            std::vector<ColumnZone> zoneMaps;
+            if (zones.zoneCount > 0 && zones.zoneCount == (rows + ColumnData::ZONE_ROWS - 1) / ColumnData::ZONE_ROWS
+                && validBlock(zones.zonesOffset, zones.zoneCount * sizeof(ColumnZone), file->size())) {
+                zoneMaps.resize(zones.zoneCount);
+                std::memcpy(zoneMaps.data(), base + zones.zonesOffset, zones.zoneCount * sizeof(ColumnZone));
+            }
+
+            Column &column = table.columns[columnName];
+            column = Column{columnName, type, columnHeader.index};
+            column.defaultValue = std::move(defaultValue);
+            table.data[columnHeader.index] = ColumnData(type);
+            std::shared_ptr<const void> owner = decoded ? std::shared_ptr<const void>(decoded) : paged;
+            table.data[columnHeader.index].attach(std::move(owner), rows, arrays, std::move(zoneMaps));
+        }
+
+        // Indeksy nie są zapisywane, tylko ich definicje - odbudowa z danych
+        for (uint32_t indexNumber = 0; indexNumber < tableHeader.indexCount; ++indexNumber) {
+            IndexHeader indexHeader{};
+            std::string indexName;
+            if (!reader.read(indexHeader) || !reader.readString(indexHeader.nameLength, indexName)
+                || indexHeader.columnIndex < 0 || indexHeader.columnIndex >= static_cast<int32_t>(tableHeader.columnCount)
+                || indexHeader.type > static_cast<uint32_t>(IndexType::BTREE)) {
+                errorStream() << "Corrupted snapshot " << fileName << "." << std::endl;
+                return false;
+            }
+            const ColumnData &column = table.data[indexHeader.columnIndex];
+            table.indexes.push_back(createTableIndex(indexName, static_cast<IndexType>(indexHeader.type),
+                                                     indexHeader.columnIndex, column.getType()));
+            if (buildIndexes) {
+                pendingIndexes.emplace_back(&table, table.indexes.back().get());
+            }
+        }
+    }
+
+    // Odbudowa wszystkich indeksów równolegle
+    ThreadPool::shared().parallelFor(pendingIndexes.size(), [&pendingIndexes](size_t i, unsigned) {
+        const Table &table = *pendingIndexes[i].first;
+        TableIndex &index = *pendingIndexes[i].second;
+        index.build(table.data[index.getColumnIndex()], table.rowCount);
+        table.eraseDeleted(index);
+    });
+
+    tables = std::move(loaded);
+    walLsn = fileHeader.walLsn;
+    return true;
+}
@@ -0,0 +1,36 @@
+#ifndef DATABASE_SNAPSHOT_H
+#define DATABASE_SNAPSHOT_H
+
+#include "PreRequistion.h"
+#include "Database.h"
+
+// Binarna migawka bazy (wersja 7, little-endian; wczytywane są też wersje 2-6).
+//
+//   FileHeader
+//   dla każdej tabeli: TableHeader, TableDeletions, nazwa,
+//   ColumnHeader + ColumnEncoding + ColumnZones + ColumnCompression + nazwa + wartość domyślna (x kolumny), IndexHeader + nazwa (x indeksy)
+//   bloki kolumn, każdy wyrównany do SNAPSHOT_ALIGNMENT bajtów:
+//     bitmapa NULL-i, potem int64[] / double[] / (uint64 offsety, uint32 długości, znaki)
+//     STRING ze słownikiem: offsety, długości i znaki wpisów słownika oraz kody wierszy
+//     statystyki bloków kolumny (ColumnZone[]); bez nich - starsze wersje - liczone przy wczytaniu
+//   bitmapa usuniętych wierszy tabeli (jeśli są), wierszy nie usuwa dopiero kompaktowanie
+//
+// Nagłówki kolumn zawierają bezwzględne przesunięcia bloków w pliku, więc wczytanie to
+// tylko mmap i podpięcie wskaźników - bez parsowania wartości. Od wersji 7 tablice kolumn,
+// które dobrze się kompresują (BlockCodec: RLE, FOR, DELTA, LZ), zapisywane są zakodowane
+// i rozkodowywane przy wczytaniu; pozostałe nadal czytane wprost z mapowania.
+class Snapshot {
+public:
+    static constexpr uint32_t VERSION = 7;
+    static constexpr uint32_t MIN_VERSION = 2;
+    static constexpr size_t SNAPSHOT_ALIGNMENT = 64;
+
+    // walLsn: ostatni rekord dziennika WAL zawarty w migawce.
+    // Zapis tylko czyta tabele - wywołujący trzyma ich blokady współdzielone.
+    static bool save(const TableCatalog &tables, const std::string &fileName, uint64_t walLsn = 0);
+
+    // buildIndexes == false: same dane kolumn, indeksy bez odbudowy (np. do podmiany danych tabel)
+    static bool load(const std::string &fileName, TableCatalog &tables, uint64_t &walLsn, bool buildIndexes = true);
+};
+
+#endif //DATABASE_SNAPSHOT_H
@@ -0,0 +1,445 @@
+#include "Sorting.h"
+#include "Diagnostics.h"
+#include "SpillFiles.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+
+namespace {
+    using Entry = RowSorter::Entry;
+
+    constexpr uint64_t SIGN_BIT = uint64_t(1) << 63;
+
+    uint64_t intKey(int64_t value) {
+        return static_cast<uint64_t>(value) ^ SIGN_BIT;
+    }
+
+    // Ujemne liczby mają odwrócone wszystkie bity, dodatnie tylko bit znaku; -0 równe 0, NaN za +inf
+    uint64_t floatKey(double value) {
+        uint64_t bits;
+        if (std::isnan(value)) {
+            bits = 0x7FF8000000000000ULL;
+        } else {
+            value = value == 0.0 ? 0.0 : value;
+            std::memcpy(&bits, &value, sizeof(bits));
+        }
+        return (bits & SIGN_BIT) ? ~bits : bits | SIGN_BIT;
+    }
+
+    // Pierwsze 8 bajtów napisu big-endian, krótsze dopełnione zerami
+    uint64_t stringKey(std::string_view value) {
+        uint64_t key = 0;
+        size_t length = std::min<size_t>(value.size(), 8);
+        for (size_t i = 0; i < length; ++i) {
+            key |= uint64_t(static_cast<uint8_t>(value[i])) << (56 - 8 * i);
+        }
+        return key;
+    }
+
+    // Kierunek i NULL zapisane we wpisie, żeby porównanie (rank, prefix) nie zależało od klucza
+    void orient(Entry &entry, bool null, bool descending) {
+        if (null) {
+            entry.prefix = 0;
+            entry.rank = descending ? 0 : 1;
+        } else if (descending) {
+            entry.prefix = ~entry.prefix;
+            entry.rank = 1;
+        } else {
+            entry.rank = 0;
+        }
+    }
+
+    // Porządek samych prefiksów; równe prefiksy rozstrzyga dopiero RowSorter::less
+    bool headBefore(const Entry &a, const Entry &b) {
+        return a.rank != b.rank ? a.rank < b.rank : a.prefix < b.prefix;
+    }
+
+    bool sortedCodes(const ColumnData &column) {
+        return column.isDictionaryEncoded() && column.arrays().sortedDictionary;
+    }
+}
+
+RowSorter::RowSorter(std::vector<SortKey> sortKeys, const SortOptions &options)
+        : keys(std::move(sortKeys)), options(options) {
+    for (const SortKey &key : keys) {
+        if (std::find(columns.begin(), columns.end(), key.column) == columns.end()) {
+            columns.push_back(key.column);
+        }
+    }
+    const ColumnData &first = *keys.front().column;
+    exactPrefix = first.getType() != DataType::STRING || sortedCodes(first);
+}
+
+bool RowSorter::sort(std::vector<uint32_t> &rows, size_t keep) {
+    topN = false;
+    runs = 0;
+    skipped = 0;
+    keep = std::min(keep, rows.size());
+    if (keep == 0) {
+        rows.clear();
+        return true;
+    }
+    if (prefersTopN(keep, rows.size())) {
+        sortTopN(rows, keep);
+        return true;
+    }
+    size_t runEntries = std::max(options.memoryBudget / sizeof(Entry), ThreadPool::MORSEL_ROWS);
+    if (rows.size() > runEntries) {
+        return sortSpilled(rows, keep, runEntries);
+    }
+    std::vector<Entry> entries = makeEntries(rows.data(), rows.size());
+    sortEntries(entries);
+    rows.resize(keep);
+    for (size_t i = 0; i < keep; ++i) {
+        rows[i] = entries[i].row;
+    }
+    return true;
+}
+
+RowSorter::Entry RowSorter::makeEntry(uint32_t row) const {
+    const SortKey &key = keys.front();
+    const ColumnData &column = *key.column;
+    Entry entry{0, row, 0};
+    bool null = column.isNull(row);
+    if (!null) {
+        switch (column.getType()) {
+            case DataType::INT:
+                entry.prefix = intKey(column.getInt(row));
+                break;
+            case DataType::FLOAT:
+                entry.prefix = floatKey(column.getFloat(row));
+                break;
+            case DataType::STRING:
+                entry.prefix = sortedCodes(column) ? column.codeAt(row) : stringKey(column.getString(row));
+                break;
+        }
+    }
+    orient(entry, null, key.descending);
+    return entry;
+}
+
+bool RowSorter::zoneBound(size_t zone, Entry &bound) const {
+    const SortKey &key = keys.front();
+    const ColumnData &column = *key.column;
+    if (zone >= column.zoneMaps().size()) {
+        return false;
+    }
+    const ColumnZone &stats = column.zoneMaps()[zone];
+    bool hasValues;
+    uint64_t low;
+    uint64_t high;
+    if (column.getType() == DataType::INT) {
+        hasValues = stats.minInt <= stats.maxInt;
+        low = intKey(stats.minInt);
+        high = intKey(stats.maxInt);
+    } else if (column.getType() == DataType::FLOAT) {
+        hasValues = stats.minFloat <= stats.maxFloat;
+        low = floatKey(stats.minFloat);
+        high = floatKey(stats.maxFloat);
+        if (stats.nanCount > 0) {
+            high = floatKey(std::numeric_limits<double>::quiet_NaN());
+            low = hasValues ? low : high;
+            hasValues = true;
+        }
+    } else {
+        return false;
+    }
+
+    // Najlepsza wartość bloku: minimum przy ASC, przy DESC NULL albo maksimum
+    bool null = key.descending ? stats.nullCount > 0 : !hasValues;
+    if ((null && stats.nullCount == 0) || (!null && !hasValues)) {
+        return false;
+    }
+    bound = {key.descending ? high : low, 0, 0};
+    orient(bound, null, key.descending);
+    return true;
+}
+
+bool RowSorter::less(const Entry &a, const Entry &b) const {
+    if (a.rank != b.rank) {
+        return a.rank < b.rank;
+    }
+    if (a.prefix != b.prefix) {
+        return a.prefix < b.prefix;
+    }
+    int result = exactPrefix ? 0 : compareKey(keys.front(), a.row, b.row);
+    for (size_t i = 1; result == 0 && i < keys.size(); ++i) {
+        result = compareKey(keys[i], a.row, b.row);
+    }
+    return result != 0 ? result < 0 : a.row < b.row;
+}
+
+int RowSorter::compareKey(const SortKey &key, uint32_t a, uint32_t b) const {
+    const ColumnData &column = *key.column;
+    bool nullA = column.isNull(a);
+    bool nullB = column.isNull(b);
+    int result;
+    if (nullA || nullB) {
+        result = nullA == nullB ? 0 : (nullA ? 1 : -1);
+    } else {
+        switch (column.getType()) {
+            case DataType::INT: {
+                int64_t x = column.getInt(a);
+                int64_t y = column.getInt(b);
+                result = x < y ? -1 : (x > y ? 1 : 0);
+                break;
+            }
+            case DataType::FLOAT: {
+                uint64_t x = floatKey(column.getFloat(a));
+                uint64_t y = floatKey(column.getFloat(b));
+                result = x < y ? -1 : (x > y ? 1 : 0);
+                break;
+            }
+            default:
+                if (sortedCodes(column)) {
+                    uint32_t x = column.codeAt(a);
+                    uint32_t y = column.codeAt(b);
+                    result = x < y ? -1 : (x > y ? 1 : 0);
+                } else {
+                    int order = column.getString(a).compare(column.getString(b));
+                    result = order < 0 ? -1 : (order > 0 ? 1 : 0);
+                }
+                break;
+        }
+    }
+    return key.descending ? -result : result;
+}
+
+std::vector<RowSorter::Entry> RowSorter::makeEntries(const uint32_t *rows, size_t count) const {
+    std::vector<Entry> entries(count);
+    unsigned concurrency = ThreadPool::shared().concurrency();
+    ThreadPool::shared().forEachMorsel(count, [&](size_t, size_t first, size_t part, unsigned) {
+        size_t firstRow = rows[first];
+        size_t span = rows[first + part - 1] + size_t(1) - firstRow;
+        PageGuard pages;
+        pinScanMorsel(columns, firstRow, span, firstRow + span * concurrency, pages);
+        for (size_t i = first; i < first + part; ++i) {
+            entries[i] = makeEntry(rows[i]);
+        }
+    });
+    return entries;
+}
+
+void RowSorter::sortEntries(std::vector<Entry> &entries) const {
+    ThreadPool &pool = ThreadPool::shared();
+    auto before = [this](const Entry &a, const Entry &b) { return less(a, b); };
+    size_t count = entries.size();
+    pool.forEachMorsel(count, [&](size_t, size_t first, size_t part, unsigned) {
+        std::sort(entries.begin() + first, entries.begin() + first + part, before);
+    });
+
+    // Scalanie parami posortowanych odcinków; gdy par jest mniej niż wątków, każde scalenie dzielone
+    // jest na części wzdłuż ścieżki scalania (merge path) - część k zaczyna się w k-tym elemencie wyniku
+    std::vector<Entry> merged(count > ThreadPool::MORSEL_ROWS ? count : 0);
+    for (size_t width = ThreadPool::MORSEL_ROWS; width < count; width *= 2) {
+        size_t pairs = (count + 2 * width - 1) / (2 * width);
+        size_t pieces = std::max<size_t>(1, pool.concurrency() / pairs);
+        pool.parallelFor(pairs * pieces, [&](size_t task, unsigned) {
+            size_t first = task / pieces * 2 * width;
+            size_t piece = task % pieces;
+            const Entry *a = entries.data() + first;
+            size_t aCount = std::min(width, count - first);
+            const Entry *b = a + aCount;
+            size_t bCount = std::min(width, count - first - aCount);
+            // Ile elementów z a jest wśród pierwszych k elementów wyniku
+            auto split = [&](size_t k) {
+                size_t low = k > bCount ? k - bCount : 0;
+                size_t high = std::min(k, aCount);
+                while (low < high) {
+                    size_t i = (low + high) / 2;
+                    if (less(b[k - i - 1], a[i])) {
+                        high = i;
+                    } else {
+                        low = i + 1;
+                    }
+                }
+                return low;
+            };
+            size_t begin = (aCount + bCount) * piece / pieces;
+            size_t end = (aCount + bCount) * (piece + 1) / pieces;
+            size_t aBegin = split(begin);
+            size_t aEnd = split(end);
+            std::merge(a + aBegin, a + aEnd, b + (begin - aBegin), b + (end - aEnd), merged.data() + first + begin,
+                       before);
+        });
+        entries.swap(merged);
+    }
+}
+
+void RowSorter::sortTopN(std::vector<uint32_t> &rows, size_t keep) {
+    // Odcinki wierszy jednego bloku zone map pierwszego klucza; bez statystyk (STRING) - morsele
+    std::vector<Segment> segments;
+    bool zoned = keys.front().column->getType() != DataType::STRING && !keys.front().column->zoneMaps().empty();
+    for (size_t first = 0; first < rows.size();) {
+        Segment segment{first, 0, {}, false};
+        size_t last = std::min(rows.size(), first + ThreadPool::MORSEL_ROWS);
+        if (zoned) {
+            size_t zone = rows[first] / ColumnData::ZONE_ROWS;
+            size_t zoneEnd = (zone + 1) * ColumnData::ZONE_ROWS;
+            last = std::lower_bound(rows.begin() + first, rows.end(), zoneEnd) - rows.begin();
+            last = std::max(last, first + 1);
+            segment.bounded = zoneBound(zone, segment.bound);
+        }
+        segment.count = last - first;
+        segments.push_back(segment);
+        first = last;
+    }
+    rows = topSegments(segments, keep, [&rows](size_t first, size_t count, std::vector<uint32_t> &selected) {
+        selected.assign(rows.begin() + first, rows.begin() + first + count);
+    });
+}
+
+std::vector<uint32_t> RowSorter::topScan(size_t rowCount, size_t keep, const SegmentRows &selectRows) {
+    topN = true;
+    runs = 0;
+    skipped = 0;
+    if (keep == 0) {
+        return {};
+    }
+    std::vector<Segment> segments;
+    for (size_t first = 0; first < rowCount; first += ColumnData::ZONE_ROWS) {
+        Segment segment{first, std::min(ColumnData::ZONE_ROWS, rowCount - first), {}, false};
+        segment.bounded = zoneBound(first / ColumnData::ZONE_ROWS, segment.bound);
+        segments.push_back(segment);
+    }
+    return topSegments(segments, keep, selectRows);
+}
+
+std::vector<uint32_t> RowSorter::topSegments(std::vector<Segment> &segments, size_t keep,
+                                             const SegmentRows &rowsOf) {
+    topN = true;
+    // Najpierw odcinki bez ograniczenia i o najlepszym ograniczeniu - kopce szybko dostają dobre wpisy,
+    // więc dla "najnowszych N" większość bloków jest pomijana bez czytania wierszy
+    std::stable_sort(segments.begin(), segments.end(), [](const Segment &a, const Segment &b) {
+        if (a.bounded != b.bounded) {
+            return !a.bounded;
+        }
+        return a.bounded && headBefore(a.bound, b.bound);
+    });
+
+    ThreadPool &pool = ThreadPool::shared();
+    auto before = [this](const Entry &a, const Entry &b) { return less(a, b); };
+    unsigned lanes = pool.concurrency();
+    std::vector<std::vector<Entry>> heaps(lanes);
+    std::vector<std::vector<uint32_t>> selected(lanes);
+    std::atomic<size_t> skippedSegments{0};
+    pool.parallelFor(segments.size(), [&](size_t index, unsigned lane) {
+        const Segment &segment = segments[index];
+        std::vector<Entry> &heap = heaps[lane];
+        if (segment.bounded && heap.size() == keep && headBefore(heap.front(), segment.bound)) {
+            skippedSegments.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::vector<uint32_t> &rows = selected[lane];
+        rows.clear();
+        rowsOf(segment.first, segment.count, rows);
+        if (rows.empty()) {
+            return;
+        }
+        PageGuard pages;
+        pinScanMorsel(columns, rows.front(), rows.back() + size_t(1) - rows.front(), rows.front(), pages);
+        // Kopiec maksimum: na szczycie najgorszy z keep najlepszych wpisów wątku
+        for (uint32_t row : rows) {
+            Entry entry = makeEntry(row);
+            if (heap.size() < keep) {
+                heap.push_back(entry);
+                std::push_heap(heap.begin(), heap.end(), before);
+            } else if (less(entry, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), before);
+                heap.back() = entry;
+                std::push_heap(heap.begin(), heap.end(), before);
+            }
+        }
+    });
+    skipped = skippedSegments;
+
+    std::vector<Entry> best;
+    for (const auto &heap : heaps) {
+        best.insert(best.end(), heap.begin(), heap.end());
+    }
+    std::sort(best.begin(), best.end(), before);
+    best.resize(std::min(best.size(), keep));
+    std::vector<uint32_t> rows(best.size());
+    for (size_t i = 0; i < best.size(); ++i) {
+        rows[i] = best[i].row;
+    }
+    return rows;
+}
+
+bool RowSorter::sortSpilled(std::vector<uint32_t> &rows, size_t keep, size_t runEntries) {
+    SpillFiles files(options.spillDirectory, "sort");
+
+    // Serie po runEntries wierszy sortowane w pamięci; z każdej do wyniku może trafić najwyżej keep wpisów
+    std::vector<size_t> runSizes;
+    for (size_t first = 0; first < rows.size(); first += runEntries) {
+        std::vector<Entry> entries = makeEntries(rows.data() + first, std::min(runEntries, rows.size() - first));
+        sortEntries(entries);
+        size_t count = std::min(entries.size(), keep);
+        const auto &path = files.add(std::to_string(runSizes.size()));
+        std::ofstream output(path, std::ios::binary | std::ios::trunc);
+        if (!output.write(reinterpret_cast<const char *>(entries.data()),
+                          static_cast<std::streamsize>(count * sizeof(Entry))) || !output.flush()) {
+            errorStream() << "Failed to write sort spill file " << path.string() << "." << std::endl;
+            return false;
+        }
+        runSizes.push_back(count);
+    }
+    runs = runSizes.size();
+
+    // Scalanie k-drogowe: z każdej serii bufor wpisów (razem około runEntries), kopiec numerów serii
+    // według bieżącego wpisu serii
+    struct RunReader {
+        std::ifstream input;
+        std::vector<Entry> buffer;
+        size_t position = 0;
+        size_t remaining = 0;
+    };
+    size_t batch = std::max<size_t>(runEntries / runs, 1024);
+    std::vector<RunReader> readers(runs);
+    auto refill = [batch](RunReader &reader) {
+        reader.buffer.resize(std::min(batch, reader.remaining));
+        reader.position = 0;
+        reader.remaining -= reader.buffer.size();
+        return static_cast<bool>(reader.input.read(reinterpret_cast<char *>(reader.buffer.data()),
+                                                   static_cast<std::streamsize>(reader.buffer.size() * sizeof(Entry))));
+    };
+    auto failed = [](const std::filesystem::path &path) {
+        errorStream() << "Failed to read sort spill file " << path.string() << "." << std::endl;
+        return false;
+    };
+    std::vector<size_t> heap;
+    for (size_t run = 0; run < runs; ++run) {
+        readers[run].input.open(files.paths()[run], std::ios::binary);
+        readers[run].remaining = runSizes[run];
+        if (!readers[run].input || !refill(readers[run])) {
+            return failed(files.paths()[run]);
+        }
+        if (!readers[run].buffer.empty()) {
+            heap.push_back(run);
+        }
+    }
+    auto after = [&](size_t a, size_t b) {
+        return less(readers[b].buffer[readers[b].position], readers[a].buffer[readers[a].position]);
+    };
+    std::make_heap(heap.begin(), heap.end(), after);
+    std::vector<uint32_t> sorted;
+    sorted.reserve(keep);
+    while (!heap.empty() && sorted.size() < keep) {
+        std::pop_heap(heap.begin(), heap.end(), after);
+        RunReader &reader = readers[heap.back()];
+        sorted.push_back(reader.buffer[reader.position++].row);
+        if (reader.position == reader.buffer.size()) {
+            if (reader.remaining == 0) {
+                heap.pop_back();
+                continue;
+            }
+            if (!refill(reader)) {
+                return failed(files.paths()[heap.back()]);
+            }
+        }
+        std::push_heap(heap.begin(), heap.end(), after);
+    }
+    rows.swap(sorted);
+    return true;
+}
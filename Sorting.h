@@ -0,0 +1,107 @@
+#ifndef DATABASE_SORTING_H
+#define DATABASE_SORTING_H
+
+#include "PreRequistion.h"
+#include "ColumnStore.h"
+#include <functional>
+#include <limits>
+
+// Parametry sortowania ORDER BY
+struct SortOptions {
+    size_t memoryBudget = size_t(256) << 20; // wpisy sortowania ponad budżet sortowane seriami przez pliki tymczasowe
+    std::string spillDirectory;              // pusty = katalog tymczasowy systemu
+};
+
+// Klucz sortowania: kolumna (tabeli albo wyniku) i kierunek
+struct SortKey {
+    const ColumnData *column = nullptr;
+    bool descending = false;
+};
+
+// Porządek wierszy według kluczy ORDER BY. NULL jest większy od każdej wartości (na końcu przy ASC,
+// na początku przy DESC), NaN większe od liczb; wiersze o równych kluczach zostają w kolejności numerów.
+//
+// Każdy wiersz dostaje wpis z 8-bajtowym prefiksem pierwszego klucza porównywanym jako liczba bez znaku:
+// INT i FLOAT z bitami przestawionymi tak, że porządek liczb bez znaku jest porządkiem wartości,
+// STRING - pierwsze 8 bajtów big-endian (posortowany słownik - sam kod). Pełne wartości porównywane są
+// dopiero przy równych prefiksach.
+//   - z limitem (top-N): każdy wątek trzyma kopiec keep najlepszych wpisów; bloki zone map czytane są
+//     od najbardziej obiecujących, a bloki, które nie mogą pobić najgorszego wpisu kopca, są pomijane
+//   - bez limitu: morsele sortowane równolegle i scalane parami (duże scalenia dzielone między wątki);
+//     wpisy ponad budżet pamięci sortowane są seriami zapisywanymi do plików i scalane z dysku
+class RowSorter {
+public:
+    static constexpr size_t ALL_ROWS = std::numeric_limits<size_t>::max();
+
+    RowSorter(std::vector<SortKey> sortKeys, const SortOptions &options);
+
+    // Sortuje numery wierszy (rosnące, np. z QueryPlanner::matchingRows) i zostawia keep pierwszych;
+    // false (z komunikatem) przy błędzie plików tymczasowych
+    bool sort(std::vector<uint32_t> &rows, size_t keep = ALL_ROWS);
+
+    // Wiersze morsela tabeli [first, first + count) spełniające warunek, dopisywane rosnąco do rows
+    using SegmentRows = std::function<void(size_t first, size_t count, std::vector<uint32_t> &rows)>;
+
+    // Top-N wprost nad skanem tabeli o rowCount wierszach, bez listy wszystkich pasujących wierszy:
+    // bloki zone map czytane są od najbardziej obiecujących, a te, które nie mogą pobić najgorszego
+    // wpisu kopca, nie są nawet filtrowane. Zwraca keep pierwszych wierszy w kolejności sortowania.
+    std::vector<uint32_t> topScan(size_t rowCount, size_t keep, const SegmentRows &selectRows);
+
+    // Statystyki ostatniego sort albo topScan
+    bool usedTopN() const { return topN; }
+
+    size_t spilledRuns() const { return runs; }
+
+    size_t skippedBlocks() const { return skipped; }
+
+    // Top-N, gdy keep nie przekracza tej części wierszy; większy limit - pełne sortowanie i obcięcie
+    static constexpr size_t TOP_N_FRACTION = 8;
+
+    static bool prefersTopN(size_t keep, size_t rowCount) { return keep <= rowCount / TOP_N_FRACTION; }
+
+    struct Entry {
+        uint64_t prefix; // znormalizowany początek pierwszego klucza (dla DESC zanegowany)
+        uint32_t row;
+        uint32_t rank;   // 1 dla wierszy za wszystkimi wartościami (NULL przy ASC, nie-NULL przy DESC)
+    };
+
+private:
+    // Odcinek wierszy do top-N; bound - najlepszy możliwy wpis odcinka (z zone map), jeśli bounded
+    struct Segment {
+        size_t first;
+        size_t count;
+        Entry bound;
+        bool bounded;
+    };
+
+    Entry makeEntry(uint32_t row) const;
+
+    // Najlepszy możliwy wpis bloku zone map pierwszego klucza; false, gdy bloku nie da się ograniczyć
+    bool zoneBound(size_t zone, Entry &bound) const;
+
+    bool less(const Entry &a, const Entry &b) const;
+
+    // Pełne porównanie wartości klucza dwóch wierszy (<0, 0, >0) z uwzględnieniem kierunku
+    int compareKey(const SortKey &key, uint32_t a, uint32_t b) const;
+
+    std::vector<Entry> makeEntries(const uint32_t *rows, size_t count) const;
+
+    void sortEntries(std::vector<Entry> &entries) const;
+
+    void sortTopN(std::vector<uint32_t> &rows, size_t keep);
+
+    // Kopce keep najlepszych wpisów na wątek nad odcinkami, od najlepszego ograniczenia; scalone i posortowane
+    std::vector<uint32_t> topSegments(std::vector<Segment> &segments, size_t keep, const SegmentRows &rowsOf);
+
+    bool sortSpilled(std::vector<uint32_t> &rows, size_t keep, size_t runEntries);
+
+    std::vector<SortKey> keys;
+    std::vector<const ColumnData *> columns; // kolumny kluczy bez powtórzeń - do przypinania stron
+    const SortOptions &options;
+    bool exactPrefix = false; // prefiks wyznacza całą wartość pierwszego klucza
+    bool topN = false;
+    size_t runs = 0;
+    size_t skipped = 0;
+};
+
+#endif //DATABASE_SORTING_H
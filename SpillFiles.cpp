@@ -0,0 +1,20 @@
+#include "SpillFiles.h"
+#include <atomic>
+#include <random>
+
+SpillFiles::SpillFiles(const std::string &directory, const std::string &kind)
+        : directory(directory.empty() ? std::filesystem::temp_directory_path() : std::filesystem::path(directory)) {
+    static std::atomic<uint64_t> spillCounter{0};
+    prefix = kind + "-" + std::to_string(std::random_device{}()) + "-" + std::to_string(spillCounter++);
+}
+
+SpillFiles::~SpillFiles() {
+    for (const auto &path : files) {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+}
+
+const std::filesystem::path &SpillFiles::add(const std::string &name) {
+    return files.emplace_back(directory / (prefix + "-" + name));
+}
@@ -0,0 +1,32 @@
+#ifndef DATABASE_SPILLFILES_H
+#define DATABASE_SPILLFILES_H
+
+#include "PreRequistion.h"
+#include <filesystem>
+
+// Pliki tymczasowe jednej operacji, która nie mieści się w budżecie pamięci (partycje złączenia, serie
+// sortowania). Nazwy <kind>-<losowa liczba>-<licznik>-<name> nie zderzają się między operacjami ani
+// procesami; pliki usuwane w destruktorze, więc także przy przerwaniu operacji błędem.
+class SpillFiles {
+public:
+    // directory pusty = katalog tymczasowy systemu
+    SpillFiles(const std::string &directory, const std::string &kind);
+
+    ~SpillFiles();
+
+    SpillFiles(const SpillFiles &) = delete;
+
+    SpillFiles &operator=(const SpillFiles &) = delete;
+
+    // Ścieżka kolejnego pliku (pliku jeszcze nie tworzy)
+    const std::filesystem::path &add(const std::string &name);
+
+    const std::vector<std::filesystem::path> &paths() const { return files; }
+
+private:
+    std::filesystem::path directory;
+    std::string prefix;
+    std::vector<std::filesystem::path> files;
+};
+
+#endif //DATABASE_SPILLFILES_H
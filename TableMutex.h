@@ -0,0 +1,149 @@
+#ifndef DATABASE_TABLEMUTEX_H
+#define DATABASE_TABLEMUTEX_H
+
+#include "PreRequistion.h"
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+// Blokada czytelnicy-piszący tabeli (interfejs SharedMutex - działa z std::shared_lock i std::unique_lock).
+// std::shared_mutex z glibc przepuszcza nowych czytelników przed czekającym piszącym, więc ciągłe odczyty
+// głodzą zapisy. Tu nowy czytelnik czeka, gdy czeka piszący. Po zwolnieniu blokady przez piszącego
+// czytelnicy czekający wcześniej mogą wejść mimo kolejki piszących, ale ścigają się z kolejnym piszącym:
+// przegrany czeka do następnego zwolnienia. Nie ma więc gwarancji kolejności, tylko szansa przy każdym
+// zwolnieniu - zapisy jedna po drugiej nie czekają na pełne skany. Blokada nie jest rekurencyjna
+// także dla czytelników.
+class TableMutex {
+public:
+    void lock() {
+        std::unique_lock<std::mutex> guard(state);
+        ++waitingWriters;
+        writerTurn.wait(guard, [this] { return !writer && readers == 0; });
+        --waitingWriters;
+        writer = true;
+    }
+
+    bool try_lock() {
+        std::lock_guard<std::mutex> guard(state);
+        if (writer || readers != 0) {
+            return false;
+        }
+        writer = true;
+        return true;
+    }
+
+    void unlock() {
+        {
+            std::lock_guard<std::mutex> guard(state);
+            writer = false;
+            ++releases;
+        }
+        readerTurn.notify_all();
+        writerTurn.notify_one();
+    }
+
+    void lock_shared() {
+        enterShared(false);
+    }
+
+    bool try_lock_shared() {
+        std::lock_guard<std::mutex> guard(state);
+        if (writer || upgrading || waitingWriters != 0) {
+            return false;
+        }
+        ++readers;
+        return true;
+    }
+
+    void unlock_shared() {
+        std::lock_guard<std::mutex> guard(state);
+        leaveShared();
+    }
+
+    // Blokada współdzielona, którą można potem zamienić na wyłączną (unlock_upgrade_and_lock). Naraz trzyma
+    // ją jeden wątek - kolejny czeka (zwykli czytelnicy nie), więc dwie zamiany nie czekają na siebie nawzajem
+    void lock_upgrade() {
+        enterShared(true);
+    }
+
+    void unlock_upgrade() {
+        {
+            std::lock_guard<std::mutex> guard(state);
+            upgrader = false;
+            leaveShared();
+        }
+        readerTurn.notify_all();
+    }
+
+    // Zamiana blokady z lock_upgrade na wyłączną bez zwalniania - żaden zapis nie wejdzie pomiędzy.
+    // Nowi czytelnicy czekają od razu, zamiana czeka na wyjście pozostałych
+    void unlock_upgrade_and_lock() {
+        std::unique_lock<std::mutex> guard(state);
+        upgrading = true;
+        writerTurn.wait(guard, [this] { return readers == 1; });
+        upgrading = false;
+        upgrader = false;
+        readers = 0;
+        writer = true;
+    }
+
+private:
+    void enterShared(bool upgrade) {
+        std::unique_lock<std::mutex> guard(state);
+        uint64_t arrival = releases;
+        readerTurn.wait(guard, [this, arrival, upgrade] {
+            return !writer && !upgrading && !(upgrade && upgrader) && (waitingWriters == 0 || arrival != releases);
+        });
+        ++readers;
+        upgrader = upgrader || upgrade;
+    }
+
+    // Wywoływane pod state
+    void leaveShared() {
+        --readers;
+        if ((readers == 0 && waitingWriters != 0) || (readers == 1 && upgrading)) {
+            writerTurn.notify_all();
+        }
+    }
+
+    std::mutex state;
+    std::condition_variable readerTurn;
+    std::condition_variable writerTurn;
+    size_t readers = 0;
+    size_t waitingWriters = 0;
+    bool writer = false;
+    bool upgrader = false; // ktoś trzyma lock_upgrade
+    bool upgrading = false;
+    uint64_t releases = 0; // zwolnienia przez piszących - czytelnik czekający przed zwolnieniem może wejść mimo kolejki
+};
+
+// Blokada TableMutex::lock_upgrade zwalniana w destruktorze (odpowiednik std::shared_lock)
+class UpgradeLock {
+public:
+    explicit UpgradeLock(TableMutex &mutex) : mutex(&mutex) {
+        mutex.lock_upgrade();
+    }
+
+    UpgradeLock(UpgradeLock &&other) noexcept : mutex(std::exchange(other.mutex, nullptr)) {}
+
+    UpgradeLock(const UpgradeLock &) = delete;
+    UpgradeLock &operator=(const UpgradeLock &) = delete;
+
+    ~UpgradeLock() {
+        if (mutex) {
+            mutex->unlock_upgrade();
+        }
+    }
+
+    // Zamiana na blokadę wyłączną; od tej chwili zwalnia ją zwrócony std::unique_lock
+    std::unique_lock<TableMutex> upgrade() {
+        TableMutex *held = std::exchange(mutex, nullptr);
+        held->unlock_upgrade_and_lock();
+        return std::unique_lock<TableMutex>(*held, std::adopt_lock);
+    }
+
+private:
+    TableMutex *mutex;
+};
+
+#endif //DATABASE_TABLEMUTEX_H
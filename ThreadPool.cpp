@@ -0,0 +1,158 @@
+#include "ThreadPool.h"
+#include "ColumnStore.h"
+#include <cstdlib>
+
+namespace {
+    // Pula i numer kolejki bieżącego wątku roboczego (nullptr dla wątków spoza puli)
+    thread_local const ThreadPool *currentPool = nullptr;
+    thread_local unsigned currentQueue = 0;
+
+    // Stan jednego parallelFor, współdzielony z zadaniami pomocniczymi, które mogą
+    // wystartować już po powrocie wywołującego
+    struct ParallelForState {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::atomic<unsigned> lanes{0};
+        size_t count = 0;
+        const std::function<void(size_t, unsigned)> *task = nullptr;
+        std::mutex mutex;
+        std::condition_variable finished;
+
+        // Pobiera kolejne indeksy, dopóki są; task jest używany tylko po udanym pobraniu,
+        // a wywołujący czeka na wszystkie pobrane indeksy, więc wskaźnik jest wtedy ważny
+        void run() {
+            size_t index = next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= count) {
+                return;
+            }
+            unsigned lane = lanes.fetch_add(1, std::memory_order_relaxed);
+            do {
+                (*task)(index, lane);
+                if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished.notify_all();
+                }
+                index = next.fetch_add(1, std::memory_order_relaxed);
+            } while (index < count);
+        }
+    };
+}
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i + 1 < threadCount; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned i = 0; i + 1 < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool &ThreadPool::shared() {
+    static ThreadPool pool([] {
+        const char *configured = std::getenv("DATABASE_THREADS");
+        int64_t threads = 0;
+        if (configured != nullptr && parseIntValue(configured, threads) && threads > 0) {
+            return static_cast<unsigned>(threads);
+        }
+        return 0u;
+    }());
+    return pool;
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+    if (workers.empty()) {
+        job();
+        return;
+    }
+    unsigned target = currentPool == this ? currentQueue
+                                          : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->jobs.push_back(std::move(job));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    wakeUp.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, unsigned)> &task) {
+    if (count == 0) {
+        return;
+    }
+    auto state = std::make_shared<ParallelForState>();
+    state->count = count;
+    state->task = &task;
+
+    // Pomocnicy dla pozostałych wątków; ci, którzy nie zdążą pobrać indeksu, kończą od razu
+    size_t helpers = std::min<size_t>(workers.size(), count - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        submit([state] { state->run(); });
+    }
+    state->run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&state] { return state->done.load(std::memory_order_acquire) == state->count; });
+}
+
+void ThreadPool::forEachMorsel(size_t rowCount,
+                               const std::function<void(size_t, size_t, size_t, unsigned)> &task) {
+    parallelFor(morselCount(rowCount), [&](size_t morsel, unsigned lane) {
+        size_t firstRow = morsel * MORSEL_ROWS;
+        task(morsel, firstRow, std::min(MORSEL_ROWS, rowCount - firstRow), lane);
+    });
+}
+
+bool ThreadPool::popJob(unsigned id, std::function<void()> &job) {
+    // Najpierw własna kolejka (od końca - najświeższe zadania), potem podkradanie od początku
+    for (size_t attempt = 0; attempt < queues.size(); ++attempt) {
+        WorkerQueue &queue = *queues[(id + attempt) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) {
+            continue;
+        }
+        if (attempt == 0) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        } else {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned id) {
+    currentPool = this;
+    currentQueue = id;
+    std::function<void()> job;
+    while (true) {
+        if (popJob(id, job)) {
+            pending.fetch_sub(1, std::memory_order_relaxed);
+            job();
+            job = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this] { return stopping || pending.load(std::memory_order_relaxed) > 0; });
+        if (stopping && pending.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef DATABASE_THREADPOOL_H
+#define DATABASE_THREADPOOL_H
+
+#include "PreRequistion.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Wspólna pula wątków z podkradaniem zadań. Każdy wątek ma własną kolejkę: bierze zadania
+// z jej końca, a gdy jest pusta, podkrada z początku kolejek pozostałych wątków.
+// Praca dzielona jest na morsele - kolejne fragmenty pobierane przez wątki z licznika
+// atomowego, więc szybsze wątki same przejmują więcej fragmentów.
+class ThreadPool {
+public:
+    // Liczba wierszy w jednym morselu skanu; wielokrotność 64, więc morsel to całe słowa bitmapy wyboru
+    static constexpr size_t MORSEL_ROWS = 64 * 1024;
+
+    // threadCount = liczba wątków biorących udział w pracy razem z wywołującym (0 = liczba rdzeni)
+    explicit ThreadPool(unsigned threadCount = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Pula współdzielona przez skany, import, budowę indeksów i migawki.
+    // Rozmiar: zmienna środowiskowa DATABASE_THREADS albo liczba rdzeni.
+    static ThreadPool &shared();
+
+    // Maksymalna liczba wątków wykonujących jedno parallelFor
+    unsigned concurrency() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    static size_t morselCount(size_t rowCount) { return (rowCount + MORSEL_ROWS - 1) / MORSEL_ROWS; }
+
+    // Wywołuje task(index, lane) dla każdego index z [0, count) i czeka na zakończenie.
+    // lane < concurrency() jest stały dla wątku w obrębie jednego wywołania (np. numer
+    // częściowego agregatu). Wywołujący też wykonuje zadania, więc wywołania mogą być zagnieżdżone.
+    void parallelFor(size_t count, const std::function<void(size_t index, unsigned lane)> &task);
+
+    // Podział [0, rowCount) na morsele MORSEL_ROWS wierszy: task(morsel, firstRow, count, lane)
+    void forEachMorsel(size_t rowCount,
+                       const std::function<void(size_t morsel, size_t firstRow, size_t count, unsigned lane)> &task);
+
+    // Zadanie w tle, bez czekania na wynik
+    void submit(std::function<void()> job);
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    void workerLoop(unsigned id);
+
+    bool popJob(unsigned id, std::function<void()> &job);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::atomic<size_t> pending{0};
+    std::atomic<unsigned> nextQueue{0};
+    bool stopping = false;
+};
+
+#endif //DATABASE_THREADPOOL_H
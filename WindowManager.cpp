@@ -1,6 +1,26 @@
 #include "WindowManager.h"
 #include "PreRequistion.h"
 
+namespace {
+    // Wiersze first od numeru from, a po nich wszystkie wiersze second (te same kolumny)
+    ResultSet joinRows(const ResultSet& first, size_t from, const ResultSet& second) {
+        ResultSet joined;
+        joined.columnNames = second.columnNames;
+        std::vector<uint32_t> rows;
+        for (size_t row = from; row < first.rowCount(); ++row) {
+            rows.push_back(static_cast<uint32_t>(row));
+        }
+        for (size_t i = 0; i < second.columns.size(); ++i) {
+            joined.columns.emplace_back(second.columns[i].getType());
+            if (i < first.columns.size()) {
+                joined.columns.back().appendRows(first.columns[i], rows.data(), rows.size());
+            }
+            joined.columns.back().appendColumn(second.columns[i]);
+        }
+        return joined;
+    }
+}
+
 
 WindowManager::WindowManager() : window(sf::VideoMode(1200, 400), "Database") {
     if (!font.loadFromFile("..\\Font\\Montserrat-Italic-VariableFont_wght.ttf")) {
@@ -36,6 +56,35 @@ void WindowManager::handleEvents(Database& myDatabase) {
             window.close();
         }
 
+        if (resultCursor && event.type == sf::Event::MouseWheelScrolled) {
+            // Kółko: trzy wiersze na ząbek
+            auto rows = static_cast<size_t>(3 * std::abs(event.mouseWheelScroll.delta));
+            scrollTo(myDatabase, event.mouseWheelScroll.delta > 0 ? firstVisibleRow - std::min(rows, firstVisibleRow)
+                                                                  : firstVisibleRow + rows);
+        }
+
+        if (resultCursor && event.type == sf::Event::KeyPressed) {
+            switch (event.key.code) {
+                case sf::Keyboard::Up:
+                    scrollTo(myDatabase, firstVisibleRow - std::min<size_t>(1, firstVisibleRow));
+                    break;
+                case sf::Keyboard::Down:
+                    scrollTo(myDatabase, firstVisibleRow + 1);
+                    break;
+                case sf::Keyboard::PageUp:
+                    scrollTo(myDatabase, firstVisibleRow - std::min(VISIBLE_ROWS, firstVisibleRow));
+                    break;
+                case sf::Keyboard::PageDown:
+                    scrollTo(myDatabase, firstVisibleRow + VISIBLE_ROWS);
+                    break;
+                case sf::Keyboard::Home:
+                    scrollTo(myDatabase, 0);
+                    break;
+                default:
+                    break;
+            }
+        }
+
         if (event.type == sf::Event::TextEntered) {
 
 
@@ -45,17 +94,15 @@ void WindowManager::handleEvents(Database& myDatabase) {
                     window.close();
                 } else {
                     try {
-                        if (currentOperation.empty()) {
+                        if (currentOperation.empty() && DBQLLexer(userInput).next().is("SELECT")) {
+                            openResult(myDatabase, userInput);
+                        } else if (currentOperation.empty()) {
                             // Jeśli brak bieżącej operacji, to traktujemy wejście użytkownika jako zapytanie
-                            std::streambuf *coutbuf = std::cout.rdbuf();
-                            std::cout.rdbuf(oss.rdbuf());
-
-                            myDatabase.executeQuery(userInput);
-
-                            std::cout.rdbuf(coutbuf);
+                            closeResult();
+                            ResultSet result = myDatabase.execute(userInput);
 
-                            outputText.setString(oss.str());
-                            oss.str("");
+                            outputText.setString(result.format());
+                            showError(result.error);
                         } else if (currentOperation == "create table") {
                             // Przykładowa obsługa tworzenia tabeli z nazwą podaną przez użytkownika
                             myDatabase.createTable(currentTableName);
@@ -102,6 +149,60 @@ void WindowManager::handleEvents(Database& myDatabase) {
     }
 }
 
+void WindowManager::openResult(Database& myDatabase, const std::string& query) {
+    closeResult();
+    resultQuery = query;
+    scrollTo(myDatabase, 0);
+}
+
+void WindowManager::closeResult() {
+    // Zamknięty kursor nie wstrzymuje już kompakcji tabeli
+    resultCursor.reset();
+    resultQuery.clear();
+    resultWindow = ResultSet();
+    windowStart = 0;
+    firstVisibleRow = 0;
+}
+
+void WindowManager::scrollTo(Database& myDatabase, size_t firstRow) {
+    if (!resultCursor || firstRow < windowStart) {
+        resultCursor = myDatabase.openCursor(resultQuery);
+        resultCursor->skip(firstRow);
+        windowStart = resultCursor->position();
+        resultWindow = resultCursor->next(FETCH_ROWS);
+    }
+    if (firstRow > windowStart + resultWindow.rowCount()) {
+        // Skok za wczytane okno: wiersze pomiędzy są tylko pomijane
+        resultCursor->skip(firstRow - resultCursor->position());
+        windowStart = resultCursor->position();
+        resultWindow = ResultSet();
+    }
+    while (firstRow + VISIBLE_ROWS > windowStart + resultWindow.rowCount() && !resultCursor->done()) {
+        ResultSet batch = resultCursor->next(FETCH_ROWS);
+        if (batch.columns.empty()) {
+            break;
+        }
+        // Okno przesuwa się do przodu: zostają wiersze od firstRow, dochodzi nowa porcja
+        size_t keepFrom = std::min(firstRow - windowStart, resultWindow.rowCount());
+        resultWindow = joinRows(resultWindow, keepFrom, batch);
+        windowStart += keepFrom;
+    }
+
+    // Za końcem wyniku zostaje ostatnia pełna strona
+    size_t available = windowStart + resultWindow.rowCount();
+    firstVisibleRow = std::max(windowStart, std::min(firstRow, available > VISIBLE_ROWS ? available - VISIBLE_ROWS : 0));
+    std::string page;
+    for (size_t row = firstVisibleRow; row < std::min(available, firstVisibleRow + VISIBLE_ROWS); ++row) {
+        for (const auto& column : resultWindow.columns) {
+            page += column.getAsString(row - windowStart);
+            page += ' ';
+        }
+        page += '\n';
+    }
+    outputText.setString(page);
+    showError(resultCursor->getError());
+}
+
 void WindowManager::renderWindow() {
     window.clear();
     window.draw(welcomeText);
@@ -5,19 +5,34 @@
 #ifndef DATABASE_WINDOWMANAGER_H
 #define DATABASE_WINDOWMANAGER_H
 #include "PreRequistion.h"
+#include <SFML/Graphics.hpp>
 #include "Database.h"
+#include "ResultCursor.h"
 class WindowManager {
 private:
     sf::RenderWindow window;
     sf::Font font;
     sf::Text inputText;
     sf::Text outputText;
-    std::ostringstream oss;
     sf::Text errorText;
     std::string currentOperation;
     sf::Text welcomeText;
     std::string currentTableName;
     sf::RectangleShape cursorRect;
+
+    // Wynik SELECT wyświetlany stronami: z kursora czytane jest tylko okno wierszy wokół
+    // widocznej strony, przewijanie dociąga kolejne porcje (wstecz - zapytanie od nowa z pominięciem)
+    static constexpr size_t VISIBLE_ROWS = 12;
+    static constexpr size_t FETCH_ROWS = 4 * VISIBLE_ROWS;
+    std::string resultQuery;
+    std::unique_ptr<ResultCursor> resultCursor;
+    ResultSet resultWindow;     // wiersze [windowStart, windowStart + resultWindow.rowCount()) wyniku
+    size_t windowStart = 0;
+    size_t firstVisibleRow = 0;
+
+    void openResult(Database& myDatabase, const std::string& query);
+    void scrollTo(Database& myDatabase, size_t firstRow);
+    void closeResult();
 public:
     WindowManager();
     void handleEvents(Database& myDatabase);
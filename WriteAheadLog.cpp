@@ -0,0 +1,357 @@
+#include "WriteAheadLog.h"
+#include "Diagnostics.h"
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char WAL_MAGIC[8] = {'D', 'B', 'W', 'A', 'L', '\0', '\0', '\0'};
+    const uint32_t WAL_VERSION = 2;
+    const size_t WAL_HEADER_SIZE = sizeof(WAL_MAGIC) + 2 * sizeof(uint32_t);
+    const size_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t) + sizeof(uint64_t);
+    // Po przekroczeniu tego rozmiaru bufor jest zapisywany bez czekania na koniec okna
+    const size_t MAX_BATCH_BYTES = 4 << 20;
+
+    uint32_t crc32(const char *data, size_t size, uint32_t crc = 0) {
+        static const auto table = [] {
+            std::vector<uint32_t> entries(256);
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+                }
+                entries[i] = value;
+            }
+            return entries;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i) {
+            crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    template<typename T>
+    void put(std::string &out, T value) {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void putString(std::string &out, const std::string &value) {
+        put(out, static_cast<uint32_t>(value.size()));
+        out += value;
+    }
+
+    class PayloadReader {
+    public:
+        explicit PayloadReader(const std::string &payload) : data(payload) {}
+
+        template<typename T>
+        bool get(T &value) {
+            if (position + sizeof(T) > data.size()) {
+                return false;
+            }
+            std::memcpy(&value, data.data() + position, sizeof(T));
+            position += sizeof(T);
+            return true;
+        }
+
+        bool getString(std::string &value) {
+            uint32_t length;
+            if (!get(length) || position + length > data.size()) {
+                return false;
+            }
+            value.assign(data, position, length);
+            position += length;
+            return true;
+        }
+
+    private:
+        const std::string &data;
+        size_t position = 0;
+    };
+
+    std::string encodePayload(const WalRecord &record) {
+        std::string payload;
+        put(payload, static_cast<uint8_t>(record.op));
+        putString(payload, record.tableName);
+        put(payload, static_cast<uint32_t>(record.args.size()));
+        for (const auto &arg : record.args) {
+            putString(payload, arg);
+        }
+        put(payload, static_cast<uint32_t>(record.values.size()));
+        for (const auto &value : record.values) {
+            putString(payload, value.first);
+            putString(payload, value.second);
+        }
+        putString(payload, record.payload);
+        return payload;
+    }
+
+    bool decodePayload(const std::string &payload, WalRecord &record) {
+        PayloadReader reader(payload);
+        uint8_t op;
+        uint32_t count;
+        if (!reader.get(op) || !reader.getString(record.tableName) || !reader.get(count)) {
+            return false;
+        }
+        record.op = static_cast<WalOp>(op);
+        record.args.resize(count);
+        for (auto &arg : record.args) {
+            if (!reader.getString(arg)) {
+                return false;
+            }
+        }
+        if (!reader.get(count)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            std::string key, value;
+            if (!reader.getString(key) || !reader.getString(value)) {
+                return false;
+            }
+            record.values.emplace(std::move(key), std::move(value));
+        }
+        return reader.getString(record.payload);
+    }
+
+    int openForAppend(const std::string &fileName) {
+#ifdef _WIN32
+        return _open(fileName.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        return ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+#endif
+    }
+
+    bool writeFully(int fd, const char *data, size_t size) {
+        while (size > 0) {
+#ifdef _WIN32
+            int written = _write(fd, data, static_cast<unsigned>(std::min<size_t>(size, 1 << 30)));
+#else
+            ssize_t written = ::write(fd, data, size);
+#endif
+            if (written <= 0) {
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    bool syncFile(int fd) {
+#ifdef _WIN32
+        return _commit(fd) == 0;
+#elif defined(__APPLE__)
+        return fsync(fd) == 0;
+#else
+        return fdatasync(fd) == 0;
+#endif
+    }
+
+    void closeFile(int fd) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+    }
+}
+
+WriteAheadLog::WriteAheadLog(std::chrono::microseconds window) : commitWindow(window) {
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    close();
+}
+
+bool WriteAheadLog::open(const std::string &fileName, uint64_t lastLsn) {
+    close();
+    bool exists = std::filesystem::exists(fileName) && std::filesystem::file_size(fileName) >= WAL_HEADER_SIZE;
+    fd = openForAppend(fileName);
+    if (fd < 0) {
+        errorStream() << "Failed to open file: " << fileName << std::endl;
+        return false;
+    }
+    if (!exists) {
+        std::string header(WAL_MAGIC, sizeof(WAL_MAGIC));
+        put(header, WAL_VERSION);
+        put(header, uint32_t(0));
+        if (!writeFully(fd, header.data(), header.size()) || !syncFile(fd)) {
+            errorStream() << "Failed to write file: " << fileName << std::endl;
+            closeFile(fd);
+            fd = -1;
+            return false;
+        }
+    }
+    path = fileName;
+    appendedLsn = durableLsn = lastLsn;
+    stopping = failed = false;
+    flusher = std::thread(&WriteAheadLog::flushLoop, this);
+    return true;
+}
+
+void WriteAheadLog::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    if (flusher.joinable()) {
+        flusher.join();
+    }
+    if (fd >= 0) {
+        closeFile(fd);
+        fd = -1;
+    }
+}
+
+bool WriteAheadLog::replay(const std::string &fileName, uint64_t afterLsn,
+                           const std::function<void(const WalRecord &)> &apply, uint64_t &lastLsn) {
+    lastLsn = afterLsn;
+    std::ifstream inputFile(fileName, std::ios::binary);
+    if (!inputFile) {
+        return true; // brak dziennika - nic do odtworzenia
+    }
+    char header[WAL_HEADER_SIZE];
+    if (!inputFile.read(header, WAL_HEADER_SIZE)) {
+        return true;
+    }
+    uint32_t version;
+    std::memcpy(&version, header + sizeof(WAL_MAGIC), sizeof(version));
+    if (std::memcmp(header, WAL_MAGIC, sizeof(WAL_MAGIC)) != 0 || version != WAL_VERSION) {
+        errorStream() << "File " << fileName << " is not a supported write-ahead log." << std::endl;
+        return false;
+    }
+
+    uint64_t validEnd = WAL_HEADER_SIZE;
+    std::string payload;
+    while (true) {
+        char recordHeader[RECORD_HEADER_SIZE];
+        if (!inputFile.read(recordHeader, RECORD_HEADER_SIZE)) {
+            break;
+        }
+        uint32_t length, crc;
+        uint64_t lsn;
+        std::memcpy(&length, recordHeader, sizeof(length));
+        std::memcpy(&crc, recordHeader + 4, sizeof(crc));
+        std::memcpy(&lsn, recordHeader + 8, sizeof(lsn));
+        payload.resize(length);
+        if (!inputFile.read(payload.data(), length)
+            || crc32(payload.data(), payload.size(), crc32(recordHeader + 8, sizeof(lsn))) != crc) {
+            break;
+        }
+        WalRecord record;
+        if (!decodePayload(payload, record)) {
+            break;
+        }
+        if (lsn > afterLsn) {
+            apply(record);
+            lastLsn = lsn;
+        }
+        validEnd += RECORD_HEADER_SIZE + length;
+    }
+    inputFile.close();
+
+    // Obcięcie niedokończonego ostatniego zapisu
+    std::error_code error;
+    if (std::filesystem::file_size(fileName, error) > validEnd) {
+        errorStream() << "Discarding torn tail of write-ahead log " << fileName << "." << std::endl;
+        std::filesystem::resize_file(fileName, validEnd, error);
+    }
+    return true;
+}
+
+uint64_t WriteAheadLog::append(const WalRecord &record) {
+    std::string payload = encodePayload(record);
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t lsn = ++appendedLsn;
+    char lsnBytes[sizeof(lsn)];
+    std::memcpy(lsnBytes, &lsn, sizeof(lsn));
+    put(pending, static_cast<uint32_t>(payload.size()));
+    put(pending, crc32(payload.data(), payload.size(), crc32(lsnBytes, sizeof(lsnBytes))));
+    put(pending, lsn);
+    pending += payload;
+    workAvailable.notify_one();
+    return lsn;
+}
+
+bool WriteAheadLog::waitDurable(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mutex);
+    durable.wait(lock, [&] { return durableLsn >= lsn || failed; });
+    return durableLsn >= lsn;
+}
+
+void WriteAheadLog::truncate() {
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t target = appendedLsn;
+    durable.wait(lock, [&] { return durableLsn >= target || failed; });
+#ifdef _WIN32
+    _chsize_s(fd, WAL_HEADER_SIZE);
+#else
+    if (ftruncate(fd, WAL_HEADER_SIZE) != 0) {
+        errorStream() << "Failed to truncate file: " << path << std::endl;
+        return;
+    }
+#endif
+    syncFile(fd);
+}
+
+uint64_t WriteAheadLog::lastLsn() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return appendedLsn;
+}
+
+void WriteAheadLog::setCommitWindow(std::chrono::microseconds window) {
+    std::lock_guard<std::mutex> lock(mutex);
+    commitWindow = window;
+}
+
+uint64_t WriteAheadLog::getSyncCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return syncCount;
+}
+
+bool WriteAheadLog::writeAndSync(const std::string &batch) {
+    return writeFully(fd, batch.data(), batch.size()) && syncFile(fd);
+}
+
+void WriteAheadLog::flushLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    std::string batch;
+    while (true) {
+        workAvailable.wait(lock, [&] { return stopping || !pending.empty(); });
+        if (pending.empty()) {
+            break;
+        }
+
+        // Okno grupowania: dalsze rekordy trafią do tego samego fsync
+        if (!stopping && commitWindow.count() > 0) {
+            workAvailable.wait_for(lock, commitWindow, [&] {
+                return stopping || pending.size() >= MAX_BATCH_BYTES;
+            });
+        }
+        batch.clear();
+        batch.swap(pending);
+        uint64_t batchLsn = appendedLsn;
+
+        lock.unlock();
+        bool ok = writeAndSync(batch);
+        lock.lock();
+
+        if (ok) {
+            durableLsn = batchLsn;
+            ++syncCount;
+        } else {
+            errorStream() << "Failed to write file: " << path << std::endl;
+            failed = true;
+        }
+        durable.notify_all();
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef DATABASE_WRITEAHEADLOG_H
+#define DATABASE_WRITEAHEADLOG_H
+
+#include "PreRequistion.h"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Rodzaje operacji zapisywanych w dzienniku
+enum class WalOp : uint8_t {
+    CREATE_TABLE = 1,
+    DROP_TABLE,
+    ADD_COLUMN,
+    REMOVE_COLUMN,
+    INSERT,
+    UPDATE,
+    DELETE,
+    CREATE_INDEX,
+    DROP_INDEX,
+    INSERT_BATCH
+};
+
+// Jedno mutujące wywołanie Database: nazwa tabeli, argumenty pozycyjne, mapa wartości
+// i opcjonalne dane binarne (np. kolumny wsadu)
+struct WalRecord {
+    WalOp op = WalOp::INSERT;
+    std::string tableName;
+    std::vector<std::string> args;
+    std::map<std::string, std::string> values;
+    std::string payload;
+};
+
+// Dziennik zapisu z wyprzedzeniem (append-only, binarny).
+//
+// Plik: nagłówek, potem rekordy [długość][crc32][lsn][treść]. Rekord dopisywany jest do
+// bufora przed wykonaniem operacji; osobny wątek zapisuje bufor jednym write + fsync,
+// obejmując wszystkie rekordy zebrane od poprzedniego fsync (group commit). Niezerowe okno
+// grupowania dodatkowo czeka na kolejnych piszących przed każdym fsync.
+class WriteAheadLog {
+public:
+    explicit WriteAheadLog(std::chrono::microseconds window = std::chrono::microseconds(0));
+
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog &) = delete;
+
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+    // Otwiera (albo tworzy) plik do dopisywania; kolejne rekordy dostaną LSN > lastLsn
+    bool open(const std::string &fileName, uint64_t lastLsn);
+
+    void close();
+
+    // Odtwarza rekordy o LSN > afterLsn; uszkodzony ogon pliku (niedokończony zapis) jest obcinany
+    static bool replay(const std::string &fileName, uint64_t afterLsn,
+                       const std::function<void(const WalRecord &)> &apply, uint64_t &lastLsn);
+
+    // Dopisuje rekord do bufora i zwraca jego LSN (bez czekania na dysk)
+    uint64_t append(const WalRecord &record);
+
+    // Czeka, aż rekord o danym LSN będzie trwały; false przy błędzie zapisu
+    bool waitDurable(uint64_t lsn);
+
+    // Po checkpoincie: opróżnia dziennik (wszystko jest już w migawce)
+    void truncate();
+
+    uint64_t lastLsn();
+
+    void setCommitWindow(std::chrono::microseconds window);
+
+    uint64_t getSyncCount();
+
+private:
+    void flushLoop();
+
+    bool writeAndSync(const std::string &batch);
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable durable;
+    std::string pending;
+    uint64_t appendedLsn = 0;
+    uint64_t durableLsn = 0;
+    uint64_t syncCount = 0;
+    bool stopping = false;
+    bool failed = false;
+    std::chrono::microseconds commitWindow;
+    std::string path;
+    int fd = -1;
+    std::thread flusher;
+};
+
+#endif //DATABASE_WRITEAHEADLOG_H